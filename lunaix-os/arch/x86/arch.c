@@ -20,10 +20,10 @@ arch_preinit()
 void
 update_tss()
 {
-    extern struct x86_tss _tss;
+    volatile struct x86_tss* tss = this_cpu()->arch.tss;
 #ifdef CONFIG_ARCH_X86_64
-    _tss.rsps[0] = (ptr_t)current_thread->hstate;
+    tss->rsps[0] = (ptr_t)current_thread->hstate;
 #else
-    _tss.esp0 = (u32_t)current_thread->hstate;
+    tss->esp0 = (u32_t)current_thread->hstate;
 #endif
 }
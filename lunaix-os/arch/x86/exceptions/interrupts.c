@@ -6,6 +6,7 @@
 #include <lunaix/sched.h>
 #include <lunaix/syslog.h>
 #include <lunaix/failsafe.h>
+#include <lunaix/profiler.h>
 
 #include <hal/irq.h>
 
@@ -70,6 +71,12 @@ __handle_internal_vectors(const struct hart_state* state)
         schedule();
         break;
 
+    case LUNAIX_SCHED_TICK:
+        apic_ack_interrupt(NULL);
+        profiler_tick();
+        schedule();
+        break;
+
     case APIC_SPIV_IV:
         break;
 
@@ -103,12 +110,17 @@ __handle_external_irq(const struct hart_state* state)
 
     irq_serve(irq, state);
     apic_ack_interrupt(irq);
+
+    irq_run_deferred();
+    sched_preempt_point();
+
     return true;
 }
 
 struct hart_state*
 intr_handler(struct hart_state* state)
 {
+    kernel_lock();
     update_thread_context(state);
 
     volatile struct exec_param* execp = state->execp;
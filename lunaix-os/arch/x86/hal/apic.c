@@ -89,23 +89,24 @@ apic_setup_lvts()
     apic_write_reg(APIC_LVT_ERROR, LVT_ENTRY_ERROR(APIC_ERROR_IV));
 }
 
-static void
-apic_init()
+unsigned int
+apic_current_id()
 {
-    // ensure that external interrupt is disabled
-    cpu_disable_interrupt();
-
-    // Make sure the APIC is there
-    //  FUTURE: Use 8259 as fallback
-
-    // FIXME apic abstraction as local interrupt controller
-    // assert_msg(cpu_has_apic(), "No APIC detected!");
+    return apic_read_reg(APIC_IDR) >> 24;
+}
 
-    // As we are going to use APIC, disable the old 8259 PIC
-    pic_disable();
+void
+apic_send_ipi(unsigned int apic_id, unsigned int icr)
+{
+    apic_write_reg(APIC_ICR_HIGH, ICR_DEST(apic_id));
+    apic_write_reg(APIC_ICR_BASE, icr);
 
-    _apic_base = ioremap(__APIC_BASE_PADDR, 4096);
+    while ((apic_read_reg(APIC_ICR_BASE) & ICR_DELIVERY_PENDING));
+}
 
+static void
+apic_setup_local()
+{
     // Hardware enable the APIC
     // By setting bit 11 of IA32_APIC_BASE register
     // Note: After this point, you can't disable then re-enable it until a
@@ -146,6 +147,36 @@ apic_init()
     apic_write_reg(APIC_SPIVR, spiv);
 }
 
+static void
+apic_init()
+{
+    // ensure that external interrupt is disabled
+    cpu_disable_interrupt();
+
+    // Make sure the APIC is there
+    //  FUTURE: Use 8259 as fallback
+
+    // FIXME apic abstraction as local interrupt controller
+    // assert_msg(cpu_has_apic(), "No APIC detected!");
+
+    // As we are going to use APIC, disable the old 8259 PIC
+    pic_disable();
+
+    _apic_base = ioremap(__APIC_BASE_PADDR, 4096);
+
+    apic_setup_local();
+}
+
+/**
+ * @brief Enable the local APIC of an application processor. They
+ * all share the same MMIO window as boot processor.
+ */
+void
+apic_ap_init()
+{
+    apic_setup_local();
+}
+
 static void
 ioapic_init()
 {
@@ -14,6 +14,9 @@ LOG_MODULE("timer(apic)")
 #define LVT_ENTRY_TIMER(vector, mode) (LVT_DELIVERY_FIXED | mode | vector)
 #define APIC_BASETICKS 0x100000
 
+// timers of all processors are driven by the same bus clock
+static ticks_t apic_base_freq = 0;
+
 static void
 apic_timer_count_stop(irq_t irq, const struct hart_state* state)
 {
@@ -95,6 +98,7 @@ __apic_timer_calibrate(struct hwtimer_pot* pot, u32_t hertz)
     base_freq = APIC_BASETICKS / base_freq * sysrtc->base_freq;
     pot->base_freq = base_freq;
     pot->systick_raw = 0;
+    apic_base_freq = base_freq;
 
     assert_msg(base_freq, "Fail to initialize timer (NOFREQ)");
     INFO("hw: %u Hz; os: %u Hz", base_freq, hertz);
@@ -107,6 +111,17 @@ __apic_timer_calibrate(struct hwtimer_pot* pot, u32_t hertz)
         LVT_ENTRY_TIMER(irq->vector, LVT_TIMER_PERIODIC));
 }
 
+void
+apic_timer_start_local(int vector, u32_t period_ms)
+{
+    assert(apic_base_freq);
+
+    apic_write_reg(APIC_TIMER_DCR, APIC_TIMER_DIV64);
+    apic_write_reg(APIC_TIMER_ICR, apic_base_freq / 1000 * period_ms);
+    apic_write_reg(APIC_TIMER_LVT,
+                   LVT_ENTRY_TIMER(vector, LVT_TIMER_PERIODIC));
+}
+
 static struct hwtimer_pot_ops potops = {
     .calibrate = __apic_timer_calibrate,
 };
@@ -5,4 +5,12 @@
 
 struct hwtimer* apic_hwtimer_context();
 
+/**
+ * @brief Start the local APIC timer of the executing processor,
+ * raising `vector` every `period_ms`. Only valid after the timer 
+ * is calibrated on the boot processor.
+ */
+void
+apic_timer_start_local(int vector, u32_t period_ms);
+
 #endif /* __LUNAIX_APIC_TIMER_H */
@@ -0,0 +1,254 @@
+/**
+ * @file smp.c
+ * @brief Bring up of application processors (AP) via INIT-SIPI-SIPI
+ *
+ * Each AP gets its own GDT, TSS and cpu_local, then waits for an idle
+ * thread from scheduler. From there on, its local APIC timer drives
+ * the scheduling on its own run queue.
+ */
+
+#include <lunaix/owloysius.h>
+#include <lunaix/process.h>
+#include <lunaix/sched.h>
+#include <lunaix/spike.h>
+#include <lunaix/syslog.h>
+#include <lunaix/mm/page.h>
+#include <lunaix/mm/pmm.h>
+#include <lunaix/mm/valloc.h>
+
+#include <hal/acpi/acpi.h>
+
+#include <asm/abi.h>
+#include <asm/cpu.h>
+#include <asm/mm_defs.h>
+#include <asm/x86_cpu.h>
+#include <asm/x86_pmio.h>
+#include <asm/soc/apic.h>
+#include <asm/x86_ivs.h>
+
+#include <klibc/string.h>
+
+#include "apic_timer.h"
+
+LOG_MODULE("smp")
+
+#define AP_TRAMPOLINE_PA        0x8000
+#define AP_TRAMPOLINE_VECTOR    (AP_TRAMPOLINE_PA >> 12)
+
+#define AP_STACK_ORDER          1
+
+// roughly 1ms per unit, see ahci.c
+#define DELAY_1MS               100000
+#define AP_ONLINE_TIMEOUT       200
+
+/*
+    Must agree with the layout in boot/i386/aptramp32.S
+ */
+struct ap_bootparam
+{
+    struct {
+        u16_t limit;
+        u32_t base;
+    } compact gdtr;
+    struct {
+        u32_t eip;
+        u16_t cs;
+    } compact jmp32;
+    u32_t cr3;
+    u32_t cr4;
+    u32_t cr0;
+    u32_t stack;
+    u32_t entry;
+    u32_t arg;
+} compact;
+
+struct ap_desc
+{
+    x86_segdesc_t gdt[X86_GDT_LEN];
+    struct x86_tss tss;
+};
+
+extern u8_t ap_trampoline[], ap_trampoline32[], ap_trampoline_end[];
+extern u8_t ap_param[];
+
+extern x86_segdesc_t _gdt[];
+extern u16_t _gdt_limit;
+extern struct x86_sysdesc _idt[];
+extern u16_t _idt_limit;
+
+static inline ptr_t
+__trampoline_pa(void* sym)
+{
+    return AP_TRAMPOLINE_PA + ((ptr_t)sym - (ptr_t)ap_trampoline);
+}
+
+static inline reg_t
+__read_cr4()
+{
+    reg_t val;
+    asm volatile("movl %%cr4, %0" : "=r"(val));
+    return val;
+}
+
+static void
+x86_ap_main(struct cpu_local* cpu)
+{
+    struct {
+        u16_t limit;
+        ptr_t base;
+    } compact gdtr, idtr;
+
+    gdtr.limit = sizeof(x86_segdesc_t) * X86_GDT_LEN - 1;
+    gdtr.base  = (ptr_t)cpu->arch.gdt;
+    idtr.limit = _idt_limit;
+    idtr.base  = (ptr_t)_idt;
+
+    asm volatile("lgdt %0\n"
+                 "lidt %1\n"
+                 "ljmp %2, $1f\n"
+                 "1:\n"
+                 "movw %w3, %%ds\n"
+                 "movw %w3, %%es\n"
+                 "movw %w3, %%fs\n"
+                 "movw %w3, %%ss\n"
+                 "movw %w4, %%gs\n"
+                 "ltr %w5\n"
+                 :: "m"(gdtr), "m"(idtr), "i"(KCODE_SEG),
+                    "r"(KDATA_SEG), "r"(KPERCPU_SEG), "r"(TSS_SEG)
+                 : "memory");
+
+    apic_ap_init();
+
+    // this_cpu() is now usable
+    assert(this_cpu() == cpu);
+
+    cpu->online = true;
+
+    // wait until scheduler is up and has an idle thread for us
+    while (1) {
+        kernel_lock();
+        if (cpu->idle) {
+            break;
+        }
+
+        kernel_unlock();
+        cpu_relax();
+    }
+
+    /*
+        External interrupts are all routed to the boot processor, the
+        local timer is only here to give out time slices. It does not
+        share LUNAIX_SCHED with yields, those are not ticks to sample.
+     */
+    apic_timer_start_local(LUNAIX_SCHED_TICK, SCHED_TIME_SLICE);
+
+    run(cpu->idle);
+}
+
+static void
+__install_trampoline(struct ap_bootparam* param)
+{
+    size_t len = (ptr_t)ap_trampoline_end - (ptr_t)ap_trampoline;
+
+    pmm_onhold_range(page_index(AP_TRAMPOLINE_PA), count_pages(len));
+    memcpy((void*)phy_to_virt(AP_TRAMPOLINE_PA), ap_trampoline, len);
+
+    param->gdtr.limit = _gdt_limit;
+    param->gdtr.base  = to_kphysical(_gdt);
+    param->jmp32.eip  = __trampoline_pa(ap_trampoline32);
+    param->jmp32.cs   = KCODE_SEG;
+
+    param->cr0 = cpu_ldconfig();
+    param->cr3 = cpu_ldvmspace();
+    param->cr4 = __read_cr4();
+    param->entry = (u32_t)x86_ap_main;
+}
+
+static bool
+__boot_ap(struct ap_bootparam* param, struct cpu_local* cpu)
+{
+    struct ap_desc* desc;
+    struct leaflet* stack;
+
+    desc  = vzalloc(sizeof(*desc));
+    stack = leaflet_alloc_order(PGPOL_NORMAL, AP_STACK_ORDER);
+    if (!desc || !stack) {
+        return false;
+    }
+
+    desc->tss.ss0 = KDATA_SEG;
+    cpu->arch.tss = &desc->tss;
+    x86_init_gdt_at(desc->gdt, cpu);
+    sched_init_cpu(cpu);
+
+    param->stack = align_stack(leaflet_va(stack) + leaflet_size(stack));
+
+    // boot stack is abandoned once AP is in its idle thread
+    cpu->arch.tmp_stack = param->stack;
+    param->arg   = (u32_t)cpu;
+
+    apic_send_ipi(cpu->hwid,
+                  ICR_DELIVERY_INIT | ICR_LEVEL_ASSERT | ICR_TRIGGER_LEVEL);
+    apic_send_ipi(cpu->hwid, ICR_DELIVERY_INIT | ICR_TRIGGER_LEVEL);
+    port_delay(10 * DELAY_1MS);
+
+    // second SIPI is for older processors that might miss the first
+    for (int i = 0; i < 2 && !cpu->online; i++) {
+        apic_send_ipi(cpu->hwid,
+                      ICR_DELIVERY_STARTUP | AP_TRAMPOLINE_VECTOR);
+        port_delay(DELAY_1MS);
+    }
+
+    for (int i = 0; i < AP_ONLINE_TIMEOUT && !cpu->online; i++) {
+        port_delay(DELAY_1MS);
+    }
+
+    return cpu->online;
+}
+
+static void
+smp_boot_aps()
+{
+    acpi_context* acpi;
+    acpi_apic_t* lapic;
+    struct cpu_local* cpu;
+    struct ap_bootparam* param;
+    unsigned int bsp_id;
+
+    acpi   = acpi_get_context();
+    bsp_id = apic_current_id();
+
+    cpu_local(0)->hwid = bsp_id;
+
+    if (acpi->madt.lapic_count <= 1) {
+        return;
+    }
+
+    param = (struct ap_bootparam*)phy_to_virt(__trampoline_pa(ap_param));
+    __install_trampoline(param);
+
+    for (unsigned int i = 0; i < acpi->madt.lapic_count; i++) {
+        lapic = acpi->madt.lapics[i];
+        if (lapic->apic_id == bsp_id) {
+            continue;
+        }
+
+        if (nr_cpus == CONFIG_NR_CPUS) {
+            break;
+        }
+
+        cpu = cpu_local(nr_cpus);
+        cpu->id   = nr_cpus;
+        cpu->hwid = lapic->apic_id;
+
+        if (!__boot_ap(param, cpu)) {
+            WARN("processor (apic=%d) not responding", cpu->hwid);
+            break;
+        }
+
+        nr_cpus++;
+    }
+
+    INFO("%d processor(s) online", nr_cpus);
+}
+owloysius_fetch_init(smp_boot_aps, on_boot);
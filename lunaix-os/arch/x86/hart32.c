@@ -24,7 +24,7 @@ hart_prepare_transition(struct hart_transition* ht,
                                 .ds = KDATA_SEG,
                                 .es = KDATA_SEG,
                                 .fs = KDATA_SEG,
-                                .gs = KDATA_SEG 
+                                .gs = KPERCPU_SEG 
                             },
                             .execp = (struct exec_param*)(ht->inject + offset)
                         };
@@ -34,6 +34,7 @@ hart_prepare_transition(struct hart_transition* ht,
     if (to_user) {
         code_seg = UCODE_SEG, data_seg = UDATA_SEG;
         mstate |= 0x200;   // enable interrupt
+        ht->transfer.state.registers.gs = KDATA_SEG;
     }
 
     ht->transfer.eret = (struct exec_param) {
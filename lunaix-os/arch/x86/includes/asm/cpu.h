@@ -24,4 +24,47 @@ cpu_wait()
     asm("hlt");
 }
 
+/**
+ * @brief Hint the processor that we are in a spin-wait loop
+ */
+static inline void
+cpu_relax()
+{
+    asm volatile("pause" ::: "memory");
+}
+
+/**
+ * @brief Disable interrupt, return the previous interrupt state 
+ * to be used with cpu_restore_interrupt
+ */
+static inline reg_t
+cpu_save_interrupt()
+{
+    reg_t flags;
+    asm volatile("pushf\n"
+                 "pop %0\n"
+                 "cli\n"
+                 : "=r"(flags)::"memory");
+    return flags;
+}
+
+static inline void
+cpu_restore_interrupt(reg_t flags)
+{
+    if ((flags & 0x200)) {
+        asm volatile("sti" ::: "memory");
+    }
+}
+
+/**
+ * @brief Read the free-running cycle counter of current processor
+ */
+static inline u64_t
+cpu_cycles()
+{
+    u32_t lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((u64_t)hi << 32) | lo;
+}
+
 #endif /* __LUNAIX_CPU_H */
@@ -0,0 +1,62 @@
+#ifndef __LUNAIX_ARCH_PERCPU_H
+#define __LUNAIX_ARCH_PERCPU_H
+
+/*
+    Offsets into the head of struct cpu_local, these are shared with 
+    the interrupt entry/exit path. Any change to the layout of 
+    struct cpu_local must be reflected here!
+ */
+
+#ifdef CONFIG_ARCH_X86_64
+#   define __percpu_slot      8
+#else
+#   define __percpu_slot      4
+#endif
+
+#define percpu_self             (0 * __percpu_slot)
+#define percpu_thread           (1 * __percpu_slot)
+#define percpu_proc             (2 * __percpu_slot)
+#define percpu_tss              (3 * __percpu_slot)
+#define percpu_tmpstk           (4 * __percpu_slot)
+
+#ifndef __ASM__
+
+#include "x86.h"
+
+struct cpu_local;
+
+struct arch_percpu
+{
+    volatile struct x86_tss* tss;
+    ptr_t tmp_stack;            // stack used while switching context
+    x86_segdesc_t* gdt;
+    unsigned int tlb_gen;       // kernel mappings seen, see mm/tlb.c
+};
+
+#ifdef CONFIG_ARCH_X86_64
+
+/*
+    Application processors are not brought up on x86_64 yet, so
+    there is only one cpu_local to deal with.
+ */
+#define this_cpu()      (&cpu_locals[0])
+
+#else
+
+/**
+ * @brief Get the cpu_local of the executing processor. It is 
+ * reached through %gs, which is set to KPERCPU_SEG for the 
+ * entire time we are in kernel.
+ */
+static inline struct cpu_local*
+this_cpu()
+{
+    struct cpu_local* cpu;
+    asm volatile("movl %%gs:%c1, %0" : "=r"(cpu) : "i"(percpu_self));
+    return cpu;
+}
+
+#endif
+
+#endif /* __ASM__ */
+#endif /* __LUNAIX_ARCH_PERCPU_H */
@@ -32,6 +32,7 @@
     0x200 // Base address for Interrupt-Request bitmap register (256bits)
 #define APIC_ESR 0x280      // Error Status Reg
 #define APIC_ICR_BASE 0x300 // Interrupt Command
+#define APIC_ICR_HIGH 0x310 // Interrupt Command, destination field
 #define APIC_LVT_LINT0 0x350
 #define APIC_LVT_LINT1 0x360
 #define APIC_LVT_ERROR 0x370
@@ -54,6 +55,15 @@
 #define LVT_TIMER_ONESHOT (0 << 17)
 #define LVT_TIMER_PERIODIC (1 << 17)
 
+// Interrupt command, see Intel Manual Vol3A. 10-46 (pp. 3240), Figure 10-12
+#define ICR_DELIVERY_FIXED (0b000 << 8)
+#define ICR_DELIVERY_INIT (0b101 << 8)
+#define ICR_DELIVERY_STARTUP (0b110 << 8)
+#define ICR_DELIVERY_PENDING (1 << 12)
+#define ICR_LEVEL_ASSERT (1 << 14)
+#define ICR_TRIGGER_LEVEL (1 << 15)
+#define ICR_DEST(apic_id) ((apic_id) << 24)
+
 // Dividers for timer. See Intel Manual Vol3A. 10-17 (pp. 3207), Figure 10-10
 #define APIC_TIMER_DIV1 0b1011
 #define APIC_TIMER_DIV2 0b0000
@@ -72,4 +82,13 @@ apic_read_reg(unsigned int reg);
 void
 apic_write_reg(unsigned int reg, unsigned int val);
 
+unsigned int
+apic_current_id();
+
+void
+apic_send_ipi(unsigned int apic_id, unsigned int icr);
+
+void
+apic_ap_init();
+
 #endif /* __LUNAIX_APIC_H */
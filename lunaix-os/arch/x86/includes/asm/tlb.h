@@ -6,6 +6,14 @@
 #include <lunaix/mm/physical.h>
 #include <lunaix/mm/pagetable.h>
 
+#include <stdatomic.h>
+
+/*
+ * Beyond this many pages, a ranged flush costs more than
+ * simply reloading the entire address space
+ */
+#define TLB_FLUSH_ALL_THRESHOLD     32
+
 /**
  * @brief Invalidate an entry of all address space
  * 
@@ -97,12 +105,25 @@ tlb_flush_range(ptr_t addr, unsigned int npages)
 static inline void 
 tlb_flush_asid_range(unsigned int asid, ptr_t addr, unsigned int npages)
 {
+    if (npages > TLB_FLUSH_ALL_THRESHOLD) {
+        __tlb_flush_asid_all(asid);
+        return;
+    }
+
     for (unsigned int i = 0; i < npages; i++)
     {
         __tlb_flush_asid(asid, addr + i * PAGE_SIZE);
     }
 }
 
+struct cpu_local;
+
+/*
+ * Generation of kernel mappings, bumped on every change to them.
+ * Processors other than the changing one catch up in tlb_sync_kernel
+ */
+extern atomic_uint tlb_kernel_gen;
+
 /**
  * @brief Invalidate an entry of kernel address spaces
  * 
@@ -114,8 +135,19 @@ static inline void
 tlb_flush_kernel(ptr_t addr)
 {
     __tlb_flush_global(addr);
+    atomic_fetch_add(&tlb_kernel_gen, 1);
 }
 
+/**
+ * @brief Drop the stale kernel entries left on this processor by
+ *        changes made on the others. Called with the kernel lock
+ *        just taken.
+ * 
+ * @param cpu 
+ */
+void
+tlb_sync_kernel(struct cpu_local* cpu);
+
 /**
  * @brief Invalidate entries of kernel address spaces
  * 
@@ -182,4 +214,83 @@ tlb_flush_vmr_all(struct mm_region* vmr);
 void
 tlb_flush_vmr_range(struct mm_region* vmr, ptr_t addr, unsigned int npages);
 
+/* ******** TLB Shootdown Batching ******** */
+
+/*
+ * Number of page releases that can be held back before
+ * the gather is forced to flush
+ */
+#define TLB_GATHER_BATCH            32
+
+struct leaflet;
+
+/**
+ * @brief Accumulates invalidations (and the pages whose mapping
+ *        was torn down) so that a series of unmappings can be 
+ *        settled by a single shootdown.
+ * 
+ * Pages handed over via tlb_gather_release are returned only after
+ * the stale translations to them are gone.
+ */
+struct tlb_gather
+{
+    struct proc_mm* mm;
+    ptr_t start;
+    ptr_t end;
+    bool flush_all;
+    unsigned int nr_freed;
+    struct leaflet* freed[TLB_GATHER_BATCH];
+};
+
+static inline void
+tlb_gather_init(struct tlb_gather* tlb, struct proc_mm* mm)
+{
+    tlb->mm = mm;
+    tlb->start = -1UL;
+    tlb->end = 0;
+    tlb->flush_all = false;
+    tlb->nr_freed = 0;
+}
+
+/**
+ * @brief Record a range that must be invalidated
+ * 
+ * @param tlb 
+ * @param addr 
+ * @param npages 
+ */
+void
+tlb_gather_range(struct tlb_gather* tlb, ptr_t addr, unsigned int npages);
+
+static inline void
+tlb_gather_page(struct tlb_gather* tlb, ptr_t addr)
+{
+    tlb_gather_range(tlb, addr, 1);
+}
+
+/**
+ * @brief Release a leaflet after the pending invalidations 
+ *        have been carried out
+ * 
+ * @param tlb 
+ * @param leaflet 
+ */
+void
+tlb_gather_release(struct tlb_gather* tlb, struct leaflet* leaflet);
+
+/**
+ * @brief Carry out the pending invalidations and return all
+ *        the deferred leaflets. The gather can be reused after.
+ * 
+ * @param tlb 
+ */
+void
+tlb_gather_flush(struct tlb_gather* tlb);
+
+static inline void
+tlb_gather_finish(struct tlb_gather* tlb)
+{
+    tlb_gather_flush(tlb);
+}
+
 #endif /* __LUNAIX_VMTLB_H */
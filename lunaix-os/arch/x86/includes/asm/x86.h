@@ -11,6 +11,7 @@
     #define KDATA_SEG (SEL_INDEX(3) | SEL_RPL(0))
     #define UDATA_SEG (SEL_INDEX(4) | SEL_RPL(3))
     #define TSS_SEG   (SEL_INDEX(5) | SEL_RPL(0))
+    #define KPERCPU_SEG (SEL_INDEX(6) | SEL_RPL(0))
 
 #else
     #define KDATA_SEG (SEL_INDEX(3) | SEL_RPL(0))
@@ -90,6 +91,13 @@ struct x86_sysdesc {
 
 typedef struct x86_sysdesc x86_segdesc_t;
 
+#define X86_GDT_LEN     7
+
+struct cpu_local;
+
+void
+x86_init_gdt_at(x86_segdesc_t* gdt, struct cpu_local* cpu);
+
 #endif
 
 void
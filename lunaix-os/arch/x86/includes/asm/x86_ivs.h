@@ -33,6 +33,7 @@
 #define LUNAIX_SYS_CALL                 33
 
 // begin allocatable iv resources
+#define LUNAIX_SCHED_TICK               49
 #define LUNAIX_SCHED                    50
 #define IV_EX_BEGIN                     51
 
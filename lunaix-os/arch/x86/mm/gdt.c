@@ -1,4 +1,5 @@
 #include <lunaix/types.h>
+#include <lunaix/percpu.h>
 #include "asm/x86.h"
 
 #define SD_TYPE(x) (x << 8)
@@ -91,13 +92,14 @@ _set_tss(int index, ptr_t base, size_t size)
 
 #else
 
-x86_segdesc_t _gdt[6];
+x86_segdesc_t _gdt[X86_GDT_LEN];
 u16_t _gdt_limit = sizeof(_gdt) - 1;
 
 static inline void
-_set_gdt_entry(u32_t index, ptr_t base, u32_t limit, u32_t flags)
+_set_gdt_entry_at(x86_segdesc_t* gdt, 
+                  u32_t index, ptr_t base, u32_t limit, u32_t flags)
 {
-    x86_segdesc_t* gdte = &_gdt[index];
+    x86_segdesc_t* gdte = &gdt[index];
 
     flags |= BIT32;
 
@@ -107,9 +109,30 @@ _set_gdt_entry(u32_t index, ptr_t base, u32_t limit, u32_t flags)
 }
 
 static inline void
-_set_tss(int index, ptr_t base, size_t size)
+_set_tss_at(x86_segdesc_t* gdt, int index, ptr_t base, size_t size)
+{
+    _set_gdt_entry_at(gdt, index, base, size - 1, SEG_TSS);
+}
+
+/**
+ * @brief Populate a GDT for the given processor. Every processor 
+ * owns a private copy, which differs only in the base of TSS and
+ * KPERCPU_SEG, so selectors stay the same across all of them.
+ */
+void
+x86_init_gdt_at(x86_segdesc_t* gdt, struct cpu_local* cpu)
 {
-    _set_gdt_entry(index, base, size - 1, SEG_TSS);
+    ptr_t tss = (ptr_t)cpu->arch.tss;
+
+    _set_gdt_entry_at(gdt, 0, 0, 0, 0);
+    _set_gdt_entry_at(gdt, 1, 0, 0xfffff, SEG_R0_CODE);
+    _set_gdt_entry_at(gdt, 2, 0, 0xfffff, SEG_R3_CODE);
+    _set_gdt_entry_at(gdt, 3, 0, 0xfffff, SEG_R0_DATA);
+    _set_gdt_entry_at(gdt, 4, 0, 0xfffff, SEG_R3_DATA);
+    _set_tss_at(gdt, 5, tss, sizeof(struct x86_tss) - 1);
+    _set_gdt_entry_at(gdt, 6, (ptr_t)cpu, 0xfffff, SEG_R0_DATA);
+
+    cpu->arch.gdt = gdt;
 }
 
 #endif
@@ -119,6 +142,10 @@ void
 _init_gdt()
 {
     extern struct x86_tss _tss;
+    extern u8_t tmp_stack[];
+
+    cpu_locals[0].arch.tss = &_tss;
+    cpu_locals[0].arch.tmp_stack = (ptr_t)tmp_stack;
 
 #ifdef CONFIG_ARCH_X86_64
     _gdt[0] = 0;
@@ -128,11 +155,6 @@ _init_gdt()
     _set_gdt_entry(4, 4, SEG_R3_DATA);   // generic data
     _set_tss(5, (ptr_t)&_tss, sizeof(_tss));
 #else
-    _set_gdt_entry(0, 0, 0, 0);
-    _set_gdt_entry(1, 0, 0xfffff, SEG_R0_CODE);
-    _set_gdt_entry(2, 0, 0xfffff, SEG_R3_CODE);
-    _set_gdt_entry(3, 0, 0xfffff, SEG_R0_DATA);
-    _set_gdt_entry(4, 0, 0xfffff, SEG_R3_DATA);
-    _set_tss(5, (u32_t)&_tss, sizeof(struct x86_tss) - 1);
+    x86_init_gdt_at(_gdt, &cpu_locals[0]);
 #endif
 }
\ No newline at end of file
@@ -2,6 +2,30 @@
 #include <asm/tlb.h>
 #include <lunaix/process.h>
 
+/*
+    Kernel mappings, as well as any access through them, are only ever
+    made with the kernel lock held (see sched.c). Rather than sending
+    a shootdown IPI, which a processor spinning on that very lock with
+    interrupt off would never answer, a change only bumps the
+    generation. Everyone else flushes as they next take the lock, and
+    can not reach the changed mapping before that.
+ */
+atomic_uint tlb_kernel_gen = 0;
+
+void
+tlb_sync_kernel(struct cpu_local* cpu)
+{
+    unsigned int gen;
+
+    gen = atomic_load(&tlb_kernel_gen);
+    if (cpu->arch.tlb_gen == gen) {
+        return;
+    }
+
+    cpu->arch.tlb_gen = gen;
+    __tlb_flush_all();
+}
+
 void
 tlb_flush_mm(struct proc_mm* mm, ptr_t addr)
 {
@@ -33,3 +57,54 @@ tlb_flush_vmr_range(struct mm_region* vmr, ptr_t addr, unsigned int npages)
 {
     tlb_flush_asid_range(procvm_asid(vmr->proc_vms), addr, npages);
 }
+
+void
+tlb_gather_range(struct tlb_gather* tlb, ptr_t addr, unsigned int npages)
+{
+    ptr_t end;
+
+    if (tlb->flush_all || !npages) {
+        return;
+    }
+
+    end = addr + npages * PAGE_SIZE;
+
+    tlb->start = MIN(tlb->start, addr);
+    tlb->end   = MAX(tlb->end, end);
+
+    if (count_pages(tlb->end - tlb->start) > TLB_FLUSH_ALL_THRESHOLD) {
+        tlb->flush_all = true;
+    }
+}
+
+void
+tlb_gather_release(struct tlb_gather* tlb, struct leaflet* leaflet)
+{
+    if (tlb->nr_freed == TLB_GATHER_BATCH) {
+        tlb_gather_flush(tlb);
+    }
+
+    tlb->freed[tlb->nr_freed++] = leaflet;
+}
+
+void
+tlb_gather_flush(struct tlb_gather* tlb)
+{
+    unsigned int asid;
+
+    asid = tlb->mm ? procvm_asid(tlb->mm) : 0;
+
+    if (tlb->flush_all) {
+        __tlb_flush_asid_all(asid);
+    }
+    else if (tlb->start < tlb->end) {
+        tlb_flush_asid_range(asid, tlb->start, 
+                             count_pages(tlb->end - tlb->start));
+    }
+
+    for (unsigned int i = 0; i < tlb->nr_freed; i++) {
+        leaflet_return(tlb->freed[i]);
+    }
+
+    tlb_gather_init(tlb, tlb->mm);
+}
@@ -14,13 +14,26 @@ madt_parse(acpi_madt_t* madt, acpi_context* toc)
     toc->madt.irq_exception =
       (acpi_intso_t**)vcalloc(24, sizeof(acpi_intso_t*));
 
+    toc->madt.lapics =
+      (acpi_apic_t**)vcalloc(CONFIG_NR_CPUS, sizeof(acpi_apic_t*));
+
     size_t so_idx = 0;
     while (ics_start < ics_end) {
         acpi_ics_hdr_t* entry = __acpi_ics_hdr(ics_start);
         switch (entry->type) {
-            case ACPI_MADT_LAPIC:
-                toc->madt.apic = __acpi_apic(entry);
+            case ACPI_MADT_LAPIC: {
+                acpi_apic_t* lapic = __acpi_apic(entry);
+                toc->madt.apic = lapic;
+
+                if (!(lapic->flags & ACPI_APIC_ENABLED)) {
+                    break;
+                }
+
+                if (toc->madt.lapic_count < CONFIG_NR_CPUS) {
+                    toc->madt.lapics[toc->madt.lapic_count++] = lapic;
+                }
                 break;
+            }
             case ACPI_MADT_IOAPIC:
                 toc->madt.ioapic = __acpi_ioapic(entry);
                 break;
@@ -157,6 +157,9 @@ ahci_driver_init(struct ahci_driver_param* param)
             .hba = hba
         };
 
+        llist_init_head(&port->cmdctx.retired);
+        irq_tasklet_init(&port->cmdctx.retire_work, ahci_retire_cmds, port);
+
         /* 初始化端口，并置于就绪状态 */
         port_regs[HBA_RPxCI] = 0;
 
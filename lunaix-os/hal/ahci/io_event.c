@@ -3,6 +3,8 @@
 #include <lunaix/mm/valloc.h>
 #include <lunaix/syslog.h>
 
+#include <asm/cpu.h>
+
 LOG_MODULE("io_evt")
 
 void
@@ -31,7 +33,11 @@ proceed:
     u32_t port_num = msbiti - clz(hba->base[HBA_RIS]);
     struct hba_port* port = hba->ports[port_num];
     struct hba_cmd_context* cmdctx = &port->cmdctx;
-    u32_t processed = port->regs[HBA_RPxCI] ^ cmdctx->tracked_ci;
+    u32_t processed = cmdctx->tracked_ci & ~port->regs[HBA_RPxCI];
+    struct hba_cmd_state* cmdstate;
+    struct blkio_req* ioreq;
+    bool error;
+    u32_t slot;
 
     sata_read_error(port);
 
@@ -48,30 +54,71 @@ proceed:
         goto done;
     }
 
-    u32_t slot = msbiti - clz(processed);
-    struct hba_cmd_state* cmdstate = cmdctx->issued[slot];
-
-    if (!cmdstate) {
-        goto done;
+    error = !!(port->device->last_result.status & HBA_PxTFD_ERR);
+    if (error) {
+        hba_clear_reg(port->regs[HBA_RPxSERR]);
     }
 
-    struct blkio_req* ioreq = (struct blkio_req*)cmdstate->state_ctx;
+    /*
+        Retire every slot that is done since the last interrupt, and
+        leave the completion to the tasklet.
+     */
+    cmdctx->tracked_ci &= ~processed;
 
-    if ((port->device->last_result.status & HBA_PxTFD_ERR)) {
-        ioreq->errcode = port->regs[HBA_RPxTFD] & 0xffff;
-        ioreq->flags |= BLKIO_ERROR;
-        hba_clear_reg(port->regs[HBA_RPxSERR]);
+    while (processed) {
+        slot = msbiti - clz(processed);
+        processed &= ~(1 << slot);
+
+        cmdstate = cmdctx->issued[slot];
+        cmdctx->issued[slot] = NULL;
+
+        if (!cmdstate) {
+            continue;
+        }
+
+        if (error) {
+            ioreq = (struct blkio_req*)cmdstate->state_ctx;
+            ioreq->errcode = port->regs[HBA_RPxTFD] & 0xffff;
+            ioreq->flags |= BLKIO_ERROR;
+        }
+
+        llist_append(&cmdctx->retired, &cmdstate->retired);
     }
 
-    blkio_schedule(ioreq->io_ctx);
-    blkio_complete(ioreq);
-    vfree_dma(cmdstate->cmd_table);
+    irq_tasklet_schedule(&cmdctx->retire_work);
 
 done:
     hba_clear_reg(port->regs[HBA_RPxIS]);
     hba->base[HBA_RIS] &= ~(1 << (31 - port_num));
 }
 
+void
+ahci_retire_cmds(void* data)
+{
+    struct hba_port* port = (struct hba_port*)data;
+    struct hba_cmd_state *pos, *n;
+    struct blkio_req* ioreq;
+    struct llist_header batch;
+    reg_t flags;
+
+    llist_init_head(&batch);
+
+    flags = cpu_save_interrupt();
+    llist_splice(&batch, &port->cmdctx.retired);
+    cpu_restore_interrupt(flags);
+
+    llist_for_each(pos, n, &batch, retired)
+    {
+        ioreq = (struct blkio_req*)pos->state_ctx;
+
+        blkio_schedule(ioreq->io_ctx);
+        blkio_complete(ioreq);
+
+        vfree_dma(pos->cmd_table);
+        vfree(pos);
+    }
+}
+
 void
 __ahci_blkio_handler(struct blkio_req* req)
 {
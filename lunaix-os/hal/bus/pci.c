@@ -15,6 +15,7 @@
 #include <lunaix/mm/valloc.h>
 #include <lunaix/spike.h>
 #include <lunaix/syslog.h>
+#include <lunaix/boottime.h>
 
 LOG_MODULE("PCI")
 
@@ -120,7 +121,7 @@ __pci_add_prober(pciaddr_t loc, ptr_t pci_base, int devinfo)
 static int
 __pci_bind(struct pci_registry* reg, struct pci_probe* probe)
 {
-    int errno;
+    int errno, span;
     struct device_def* devdef;
 
     if (probe->bind) {
@@ -132,7 +133,10 @@ __pci_bind(struct pci_registry* reg, struct pci_probe* probe)
     }
 
     devdef = reg->definition;
+
+    span = boottime_begin(BOOT_DRIVER, devdef->name, 0);
     errno = devdef->create(devdef, &probe->mobj);
+    boottime_end(span);
 
     if (errno) {
         ERROR("pci_loc:%x, bind (%xh:%xh.%d) failed, e=%d",
@@ -563,7 +567,7 @@ pci_create(struct device_def* def, morph_t* obj)
     irq_attach_domain(irq_get_default_domain(), pci_domain);
 
     register_device(pci_bridge, &def->class, "pci_bridge");
-    pci_scan();
+    boottime_step(pci_scan());
 
     return 0;
 }
@@ -40,16 +40,26 @@ serial_accept_buffer(struct serial_dev* sdev, void* val, size_t len)
     return !!rbuffer_puts(&sdev->rxbuf, val, len);
 }
 
-void
-serial_end_recv(struct serial_dev* sdev)
+static void
+__serial_rx_work(void* data)
 {
-    mark_device_done_read(sdev->dev);
+    struct serial_dev* sdev = (struct serial_dev*)data;
 
     pwake_one(&sdev->wq_rxdone);
+    iopoll_wake_pollers(&sdev->dev->pollers);
 
     term_notify_data_avaliable(sdev->tp_cap);
 }
 
+void
+serial_end_recv(struct serial_dev* sdev)
+{
+    mark_device_done_read(sdev->dev);
+
+    // line discipline is too heavy to be run with interrupt off.
+    irq_tasklet_schedule(&sdev->rx_work);
+}
+
 void
 serial_end_xmit(struct serial_dev* sdev, size_t len)
 {
@@ -57,6 +67,7 @@ serial_end_xmit(struct serial_dev* sdev, size_t len)
 
     sdev->wr_len = len;
     pwake_one(&sdev->wq_txdone);
+    iopoll_wake_pollers(&sdev->dev->pollers);
 }
 
 int
@@ -285,6 +296,7 @@ serial_create(struct devclass* class, char* if_ident)
 
     waitq_init(&sdev->wq_rxdone);
     waitq_init(&sdev->wq_txdone);
+    irq_tasklet_init(&sdev->rx_work, __serial_rx_work, sdev);
     rbuffer_init(&sdev->rxbuf, valloc(RXBUF_SIZE), RXBUF_SIZE);
     llist_append(&serial_devs, &sdev->sdev_list);
     
@@ -718,8 +718,9 @@ dt_find_next(struct dtn_iter* iter,
     head = dt_mobj(iter->head);
     pos  = dt_mobj(iter->matched);
     *matched = iter->matched;
+    iter->matched = NULL;
 
-    while (&pos->sibs != &head->subs)
+    while (pos->sibs.next != &head->subs)
     {
         pos = list_next(pos, morph_t, sibs);
         node = changeling_reveal(pos, dt_morpher);
@@ -729,10 +730,10 @@ dt_find_next(struct dtn_iter* iter,
         }
 
         iter->matched = &node->base;
-        return true;
+        break;
     }
 
-    return false;
+    return true;
 }
 
 struct dtp_val*
@@ -1,9 +1,26 @@
 #include <hal/irq.h>
 #include <lunaix/mm/valloc.h>
 #include <lunaix/owloysius.h>
+#include <lunaix/percpu.h>
+
+#include <asm/cpu.h>
+
+/*
+    Bound the rounds we take to drain the pending list, in case a
+    tasklet keeps rescheduling itself. Whatever left is picked up on
+    the next interrupt.
+ */
+#define DEFERRED_MAX_ROUNDS     8
+
+struct irq_bottom_half
+{
+    struct llist_header pending;
+    bool running;
+};
 
 static struct irq_domain* default_domain = NULL;
 static DEFINE_LLIST(irq_domains);
+static struct irq_bottom_half bottom_halves[CONFIG_NR_CPUS];
 
 static void
 __default_servant(irq_t irq, const struct hart_state* state)
@@ -192,3 +209,93 @@ irq_get_default_domain()
     assert(default_domain);
     return default_domain;
 }
+
+static inline struct irq_bottom_half*
+__this_bottom_half()
+{
+    struct irq_bottom_half* bh;
+
+    bh = &bottom_halves[this_cpu_id()];
+    if (unlikely(!bh->pending.next)) {
+        llist_init_head(&bh->pending);
+    }
+
+    return bh;
+}
+
+void
+irq_tasklet_init(struct irq_tasklet* tasklet, void (*fn)(void*), void* data)
+{
+    *tasklet = (struct irq_tasklet) {
+        .fn = fn,
+        .data = data,
+        .pending = false
+    };
+
+    llist_init_head(&tasklet->link);
+}
+
+void
+irq_tasklet_schedule(struct irq_tasklet* tasklet)
+{
+    struct irq_bottom_half* bh;
+    reg_t flags;
+
+    flags = cpu_save_interrupt();
+
+    if (!tasklet->pending) {
+        bh = __this_bottom_half();
+        tasklet->pending = true;
+        llist_append(&bh->pending, &tasklet->link);
+    }
+
+    cpu_restore_interrupt(flags);
+}
+
+void
+irq_run_deferred()
+{
+    struct irq_bottom_half* bh;
+    struct irq_tasklet *pos, *n;
+    struct llist_header batch;
+    int rounds = DEFERRED_MAX_ROUNDS;
+
+    // we are still in interrupt context, thus interrupt is off.
+
+    bh = __this_bottom_half();
+    if (bh->running || llist_empty(&bh->pending)) {
+        return;
+    }
+
+    bh->running = true;
+    llist_init_head(&batch);
+
+    while (rounds-- && !llist_empty(&bh->pending))
+    {
+        llist_splice(&batch, &bh->pending);
+
+        /*
+            Only we are touching the batch, interrupts that come in
+            meanwhile either find the tasklet still pending, or append
+            it to the pending list for the next round.
+         */
+        cpu_enable_interrupt();
+
+        llist_for_each(pos, n, &batch, link)
+        {
+            llist_delete(&pos->link);
+            pos->pending = false;
+            pos->fn(pos->data);
+        }
+
+        cpu_disable_interrupt();
+    }
+
+    bh->running = false;
+}
+
+bool
+irq_in_deferred()
+{
+    return __this_bottom_half()->running;
+}
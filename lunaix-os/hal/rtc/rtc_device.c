@@ -1,3 +1,4 @@
+#include <lunaix/clock.h>
 #include <lunaix/fs/twifs.h>
 #include <lunaix/fs/twimap.h>
 #include <lunaix/mm/valloc.h>
@@ -47,6 +48,7 @@ __hwrtc_ioctl(struct device* dev, u32_t req, va_list args)
         case RTCIO_SETDT:
             datetime_t* dt = va_arg(args, datetime_t*);
             ops->set_walltime(pot, dt);
+            clock_unixtime_resync();
             break;
         case RTCIO_SETFREQ:
             ticks_t* freq = va_arg(args, ticks_t*);
@@ -31,6 +31,7 @@ typedef struct
     u8_t apic_id;
     u32_t flags;
 } ACPI_TABLE_PACKED acpi_apic_t;
+#define ACPI_APIC_ENABLED       0x1
 #define __acpi_apic(acpi_ptr)   ((acpi_apic_t*)__ptr(acpi_ptr))
 
 /**
@@ -87,6 +88,9 @@ typedef struct
 {
     u32_t apic_addr;
     acpi_apic_t* apic;
+    // all usable processor local APICs, at most CONFIG_NR_CPUS
+    acpi_apic_t** lapics;
+    unsigned int lapic_count;
     acpi_ioapic_t* ioapic;
     acpi_intso_t** irq_exception;
 } ACPI_TABLE_PACKED acpi_madt_toc_t;
@@ -61,4 +61,11 @@ ahci_driver_init(struct ahci_driver_param* param);
 void
 ahci_hba_isr(irq_t irq, const struct hart_state* hstate);
 
+/**
+ * @brief Complete the commands retired by the port, the bottom half
+ * of ahci_hba_isr.
+ */
+void
+ahci_retire_cmds(void* port);
+
 #endif /* __LUNAIX_AHCI_H */
@@ -4,6 +4,7 @@
 #include <lunaix/blkio.h>
 #include <lunaix/buffer.h>
 #include <lunaix/types.h>
+#include <hal/irq.h>
 
 #define HBA_RCAP 0
 #define HBA_RGHC 1
@@ -142,12 +143,17 @@ struct hba_cmd_state
 {
     struct hba_cmdt* cmd_table;
     void* state_ctx;
+    struct llist_header retired;
 };
 
 struct hba_cmd_context
 {
     struct hba_cmd_state* issued[32];
     u32_t tracked_ci;
+
+    // done by HBA, waiting to be completed by the tasklet.
+    struct llist_header retired;
+    struct irq_tasklet retire_work;
 };
 
 struct hba_port
@@ -501,6 +501,16 @@ dt_end_find(struct dtn_iter* iter)
     // currently do nothing, keep only for semantic
 }
 
+/*
+    Hand out the current match through `matched`, then advance to the
+    next sibling satisfying the predicate. Returns false once all the
+    matches are handed out, every match is thus visited by:
+
+        dt_begin_find(&iter, node, pred, closure);
+        while (dt_find_next(&iter, &matched)) {
+            ...
+        }
+ */
 bool
 dt_find_next(struct dtn_iter* iter,
              struct dtn_base** matched);
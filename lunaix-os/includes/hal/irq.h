@@ -106,6 +106,44 @@ irq_get_default_domain();
 int
 irq_forward_install(struct irq_domain* current, irq_t irq);
 
+/*
+    Deferred part (bottom half) of an interrupt. The servant shall only
+    acknowledge the hardware and schedule a tasklet, the rest is done
+    in the tasklet with interrupt enabled, right before we leave the
+    interrupt context.
+
+    A tasklet runs on the processor that scheduled it, never nested
+    in itself, and must not sleep. Scheduling an already pending
+    tasklet is a no-op, which is what let the work to be batched.
+ */
+struct irq_tasklet
+{
+    struct llist_header link;
+    void (*fn)(void*);
+    void* data;
+    volatile bool pending;
+};
+
+void
+irq_tasklet_init(struct irq_tasklet* tasklet, void (*fn)(void*), void* data);
+
+void
+irq_tasklet_schedule(struct irq_tasklet* tasklet);
+
+/**
+ * @brief Run all the tasklets pending on current processor. Called
+ * on the way out of an interrupt, after the EOI.
+ */
+void
+irq_run_deferred();
+
+/**
+ * @brief Whether current processor is running tasklets, in which
+ * case the scheduler must keep its hands off.
+ */
+bool
+irq_in_deferred();
+
 static inline void
 irq_serve(irq_t irq, struct hart_state* state)
 {
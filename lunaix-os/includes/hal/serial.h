@@ -7,6 +7,7 @@
 #include <lunaix/ds/waitq.h>
 #include <lunaix/ds/rbuffer.h>
 #include <hal/term.h>
+#include <hal/irq.h>
 
 #include <usr/lunaix/serial.h>
 
@@ -34,6 +35,8 @@ struct serial_dev
     struct rbuffer rxbuf;
     int wr_len;
 
+    struct irq_tasklet rx_work;
+
     struct termport_potens* tp_cap;
 
     /**
@@ -7,6 +7,7 @@
 #include <lunaix/ds/waitq.h>
 #include <lunaix/ds/mutex.h>
 #include <lunaix/types.h>
+#include <lunaix/time.h>
 
 #define BLKIO_WRITE 0x1
 #define BLKIO_ERROR 0x2
@@ -39,6 +40,7 @@ struct blkio_req
     void* evt_args;
     blkio_cb completed;
     int errcode;
+    time_t committed;
 };
 
 struct blkio_context
@@ -0,0 +1,79 @@
+#ifndef __LUNAIX_BOOTTIME_H
+#define __LUNAIX_BOOTTIME_H
+
+#include <lunaix/types.h>
+#include <lunaix/compiler.h>
+
+#define BOOT_STAGE      0
+#define BOOT_INITCALL   1
+#define BOOT_DRIVER     2
+#define BOOT_MOUNT      3
+#define BOOT_STEP       4
+
+#ifdef CONFIG_BOOT_PROFILE
+
+/**
+ * @brief Mark the kernel entry, all spans are timed relative to it.
+ */
+void
+boottime_start();
+
+/**
+ * @brief Open a span on the boot timeline, to be closed with
+ * boottime_end. Either a name or the function being timed is
+ * given, the latter is resolved into symbol upon reading.
+ *
+ * @return handle of the span, negative if not recorded
+ */
+int
+boottime_begin(int kind, const char* name, ptr_t fn);
+
+void
+boottime_end(int span);
+
+/**
+ * @brief Conclude the boot timeline, nothing is recorded afterward.
+ */
+void
+boottime_finish();
+
+#else
+
+static inline void
+boottime_start()
+{
+    // nothing
+}
+
+static inline int
+boottime_begin(int kind, const char* name, ptr_t fn)
+{
+    return -1;
+}
+
+static inline void
+boottime_end(int span)
+{
+    // nothing
+}
+
+static inline void
+boottime_finish()
+{
+    // nothing
+}
+
+#endif
+
+/**
+ * @brief Time a void function call as a boot step, named after
+ * the call itself.
+ */
+#define boottime_step(call)                                                 \
+    ({                                                                      \
+        int __span = boottime_begin(BOOT_STEP, #call, 0);                   \
+        call;                                                               \
+        boottime_end(__span);                                               \
+    })
+
+#endif /* __LUNAIX_BOOTTIME_H */
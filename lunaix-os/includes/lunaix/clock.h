@@ -23,6 +23,12 @@ clock_systime();
 time_t
 clock_unixtime();
 
+/**
+ * @brief Drop the cached unix time, called when rtc is set.
+ */
+void
+clock_unixtime_resync();
+
 static inline void
 clock_init()
 {
@@ -17,6 +17,8 @@
 
 #include <usr/lunaix/device.h>
 
+struct v_file;  // <lunaix/fs.h>
+
 /**
  * @brief Export a device definition (i.e., device driver metadata)
  *
@@ -222,6 +224,14 @@ struct device
 
         int (*exec_cmd)(struct device*, u32_t, va_list);
         int (*poll)(struct device*);
+
+        // optional, for device that keeps per-opener state in
+        //  `file->data`. Once given, *_file take over their 
+        //  file-agnostic counterparts.
+        int (*open)(struct device*, struct v_file*);
+        int (*close)(struct device*, struct v_file*);
+        int (*read_file)(struct device*, struct v_file*, void*, size_t);
+        int (*poll_file)(struct device*, struct v_file*);
     } ops;
 };
 
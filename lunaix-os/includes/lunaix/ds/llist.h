@@ -73,6 +73,25 @@ llist_empty(struct llist_header* elem)
     return elem->next == elem && elem->prev == elem;
 }
 
+/**
+ * @brief Move all elements of `from` to the tail of `to`, leaving
+ * `from` empty.
+ */
+static inline void
+llist_splice(struct llist_header* to, struct llist_header* from)
+{
+    if (llist_empty(from)) {
+        return;
+    }
+
+    from->next->prev = to->prev;
+    to->prev->next = from->next;
+    from->prev->next = to;
+    to->prev = from->prev;
+
+    llist_init_head(from);
+}
+
 #define DEFINE_LLIST(name)                                                     \
     struct llist_header name = (struct llist_header)                           \
     {                                                                          \
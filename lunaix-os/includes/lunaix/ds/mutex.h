@@ -2,18 +2,45 @@
 #define __LUNAIX_MUTEX_H
 
 #include <lunaix/types.h>
+#include <lunaix/ds/waitq.h>
+#include <lunaix/ds/spinlock.h>
 #include <stdatomic.h>
 
+struct thread;
+
+/*
+    A sleeping mutex.
+
+    `lk` is the nesting depth, non-zero means held. Uncontended
+    lock/unlock is a single cmpxchg. Contenders queue up on `waiters`
+    in FIFO order and sleep, the unlocker hand the mutex over to the
+    head waiter directly (`lk` never drops to zero in between), so a
+    waiter can not be starved by late comers.
+ */
 typedef struct mutex_s
 {
     atomic_uint lk;
     pid_t owner;
+    struct thread* holder;
+    spinlock_t wait_lock;
+    waitq_t waiters;
 } mutex_t;
 
+#define DEFINE_MUTEX(name)                                          \
+    mutex_t name = {                                                \
+        .waiters = {                                                \
+            .waiters = { &name.waiters.waiters, &name.waiters.waiters } \
+        }                                                           \
+    }
+
 static inline void
 mutex_init(mutex_t* mutex)
 {
     mutex->lk = ATOMIC_VAR_INIT(0);
+    mutex->owner = 0;
+    mutex->holder = NULL;
+    spinlock_init(&mutex->wait_lock);
+    waitq_init(&mutex->waiters);
 }
 
 static inline int
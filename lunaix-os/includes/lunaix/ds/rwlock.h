@@ -1,21 +1,51 @@
 #ifndef __LUNAIX_RWLOCK_H
 #define __LUNAIX_RWLOCK_H
 
-#include "mutex.h"
+#include "spinlock.h"
 #include "waitq.h"
 #include <stdatomic.h>
 
+/*
+    Layout of rwlock_s::state
+
+        [31]     writer holding the lock
+        [30]     writer(s) waiting for the lock
+        [29:0]   number of active readers
+ */
+#define RWLOCK_WRITER           (1U << 31)
+#define RWLOCK_WRITER_WAIT      (1U << 30)
+#define RWLOCK_READERS          (RWLOCK_WRITER_WAIT - 1)
+
 typedef struct rwlock_s
 {
-    atomic_uint readers;
-    atomic_flag writer;
+    atomic_uint state;
+    bool prefer_writer;
+
+    // serialize the slow paths, keep wakeup from being lost
+    spinlock_t wait_lock;
+    unsigned int nr_wwait;
     waitq_t waiting_readers;
     waitq_t waiting_writers;
 } rwlock_t;
 
+/**
+ * @brief Initialize a writer-preferring rwlock. Once a writer
+ * start to wait, incoming readers will queue up behind it.
+ */
 void
 rwlock_init(rwlock_t* rwlock);
 
+/**
+ * @brief Let the incoming readers share the lock with the existing
+ * ones despite of waiting writers. Higher read throughput, at cost
+ * of possible writer starvation.
+ */
+static inline void
+rwlock_prefer_readers(rwlock_t* rwlock)
+{
+    rwlock->prefer_writer = false;
+}
+
 void
 rwlock_begin_read(rwlock_t* rwlock);
 
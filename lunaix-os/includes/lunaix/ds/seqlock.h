@@ -0,0 +1,63 @@
+#ifndef __LUNAIX_SEQLOCK_H
+#define __LUNAIX_SEQLOCK_H
+
+#include "spinlock.h"
+#include <stdatomic.h>
+
+/*
+    Sequence lock, for small data that is read often and seldom
+    written. Readers take no lock at all, they snapshot the sequence,
+    copy the data, and retry if a writer came in between. An odd
+    sequence means a write is in progress.
+
+    Readers must only copy the protected data out (no pointer chasing
+    into it), as they may observe a torn state before retrying.
+ */
+typedef struct seqlock
+{
+    atomic_uint seq;
+    spinlock_t lock;
+} seqlock_t;
+
+static inline void
+seqlock_init(seqlock_t* sl)
+{
+    atomic_init(&sl->seq, 0);
+    spinlock_init(&sl->lock);
+}
+
+static inline unsigned int
+read_seqbegin(seqlock_t* sl)
+{
+    unsigned int seq;
+
+    while ((seq = atomic_load_explicit(&sl->seq, memory_order_acquire)) & 1) {
+        cpu_relax();
+    }
+
+    return seq;
+}
+
+static inline bool
+read_seqretry(seqlock_t* sl, unsigned int start)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&sl->seq, memory_order_relaxed) != start;
+}
+
+static inline void
+write_seqlock(seqlock_t* sl)
+{
+    spinlock_acquire(&sl->lock);
+    atomic_fetch_add_explicit(&sl->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void
+write_sequnlock(seqlock_t* sl)
+{
+    atomic_fetch_add_explicit(&sl->seq, 1, memory_order_release);
+    spinlock_release(&sl->lock);
+}
+
+#endif /* __LUNAIX_SEQLOCK_H */
@@ -2,53 +2,208 @@
 #define __LUNAIX_SPIN_H
 
 #include <lunaix/types.h>
+#include <lunaix/compiler.h>
+#include <asm/cpu.h>
+#include <stdatomic.h>
 
+#ifdef CONFIG_LOCKSTAT
+#include <lunaix/ds/ldga.h>
+
+/**
+ * @brief Per call-site contention record. Only the site that
+ * currently holding the lock will touch the counters, so no
+ * atomic is needed.
+ */
+struct lockstat_site
+{
+    const char* file;
+    unsigned int line;
+    unsigned int acquired;
+    unsigned int contended;
+    u64_t hold_cycles;
+    u64_t max_hold;
+};
+#endif
+
+/*
+    Ticket lock: take a ticket from `next` and wait until `owner`
+    is serving it. Contenders are thus served in FIFO order.
+ */
 struct spinlock
 {
-    volatile bool flag;
+    atomic_ushort owner;
+    atomic_ushort next;
+#ifdef CONFIG_LOCKSTAT
+    struct lockstat_site* site;
+    u64_t stamp;
+#endif
 };
 
 #define DEFINE_SPINLOCK(name)   \
-    struct spinlock name = { .flag = false }
+    struct spinlock name = { .owner = 0, .next = 0 }
 
 typedef struct spinlock spinlock_t;
 
+static inline void
+spinlock_init(spinlock_t* lock)
+{
+    atomic_init(&lock->owner, 0);
+    atomic_init(&lock->next, 0);
+#ifdef CONFIG_LOCKSTAT
+    lock->site = NULL;
+#endif
+}
+
+static inline bool
+spinlock_locked(spinlock_t* lock)
+{
+    return atomic_load(&lock->owner) != atomic_load(&lock->next);
+}
+
 /*
-    TODO we might use our own construct for atomic ops
-         But we will do itlater, currently this whole 
-         kernel is on a single long thread of fate, 
-         there won't be any hardware concurrent access 
-         happened here.
-*/
+    Return true if we have to wait for our turn
+ */
+static inline bool
+__spinlock_acquire(spinlock_t* lock)
+{
+    unsigned short ticket;
+    bool contended = false;
+
+    ticket = atomic_fetch_add(&lock->next, 1);
+    while (atomic_load_explicit(&lock->owner, memory_order_acquire) != ticket)
+    {
+        contended = true;
+        cpu_relax();
+    }
+
+    return contended;
+}
+
+static inline bool
+__spinlock_try_acquire(spinlock_t* lock)
+{
+    unsigned short ticket;
+
+    ticket = atomic_load(&lock->owner);
+    return atomic_compare_exchange_strong(&lock->next, &ticket, ticket + 1);
+}
 
 static inline void
-spinlock_init(spinlock_t* lock)
+__spinlock_release(spinlock_t* lock)
 {
-    lock->flag = false;
+    // only the holder can advance owner, no need for a RMW cycle
+    unsigned short owner = atomic_load_explicit(&lock->owner,
+                                                memory_order_relaxed);
+    atomic_store_explicit(&lock->owner, owner + 1, memory_order_release);
 }
 
-static inline bool spinlock_try_acquire(spinlock_t* lock)
+#ifdef CONFIG_LOCKSTAT
+
+#define __lockstat_site()                                                   \
+    ({                                                                      \
+        static struct lockstat_site __site = {                              \
+            .file = __FILE__, .line = __LINE__                              \
+        };                                                                  \
+        static struct lockstat_site* const ldga_section("lockstat")         \
+            must_emit __site_ref = &__site;                                 \
+        &__site;                                                            \
+    })
+
+static inline void
+__lockstat_held(spinlock_t* lock, struct lockstat_site* site, bool contended)
 {
-    if (lock->flag){
-        return false;
+    site->acquired++;
+    site->contended += contended;
+
+    lock->site  = site;
+    lock->stamp = cpu_cycles();
+}
+
+static inline void
+__lockstat_release(spinlock_t* lock)
+{
+    struct lockstat_site* site = lock->site;
+    u64_t held;
+
+    if (!site) {
+        return;
+    }
+
+    held = cpu_cycles() - lock->stamp;
+    site->hold_cycles += held;
+    if (held > site->max_hold) {
+        site->max_hold = held;
     }
+    lock->site = NULL;
+}
+
+#define spinlock_acquire(lock)                                              \
+    ({                                                                      \
+        spinlock_t* __lk = (lock);                                          \
+        bool __c = __spinlock_acquire(__lk);                                \
+        __lockstat_held(__lk, __lockstat_site(), __c);                      \
+    })
+
+#define spinlock_try_acquire(lock)                                          \
+    ({                                                                      \
+        spinlock_t* __lk = (lock);                                          \
+        bool __ok = __spinlock_try_acquire(__lk);                           \
+        if (__ok) {                                                         \
+            __lockstat_held(__lk, __lockstat_site(), false);                \
+        }                                                                   \
+        __ok;                                                               \
+    })
+
+static inline void
+spinlock_release(spinlock_t* lock)
+{
+    __lockstat_release(lock);
+    __spinlock_release(lock);
+}
+
+#else
 
-    return (lock->flag = true);
+static inline void
+spinlock_acquire(spinlock_t* lock)
+{
+    __spinlock_acquire(lock);
 }
 
-static inline void spinlock_acquire(spinlock_t* lock)
+static inline bool
+spinlock_try_acquire(spinlock_t* lock)
 {
-    while (lock->flag);
-    lock->flag = true;
+    return __spinlock_try_acquire(lock);
 }
 
-static inline void spinlock_release(spinlock_t* lock)
+static inline void
+spinlock_release(spinlock_t* lock)
+{
+    __spinlock_release(lock);
+}
+
+#endif
+
+/*
+    Variants that also keep interrupt away from the critical section,
+    required if the lock is ever taken in an interrupt context.
+ */
+
+#define spinlock_acquire_irqsave(lock)                                      \
+    ({                                                                      \
+        reg_t __flags = cpu_save_interrupt();                               \
+        spinlock_acquire(lock);                                             \
+        __flags;                                                            \
+    })
+
+static inline void
+spinlock_release_irqrestore(spinlock_t* lock, reg_t flags)
 {
-    lock->flag = false;
+    spinlock_release(lock);
+    cpu_restore_interrupt(flags);
 }
 
 #define DEFINE_SPINLOCK_OPS(type, lock_accessor)                            \
     static inline void lock(type obj) { spinlock_acquire(&obj->lock_accessor); }    \
-    static inline void unlock(type obj) { spinlock_release(&obj->lock_accessor); }    
+    static inline void unlock(type obj) { spinlock_release(&obj->lock_accessor); }
 
 #endif /* __LUNAIX_SPIN_H */
@@ -43,16 +43,19 @@
 
 struct elf_ehdr;
 struct elf_phdr;
+struct elf_image;
 
 struct elf
 {
     const void* elf_file;
     struct elf_ehdr eheader;
     struct elf_phdr* pheaders;
+    struct elf_image* image;
 };
 
 #define declare_elf32(elf, elf_vfile)                                          \
-    struct elf elf = { .elf_file = elf_vfile, .pheaders = (void*)0 }
+    struct elf elf = { .elf_file = elf_vfile, .pheaders = (void*)0,            \
+                       .image = (void*)0 }
 
 int
 elf_check_exec(const struct elf* elf, int type);
@@ -84,6 +87,16 @@ elf_close(struct elf* elf);
 int
 elf_find_loader(const struct elf* elf, char* path_out, size_t len);
 
+/**
+ * @brief Path of the PT_INTERP requested, NULL if there is none. The
+ * string stay valid until the elf is closed.
+ *
+ * @param elf Opened elf32 descriptor
+ * @return const char*
+ */
+const char*
+elf_interp(const struct elf* elf);
+
 int
 elf_read_ehdr(struct elf* elf);
 
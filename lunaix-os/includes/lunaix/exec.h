@@ -5,8 +5,11 @@
 #include <lunaix/process.h>
 #include <lunaix/types.h>
 
-#define MAX_PARAM_LEN    1024
-#define MAX_PARAM_SIZE   4096
+/*
+    argv and envp, strings and pointers together, may take up to
+    1/MAX_PARAM_SHARE of the user stack.
+ */
+#define MAX_PARAM_SHARE  2
 
 #define MAX_VAR_PAGES 8
 #define DEFAULT_HEAP_PAGES 16
@@ -43,6 +46,13 @@ struct exec_host
 
     ptr_t stack_top;
 
+    // size limit of argv and envp
+    size_t param_max;
+
+    // free stack space argv and envp are staged in
+    ptr_t param_lo;
+    ptr_t param_hi;
+
     int status;
 };
 
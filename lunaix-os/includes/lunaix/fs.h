@@ -20,7 +20,13 @@
 #include <usr/lunaix/fstypes.h>
 
 #define VFS_NAME_MAXLEN 128
-#define VFS_MAX_FD 32
+
+// initial capacity of a fd table, it grows on demand
+#define VFS_FD_INIT 32
+
+// default and the hard ceiling of RLIMIT_NOFILE
+#define VFS_FD_DEFAULT_LIMIT 256
+#define VFS_MAX_FD 1024
 
 #define VFS_IFFILE       F_FILE
 #define VFS_IFDIR       (F_FILE | F_DIR    )
@@ -28,6 +34,7 @@
 #define VFS_IFSYMLINK   (F_FILE | F_SYMLINK)
 #define VFS_IFVOLDEV    (F_FILE | F_SVDEV  )
 #define VFS_IFSEQDEV    VFS_IFDEV
+#define VFS_IFPIPE      (F_FILE | F_PIPE   )
 
 // Walk, mkdir if component encountered is non-exists.
 #define VFS_WALK_MKPARENT 0x1
@@ -54,7 +61,7 @@
 #define FSTYPE_ROFS     0b00000001
 #define FSTYPE_PSEUDO   0x00000010
 
-#define TEST_FD(fd) (fd >= 0 && fd < VFS_MAX_FD)
+#define TEST_FD(fdtab, fd) ((fd) >= 0 && (unsigned int)(fd) < (fdtab)->size)
 
 #define EXPORT_FILE_SYSTEM(fs_id, init_fn)                                     \
     export_ldga_el(fs, fs_id, ptr_t, init_fn)
@@ -108,6 +115,8 @@ extern struct v_dnode* vfs_sysroot;
 typedef int (*mntops_mnt)(struct v_superblock* vsb, struct v_dnode* mount_point);
 typedef int (*mntops_umnt)(struct v_superblock* vsb);
 
+typedef int (*pcache_actor_t)(void* ctx, void* chunk, u32_t len);
+
 struct filesystem
 {
     struct llist_header fs_flat;
@@ -195,6 +204,15 @@ struct v_file_ops
     int (*seek)(struct v_file* file, size_t offset);
     int (*close)(struct v_file* file);
     int (*sync)(struct v_file* file);
+
+    // optional, report the _POLL* events currently raised on file.
+    // `poller` is non-null when it need to be notified on later events
+    int (*poll)(struct v_file* file, struct iopoller* poller);
+
+    // optional, take over `read`/`write` on sequential device, for
+    // those need to tell apart each opened file or its descriptor.
+    int (*read_file)(struct v_fd* fd, void* buffer, size_t len, size_t fpos);
+    int (*write_file)(struct v_fd* fd, void* buffer, size_t len, size_t fpos);
 };
 
 struct v_inode_ops
@@ -241,6 +259,7 @@ struct v_file
     struct v_dnode* dnode;
     struct llist_header* f_list;
     u32_t f_pos;
+    int f_options;          // FO_* given at open, shared by dups
     unsigned long ref_count;
     void* data;
     struct v_file_ops* ops; // for caching
@@ -290,6 +309,7 @@ struct v_inode
     struct hlist_node hash_list;
     struct lru_node lru;
     struct pcache* pg_cache;
+    void* exec_cache;   // parsed executable headers, see exec_cache_drop
     struct v_inode_ops* ops;
     struct v_file_ops* default_fops;
 
@@ -331,9 +351,15 @@ struct v_dnode
     void (*destruct)(struct v_dnode* dnode);
 };
 
+#define FDBITMAP_BITS   (sizeof(unsigned long) * 8)
+
 struct v_fdtable
 {
-    struct v_fd* fds[VFS_MAX_FD];
+    struct v_fd** fds;
+    unsigned long* bitmap;  // set bit: slot taken
+    unsigned int size;      // current capacity, multiple of FDBITMAP_BITS
+    unsigned int limit;     // RLIMIT_NOFILE
+    unsigned int hint;      // lowest bitmap word that may have a free bit
     mutex_t lock;   // inter-threads contention
 };
 #define lock_fdtable(fdtab)     mutex_lock(&(fdtab)->lock)
@@ -479,6 +505,17 @@ vfs_close(struct v_file* file);
 void
 vfs_free_fd(struct v_fd* fd);
 
+/**
+ * @brief Bind an opened file to a free slot in current fd table
+ *
+ * @return the installed fd, or errno on failure
+ */
+int
+vfs_install_fd(struct v_file* file, int options);
+
+int
+vfs_close_fd(int fd);
+
 int
 vfs_fsync(struct v_file* file);
 
@@ -573,6 +610,18 @@ pcache_write(struct v_inode* inode, void* data, u32_t len, u32_t fpos);
 int
 pcache_read(struct v_inode* inode, void* data, u32_t len, u32_t fpos);
 
+/**
+ * @brief Feed the cached pages covering [fpos, fpos + len) to actor,
+ *        chunk by chunk, without copying them out. The transfer stops 
+ *        at end of file, on error or when actor consumed less than
+ *        it was offered.
+ *
+ * @return number of bytes consumed by actor, or error code
+ */
+int
+pcache_read_actor(struct v_inode* inode, u32_t len, u32_t fpos,
+                  pcache_actor_t actor, void* ctx);
+
 void
 pcache_release(struct pcache* pcache);
 
@@ -707,12 +756,30 @@ xattr_addcache(struct v_inode* inode, struct v_xattr_entry* xattr);
 struct v_fdtable*
 fdtable_create();
 
-void
+int
 fdtable_copy(struct v_fdtable* dest, struct v_fdtable* src);
 
 void
 fdtable_free(struct v_fdtable* table);
 
+/**
+ * @brief Place fd_s at slot fd of fdtab (NULL to vacate it).
+ *        Caller must hold the fdtable lock, and the slot
+ *        must be within the table capacity.
+ */
+void
+fdtable_set(struct v_fdtable* fdtab, int fd, struct v_fd* fd_s);
+
+/**
+ * @brief Make sure slot fd is addressable in fdtab, expand the
+ *        table when necessary. Caller must hold the fdtable lock.
+ */
+int
+fdtable_ensure(struct v_fdtable* fdtab, int fd);
+
+int
+fdtable_setlimit(struct v_fdtable* fdtab, unsigned int limit);
+
 
 /* --- misc stuff --- */
 
@@ -758,10 +825,21 @@ check_device_node(struct v_inode* inode)
     return check_itype(inode->itype, VFS_IFDEV);
 }
 
+static inline bool
+check_pipe_node(struct v_inode* inode)
+{
+    return check_itype(inode->itype, VFS_IFPIPE);
+}
+
+/**
+ * @brief Check if node represent a sequential stream, which
+ *        is not subject to page caching.
+ *        This include the sequential device and pipe.
+ */
 static inline bool
 check_seqdev_node(struct v_inode* inode)
 {
-    return check_device_node(inode);
+    return check_device_node(inode) || check_pipe_node(inode);
 }
 
 static inline bool
@@ -16,6 +16,13 @@ struct twifs_ops
                 void* buffer,
                 size_t len,
                 size_t fpos);
+
+    // for stream nodes, which keep per-open state in file->data
+    int (*read_file)(struct v_file* file,
+                     void* buffer,
+                     size_t len,
+                     size_t fpos);
+    int (*close)(struct v_file* file);
 };
 
 struct twifs_node
@@ -36,6 +43,7 @@ struct twifs_export
 {
     char* name;
     int acl;
+    bool stream;
     struct twifs_ops ops;
 };
 
@@ -70,6 +78,13 @@ struct twimap_export
                 .ops = { .read =  __twifs_read_##name_,         \
                          .write =  __twifs_write_##name_ }}
 
+#define twifs_node_stream(name_, acl_)                      \
+        struct twifs_export __twifs_exp_##name_ =           \
+            { __twifs_export_base(name_, acl_),             \
+                .stream = true,                             \
+                .ops = { .read_file =  __twifs_read_##name_,    \
+                         .close =  __twifs_close_##name_ }}
+
 #define twimap_value_export(name_, acl_)                    \
         struct twimap_export __twimap_exp_##name_ =          \
             { __twifs_export_base(name_, acl_),             \
@@ -94,6 +109,12 @@ struct twimap_export
             twifs_export(parent, name_, data_);                        \
         })
 
+#define twifs_export_stream(parent, name_, acl_, data_)                 \
+        ({                                                              \
+            twifs_node_stream(name_, acl_);                             \
+            twifs_export(parent, name_, data_);                        \
+        })
+
 #define twimap_export_value(parent, name_, acl_, data_)                 \
         ({                                                              \
             twimap_value_export(name_, acl_);                           \
@@ -3,6 +3,8 @@
 
 #include <lunaix/types.h>
 
+struct v_file;
+
 #define twimap_index(twimap, type) ((type)__ptr((twimap)->index))
 #define twimap_data(twimap, type) ((type)__ptr((twimap)->data))
 
@@ -25,6 +27,7 @@ struct twimap
     void* buffer;
     void* data;
     size_t size_acc;
+    size_t buf_size;
     union
     {
         struct twimap_ops ops;
@@ -33,9 +36,36 @@ struct twimap
     
 };
 
+/**
+ * @brief Per-open state of a mapped file, kept in file->data. A
+ * sequential reader resumes from the last record instead of
+ * regenerating everything before `fpos`.
+ *
+ * map.index is not trusted across reads, the object it points to may
+ * be gone by then. The record is located again by its ordinal, with
+ * reset() and as many go_next().
+ */
+struct twimap_iter
+{
+    struct twimap map;
+    size_t fpos;        // file offset of the next byte to hand out
+    size_t consumed;    // bytes of map.buffer already handed out
+    unsigned long nr_record;    // go_next() taken since reset()
+    bool started;
+    bool stale;         // map.index left over from a previous read
+    bool eof;
+};
+
 int
 twimap_read(struct twimap* map, void* buffer, size_t len, size_t fpos);
 
+int
+twimap_read_file(struct twimap* map, struct v_file* file, 
+                 void* buffer, size_t len, size_t fpos);
+
+int
+twimap_close_file(struct v_file* file);
+
 void
 twimap_printf(struct twimap* mapping, const char* fmt, ...);
 
@@ -19,6 +19,11 @@
 #define PKT_RELEASE 0x2
 // vector (e.g. mice wheel scroll, mice maneuver)
 #define PKT_VECTOR 0x3
+// reader lagged behind, `scan_code` events are lost (synthetic)
+#define PKT_OVERFLOW 0x4
+
+// events buffered for each reader, must be power of 2
+#define INPUT_RING_SIZE 64
 
 #define EXPORT_INPUT_DEV(id, init_fn)                                          \
     export_ldga_el(inputdev, id, ptr_t, init_fn)
@@ -36,6 +41,23 @@ struct input_device
     struct device* dev_if;            // device interface
     struct input_evt_pkt current_pkt; // recieved event packet
     waitq_t readers;                  // reader wait queue
+    struct llist_header reader_list;  // opened files, see input_reader
+    unsigned int dropped;             // total events lost by readers
+};
+
+/*
+    Each opened file of input device get its own event ring, so that
+    bursts are buffered rather than overwritten, and one slow reader
+    does not steal events from the others.
+ */
+struct input_reader
+{
+    struct llist_header link;
+    struct input_device* idev;
+    volatile unsigned int head;       // written by input_fire_event
+    volatile unsigned int tail;       // consumed by reader
+    unsigned int overflow;            // lost since last read
+    struct input_evt_pkt ring[INPUT_RING_SIZE];
 };
 
 typedef int (*input_evt_cb)(struct input_device* dev);
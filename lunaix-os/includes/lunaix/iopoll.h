@@ -3,6 +3,8 @@
 
 #include <lunaix/device.h>
 #include <lunaix/ds/llist.h>
+#include <lunaix/ds/mutex.h>
+#include <lunaix/ds/waitq.h>
 
 #include <usr/lunaix/poll.h>
 
@@ -19,17 +21,34 @@ struct poll_opts
     int timeout;
 };
 
+struct iopoll;
+
 struct iopoller
 {
     poll_evt_q evt_listener;
+    struct llist_header ready;  // linked to iopoll::ready when signaled
+    struct iopoll* ctx;
     struct v_file* file_ref;
-    struct thread* thread;
+    int pld;
+    short events;               // interested events
+    int flags;                  // _POLLEE_*
 };
 
+/*
+    Per-process poll instance. Event sources push the listening
+    pollers onto `ready` through iopoll_wake_pollers(), so a wait
+    only examines those that have been signaled.
+ */
 struct iopoll
 {
     struct iopoller** pollers;
     int n_poller;
+    int size;
+
+    mutex_t lock;
+    struct llist_header ready;
+    unsigned int wake_seq;
+    waitq_t waiters;
 };
 
 static inline void
@@ -0,0 +1,44 @@
+#ifndef __LUNAIX_KSTATS_H
+#define __LUNAIX_KSTATS_H
+
+#include <lunaix/ds/ldga.h>
+#include <lunaix/fs/twimap.h>
+#include <lunaix/spike.h>
+#include <usr/lunaix/kstats.h>
+
+typedef void (*kstat_fn)(struct twimap* map);
+
+/**
+ * @brief Contribute a record to /kstats. The provider emits exactly
+ * one record, bracketed by kstat_begin() and kstat_end().
+ */
+#define EXPORT_KSTAT(label, provider)                                   \
+    export_ldga_el(kstats, label, ptr_t, provider)
+
+/**
+ * @brief Start a record, returns its offset in the map's buffer, to
+ * be handed to kstat_end() after all entries are appended.
+ */
+size_t
+kstat_begin(struct twimap* map, int type, size_t ent_size);
+
+static inline void
+kstat_put(struct twimap* map, const void* ent, size_t ent_size)
+{
+    twimap_memappend(map, ent, ent_size);
+}
+
+void
+kstat_end(struct twimap* map, size_t rec_off);
+
+static inline int
+kstat_lat_bucket(unsigned long lat)
+{
+    if (!lat) {
+        return 0;
+    }
+
+    return MIN((int)ilog2(lat) + 1, KSTAT_LAT_BUCKETS - 1);
+}
+
+#endif /* __LUNAIX_KSTATS_H */
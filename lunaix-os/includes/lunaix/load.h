@@ -7,4 +7,11 @@
 int
 load_executable(struct load_context* context, const struct v_file* exefile);
 
+/**
+ * @brief Drop the executable metadata parsed from the inode, called
+ * whenever its content may have changed. Inode must be locked.
+ */
+void
+exec_cache_drop(struct v_inode* inode);
+
 #endif /* __LUNAIX_LOAD_H */
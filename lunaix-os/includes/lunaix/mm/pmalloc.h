@@ -25,6 +25,9 @@ struct pmpool
     struct ppage* last;
     struct pmpool_ops ops;
 
+    unsigned long nr_used;
+    unsigned long nr_fails;
+
     union {
         struct pm_allocator alloc_private[0];
         unsigned char __pad[128];
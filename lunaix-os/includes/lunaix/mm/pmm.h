@@ -75,6 +75,15 @@ static inline struct ppage*
 pmm_try_alloc_one(int order, struct pmalloc_pol* policy)
 {
     struct pmpool* pool = policy->src_pool;
-    return pool->ops.alloc_page(order, policy);
+    struct ppage* page;
+    
+    page = pool->ops.alloc_page(order, policy);
+    if (unlikely(!page)) {
+        pool->nr_fails++;
+        return NULL;
+    }
+
+    pool->nr_used += 1 << order;
+    return page;
 }
 #endif /* __LUNAIX_PMM_H */
@@ -2,6 +2,7 @@
 #define __LUNAIX_OWLOYSIUS_H
 
 #include <lunaix/ds/ldga.h>
+#include <lunaix/boottime.h>
 
 /**
  * @brief stage where only basic memory management service
@@ -33,7 +34,26 @@
     export_ldga_el(lunainit, func, ptr_t, func);                            \
     export_ldga_el_sfx(lunainit, func##_##call_stage, ptr_t, func, call_stage);
 
-#define invoke_init_function(stage) ldga_invoke_fn0(lunainit##_##stage)
+#define __invoke_init_function(ga_name, name)                               \
+    ({                                                                      \
+        int i = 0, __stage, __init;                                         \
+        ptr_t fn0;                                                          \
+        __stage = boottime_begin(BOOT_STAGE, name, 0);                      \
+        ldga_foreach(ga_name, ptr_t, i, fn0)                                \
+        {                                                                   \
+            __init = boottime_begin(BOOT_INITCALL, NULL, fn0);              \
+            ((void (*)())fn0)();                                            \
+            boottime_end(__init);                                           \
+        }                                                                   \
+        boottime_end(__stage);                                              \
+    })
+
+/**
+ * @brief Invoke the init functions of the stage, each of them is
+ * timed on the boot timeline.
+ */
+#define invoke_init_function(stage)                                         \
+    __invoke_init_function(lunainit##_##stage, #stage)
 
 static inline void
 initfn_invoke_sysconf()
@@ -0,0 +1,49 @@
+#ifndef __LUNAIX_PERCPU_H
+#define __LUNAIX_PERCPU_H
+
+#include <lunaix/types.h>
+#include <lunaix/ds/llist.h>
+#include <asm/percpu.h>
+
+struct thread;
+struct proc_info;
+
+/**
+ * @brief Kernel states private to a processor.
+ * 
+ * The first few fields are accessed by arch-specific interrupt
+ * code, see asm/percpu.h before touching the layout.
+ */
+struct cpu_local
+{
+    struct cpu_local* self;
+    volatile struct thread* thread;
+    volatile struct proc_info* proc;
+    struct arch_percpu arch;
+
+    unsigned int id;        // logical id, boot processor is always 0
+    unsigned int hwid;      // hardware id, e.g., x86 local APIC id
+    volatile bool online;
+
+    struct thread* idle;
+    struct llist_header* runq;
+    unsigned int nr_threads;    // length of runq, for load balancing
+    bool klocked;               // holding the kernel lock, see sched.c
+    bool slice_over;            // switch away on interrupt exit
+};
+
+extern struct cpu_local cpu_locals[CONFIG_NR_CPUS];
+extern unsigned int nr_cpus;
+
+#define cpu_local(id)       (&cpu_locals[(id)])
+
+#define for_each_cpu(cpu)   \
+    for (cpu = cpu_locals; cpu < &cpu_locals[nr_cpus]; cpu++)
+
+static inline unsigned int
+this_cpu_id()
+{
+    return this_cpu()->id;
+}
+
+#endif /* __LUNAIX_PERCPU_H */
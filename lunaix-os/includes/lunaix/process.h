@@ -14,6 +14,7 @@
 #include <lunaix/spike.h>
 #include <lunaix/hart_state.h>
 #include <lunaix/usrscope.h>
+#include <lunaix/percpu.h>
 
 #include <usr/lunaix/wait.h>
 
@@ -65,6 +66,9 @@ ANY STATE ----> TERMINAT
 #define thread_flags_test(th, flag)     ((th)->flags & (flag))
 #define thread_flags_test_all(th, flag) (((th)->flags & (flag)) == (flag))
 
+// longest command line kept in proc_info, the rest of argv is cut off
+#define PROC_CMD_MAXLEN     4096
+
 struct proc_sig
 {
     int sig_num;
@@ -82,6 +86,9 @@ struct haybed {
     time_t alarm_time;
 };
 
+#define SCHED_LAT_BUCKETS   16
+#define SCHED_LAT_SHIFT     14
+
 struct thread_stats
 {
     // number of times the thread entering kernel space involuntarily
@@ -101,6 +108,29 @@ struct thread_stats
     time_t last_leave;
     // timestamp of last time the thread is resumed
     time_t last_resume;
+
+    /* scheduler accounting, see schedstat.c */
+
+    // since when it is runnable but not running, in cycles (0 if not)
+    u64_t ready_since;
+    // since when it is running
+    time_t run_since;
+    // since when it is blocked on a waitqueue
+    time_t wait_since;
+    // when it is detached from the waitqueue by pwake, in ms and cycles
+    time_t woken_at;
+    u64_t woken_cycles;
+
+    // total time on cpu and blocked on waitqueue
+    time_t cpu_time;
+    time_t wait_time;
+
+    // switched out by blocking, or by being preempted
+    unsigned long nr_vol_switch;
+    unsigned long nr_invol_switch;
+
+    // runnable-to-running latency, log2 buckets in cycles
+    unsigned int lat_hist[SCHED_LAT_BUCKETS];
     
     union {
         struct {
@@ -143,9 +173,11 @@ struct thread
 
     struct proc_info* process;
     struct llist_header proc_sibs;  // sibling to process-local threads
-    struct llist_header sched_sibs; // sibling to scheduler (global) threads
+    struct llist_header sched_sibs; // sibling to per-cpu run queue
+    struct cpu_local* cpu;          // whose run queue we are on
     struct sigctx sigctx;
     waitq_t waitqueue;
+    ptr_t futex_key;                // futex being waited on, if any
 };
 
 struct proc_info
@@ -180,6 +212,10 @@ struct proc_info
         int exit_code;
     };
 
+    // processor that all threads of the process run on, changes to the
+    //  user address space thus never need a TLB shootdown.
+    struct cpu_local* cpu;
+
     struct proc_mm* mm;
     struct sigregistry* sigreg;
     struct v_fdtable* fdtable;
@@ -190,10 +226,16 @@ struct proc_info
     };
 
     struct iopoll pollctx;
+
+    // per-process syscall counters, see syscallstat.c
+    struct syscall_pstat* sysstats;
 };
 
-extern volatile struct proc_info* __current;
-extern volatile struct thread* current_thread;
+/*
+    Thread and process currently executing on this processor
+ */
+#define current_thread      (this_cpu()->thread)
+#define __current           (this_cpu()->proc)
 
 /**
  * @brief Check if current process belong to kernel itself
@@ -0,0 +1,36 @@
+#ifndef __LUNAIX_PROFILER_H
+#define __LUNAIX_PROFILER_H
+
+#include <lunaix/types.h>
+#include <lunaix/compiler.h>
+
+#ifdef CONFIG_PROFILER
+
+extern volatile bool profiler_enabled;
+
+void
+__profiler_sample();
+
+/**
+ * @brief Take a sample of the interrupted context, called from the
+ * timer tick of every processor.
+ */
+static inline void
+profiler_tick()
+{
+    if (unlikely(profiler_enabled)) {
+        __profiler_sample();
+    }
+}
+
+#else
+
+static inline void
+profiler_tick()
+{
+    // nothing
+}
+
+#endif
+
+#endif /* __LUNAIX_PROFILER_H */
@@ -13,7 +13,6 @@
 struct scheduler
 {
     struct proc_info** procs;
-    struct llist_header* threads;
     struct llist_header* proc_list;
     struct llist_header sleepers;
 
@@ -25,13 +24,50 @@ struct scheduler
 void
 sched_init();
 
+void
+sched_init_cpu(struct cpu_local* cpu);
+
+void
+sched_start_cpus();
+
+/**
+ * @brief Take the big kernel lock, if this processor does not have
+ * it yet. Interrupt must be disabled.
+ */
+void
+kernel_lock();
+
+void
+kernel_unlock();
+
 void noret
 schedule();
 
+/**
+ * @brief Switch away if the time slice of current processor is over.
+ * Called on the way out of an interrupt, after the EOI and tasklets.
+ */
+void
+sched_preempt_point();
+
 void noret
 run(struct thread* thread);
 
 void
 cleanup_detached_threads();
 
+/**
+ * @brief Account the switch from `prev` to `next`, called right
+ * before the context switch. `prev` might be NULL or equal to `next`.
+ */
+void
+sched_stat_switch(struct thread* prev, struct thread* next);
+
+/**
+ * @brief The thread become runnable, after being blocked on a waitqueue
+ * or put into sleep, or just born.
+ */
+void
+sched_stat_woken(struct thread* thread);
+
 #endif /* __LUNAIX_SCHEDULER_H */
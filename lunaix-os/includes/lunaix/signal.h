@@ -17,6 +17,7 @@
 #define _SIGSTOP SIGSTOP
 #define _SIGCONT SIGCONT
 #define _SIGTERM SIGTERM
+#define _SIGPIPE SIGPIPE
 #define _SIG_BLOCK SIG_BLOCK
 #define _SIG_UNBLOCK SIG_UNBLOCK
 #define _SIG_SETMASK SIG_SETMASK
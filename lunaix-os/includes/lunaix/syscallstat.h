@@ -0,0 +1,82 @@
+#ifndef __LUNAIX_SYSCALLSTAT_H
+#define __LUNAIX_SYSCALLSTAT_H
+
+#include <lunaix/types.h>
+#include <lunaix/compiler.h>
+
+#include <asm/cpu.h>
+
+struct proc_info;
+
+/*
+    per-process counters, only kept while switched on through
+    /syscall/per_process
+ */
+struct syscall_pstat
+{
+    unsigned long calls;
+    u64_t cycles;
+};
+
+#ifdef CONFIG_SYSCALL_STATS
+
+/**
+ * @brief Stamp the entry of a syscall.
+ */
+static inline u64_t
+syscall_stat_enter()
+{
+    return cpu_cycles();
+}
+
+/**
+ * @brief Charge the syscall `nr` entered at `stamp`, called with
+ * preemption off.
+ */
+void
+syscall_stat_leave(unsigned int nr, u64_t stamp, reg_t retval);
+
+void
+syscall_stat_attach(struct proc_info* proc);
+
+void
+syscall_stat_detach(struct proc_info* proc);
+
+void
+syscall_stat_export_taskfs();
+
+#else
+
+static inline u64_t
+syscall_stat_enter()
+{
+    return 0;
+}
+
+static inline void
+syscall_stat_leave(unsigned int nr, u64_t stamp, reg_t retval)
+{
+    // nothing
+}
+
+static inline void
+syscall_stat_attach(struct proc_info* proc)
+{
+    // nothing
+}
+
+static inline void
+syscall_stat_detach(struct proc_info* proc)
+{
+    // nothing
+}
+
+static inline void
+syscall_stat_export_taskfs()
+{
+    // nothing
+}
+
+#endif
+
+#endif /* __LUNAIX_SYSCALLSTAT_H */
@@ -12,8 +12,8 @@
 struct lx_timer
 {
     struct llist_header link;
-    ticks_t deadline;
-    ticks_t counter;
+    ticks_t deadline;       // ticks to wait for, 0 if cancelled
+    ticks_t armed;          // tick at which it is (re-)armed
     void* payload;
     void (*callback)(void*);
     u8_t flags;
@@ -42,4 +42,11 @@ timer_run_ms(u32_t millisecond,
 struct lx_timer*
 timer_run(ticks_t ticks, void (*callback)(void*), void* payload, u8_t flags);
 
+/**
+ * @brief Disarm a timer that is yet to fire, it is reclaimed on the
+ * next tick. The timer must not be touched after this call.
+ */
+void
+timer_cancel(struct lx_timer* timer);
+
 #endif /* __LUNAIX_TIMER_H */
@@ -0,0 +1,56 @@
+#ifndef __LUNAIX_TRACEPOINT_H
+#define __LUNAIX_TRACEPOINT_H
+
+#include <lunaix/types.h>
+#include <lunaix/compiler.h>
+#include <usr/lunaix/tracepoint.h>
+
+struct tracepoint
+{
+    const char* name;
+    unsigned short id;
+    volatile bool enabled;
+};
+
+#define __tracepoint(name_)     __tp_##name_
+
+#ifdef CONFIG_TRACEPOINTS
+#include <lunaix/ds/ldga.h>
+
+/**
+ * @brief Define a tracepoint, visible in /trace/events. Use
+ * DECLARE_TRACEPOINT to fire it from other compilation units.
+ */
+#define DEFINE_TRACEPOINT(name_)                                            \
+    struct tracepoint __tracepoint(name_) = { .name = stringify(name_) };   \
+    static struct tracepoint* const ldga_section("tracepoints")             \
+        must_emit __tp_ref_##name_ = &__tracepoint(name_)
+
+#define DECLARE_TRACEPOINT(name_)                                           \
+    extern struct tracepoint __tracepoint(name_)
+
+/**
+ * @brief Fire the tracepoint, costs a single branch when disabled.
+ */
+#define trace_event(name_, arg0, arg1)                                      \
+    do {                                                                    \
+        if (unlikely(__tracepoint(name_).enabled)) {                        \
+            __trace_emit(&__tracepoint(name_),                              \
+                         (unsigned long)(arg0), (unsigned long)(arg1));     \
+        }                                                                   \
+    } while (0)
+
+void
+__trace_emit(struct tracepoint* tp, unsigned long arg0, unsigned long arg1);
+
+#else
+
+#define DEFINE_TRACEPOINT(name_)                                            \
+    extern struct tracepoint __tracepoint(name_)
+#define DECLARE_TRACEPOINT(name_)                                           \
+    extern struct tracepoint __tracepoint(name_)
+#define trace_event(name_, arg0, arg1)      do { } while (0)
+
+#endif
+
+#endif /* __LUNAIX_TRACEPOINT_H */
@@ -0,0 +1,123 @@
+#ifndef __LUNAIX_WORKQUEUE_H
+#define __LUNAIX_WORKQUEUE_H
+
+#include <lunaix/ds/llist.h>
+#include <lunaix/ds/spinlock.h>
+#include <lunaix/ds/waitq.h>
+#include <lunaix/timer.h>
+#include <lunaix/types.h>
+
+struct work;
+typedef void (*work_fn)(struct work*);
+
+struct work
+{
+    struct llist_header link;
+    work_fn fn;
+    struct workqueue* wq;
+    volatile bool pending;
+};
+
+struct delayed_work
+{
+    struct work work;
+    struct lx_timer* timer;
+};
+
+/**
+ * @brief A queue of works served by a pool of kernel threads. The
+ * pool starts with one worker, and another is spawned whenever a
+ * worker finds backlog but no one idle, up to `max_workers`.
+ */
+struct workqueue
+{
+    const char* name;
+    spinlock_t lock;
+
+    struct llist_header pending;
+    struct llist_header workers;
+
+    waitq_t idle;
+    waitq_t flushers;
+
+    int nr_workers;
+    int nr_idle;
+    int nr_busy;
+    int max_workers;
+};
+
+/**
+ * @brief The shared queue, for those do not bother to have their own.
+ * Available since postboot.
+ */
+extern struct workqueue* system_wq;
+
+static inline void
+work_init(struct work* work, work_fn fn)
+{
+    llist_init_head(&work->link);
+    work->fn = fn;
+    work->wq = NULL;
+    work->pending = false;
+}
+
+static inline void
+delayed_work_init(struct delayed_work* dwork, work_fn fn)
+{
+    work_init(&dwork->work, fn);
+    dwork->timer = NULL;
+}
+
+#define to_delayed_work(work_ptr)   \
+    container_of(work_ptr, struct delayed_work, work)
+
+/**
+ * @brief Create a workqueue, must be called from the kernel process
+ * as the workers are kernel threads.
+ */
+struct workqueue*
+workqueue_create(const char* name, int max_workers);
+
+/**
+ * @brief Queue the work, safe to call in interrupt context.
+ *
+ * @return false if the work is already pending.
+ */
+bool
+queue_work(struct workqueue* wq, struct work* work);
+
+/**
+ * @brief Queue the work after `ms` milliseconds.
+ *
+ * @return false if the work is already pending or armed.
+ */
+bool
+queue_delayed_work(struct workqueue* wq,
+                   struct delayed_work* dwork, u32_t ms);
+
+/**
+ * @brief Take back the work if it is not yet picked by a worker,
+ * does not wait for it to finish if it is.
+ *
+ * @return true if the work was pending.
+ */
+bool
+cancel_work(struct work* work);
+
+bool
+cancel_delayed_work(struct delayed_work* dwork);
+
+/**
+ * @brief Wait until the work is neither pending nor running.
+ */
+void
+flush_work(struct work* work);
+
+/**
+ * @brief Wait until the queue has drained and all its workers are
+ * idle. Must not be called from a worker of the same queue.
+ */
+void
+flush_workqueue(struct workqueue* wq);
+
+#endif /* __LUNAIX_WORKQUEUE_H */
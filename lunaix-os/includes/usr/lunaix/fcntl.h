@@ -11,9 +11,13 @@
 #define FO_RDONLY               0x10
 #define FO_RDWR                 0x20
 #define FO_TRUNC                0x40
+#define FO_NONBLOCK             0x80
 
 #define FO_NOFOLLOW             0x10000
 
+/* Largest write to a pipe that is guaranteed to be atomic */
+#define PIPE_BUF                4096
+
 #define FSEEK_SET               0x1
 #define FSEEK_CUR               0x2
 #define FSEEK_END               0x3
@@ -25,6 +29,7 @@
 #define O_RDONLY                FO_RDONLY
 #define O_RDWR                  FO_RDWR
 #define O_TRUNC                 FO_TRUNC
+#define O_NONBLOCK              FO_NONBLOCK
 
 #define AT_SYMLINK_FOLLOW       0b0000
 #define AT_SYMLINK_NOFOLLOW     0b0001
@@ -0,0 +1,13 @@
+#ifndef _LUNAIX_UHDR_FUTEX_H
+#define _LUNAIX_UHDR_FUTEX_H
+
+/* sleep if *uaddr == val */
+#define FUTEX_WAIT          0
+
+/* wake at most val waiters of uaddr */
+#define FUTEX_WAKE          1
+
+/* wake at most val waiters of uaddr, move at most val2 of the rest to uaddr2 */
+#define FUTEX_REQUEUE       2
+
+#endif /* _LUNAIX_UHDR_FUTEX_H */
@@ -0,0 +1,119 @@
+#ifndef _LUNAIX_UHDR_KSTATS_H
+#define _LUNAIX_UHDR_KSTATS_H
+
+/*
+    Binary layout of /kstats.
+
+    The file starts with a kstat_header, followed by one record per
+    subsystem till the end of file. Each record has a kstat_record
+    header and `nr_ents` entries of `ent_size` bytes each. Readers
+    shall skip unknown record types by `size`, and treat entries
+    larger than they expect as extended with new fields at the end.
+*/
+
+#define KSTAT_MAGIC         0x5453584cU     // "LXST"
+#define KSTAT_VERSION       2
+
+#define KSTAT_NAME_LEN      32
+#define KSTAT_LAT_BUCKETS   12
+#define KSTAT_CYC_BUCKETS   16
+
+#define KSTAT_CAKE          1
+#define KSTAT_PMM           2
+#define KSTAT_LRU           3
+#define KSTAT_BLKIO         4
+#define KSTAT_SCHED         5
+#define KSTAT_SYSCALL       6
+
+struct kstat_header
+{
+    unsigned int magic;
+    unsigned short version;
+    unsigned short hdr_size;
+    unsigned long long timestamp;   // ms since boot
+};
+
+struct kstat_record
+{
+    unsigned short type;
+    unsigned short version;
+    unsigned int size;              // including this header
+    unsigned int nr_ents;
+    unsigned int ent_size;
+};
+
+struct kstat_cake_ent
+{
+    char name[KSTAT_NAME_LEN];
+    unsigned int piece_size;
+    unsigned int cakes;
+    unsigned int pages_per_cake;
+    unsigned int pieces_per_cake;
+    unsigned int alloced;
+};
+
+struct kstat_pmm_ent
+{
+    unsigned int pool;
+    unsigned int type;
+    unsigned int total_pages;
+    unsigned int used_pages;
+    unsigned int nr_fails;
+};
+
+struct kstat_lru_ent
+{
+    char name[KSTAT_NAME_LEN];
+    unsigned int objects;
+    unsigned int hotness;
+    unsigned int n_single;
+    unsigned int n_half;
+    unsigned int n_full;
+};
+
+/*
+    Latency histograms are in millisecond, bucket i (i > 0) counts
+    latency within [2^(i-1), 2^i), the last bucket takes the rest.
+*/
+
+struct kstat_blkio_ent
+{
+    unsigned long long nr_reads;
+    unsigned long long nr_writes;
+    unsigned long long nr_errors;
+    unsigned int lat_hist[KSTAT_LAT_BUCKETS];
+};
+
+/*
+    Run queue latency histogram is in TSC cycles, bucket 0 counts
+    latency below 2^14, bucket i (i > 0) within [2^(i+13), 2^(i+14)),
+    the last bucket takes the rest.
+*/
+
+struct kstat_sched_ent
+{
+    unsigned long long nr_switch;
+    unsigned long long nr_vol;
+    unsigned long long nr_invol;
+    unsigned int lat_hist[KSTAT_CYC_BUCKETS];
+};
+
+/*
+    Syscall latency histograms are in TSC cycles, bucket 0 counts
+    latency below 2^8, bucket i (i > 0) within [2^(i+7), 2^(i+8)),
+    the last bucket takes the rest. One entry per syscall ever made.
+*/
+
+struct kstat_syscall_ent
+{
+    char name[KSTAT_NAME_LEN];
+    unsigned int nr;
+    unsigned int __reserved;
+    unsigned long long calls;
+    unsigned long long errors;
+    unsigned long long cycles;
+    unsigned long long max_cycles;
+    unsigned int lat_hist[KSTAT_CYC_BUCKETS];
+};
+
+#endif /* _LUNAIX_UHDR_KSTATS_H */
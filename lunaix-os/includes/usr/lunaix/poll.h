@@ -21,8 +21,12 @@ struct poll_info
 #define _SPOLL_RM 1
 #define _SPOLL_WAIT 2
 #define _SPOLL_WAIT_ANY 3
+#define _SPOLL_MOD 4
+#define _SPOLL_WAIT_READY 5
 
 #define _POLLEE_ALWAYS 1
 #define _POLLEE_RM_ON_ERR (1 << 1)
+#define _POLLEE_EDGE (1 << 2)
+#define _POLLEE_ONESHOT (1 << 3)
 
 #endif /* _LUNAIX_UHDR_UPOLL_H */
@@ -0,0 +1,15 @@
+#ifndef _LUNAIX_UHDR_RESOURCE_H
+#define _LUNAIX_UHDR_RESOURCE_H
+
+/* Max number of fd a process can open */
+#define RLIMIT_NOFILE   0
+
+typedef unsigned long rlim_t;
+
+struct rlimit
+{
+    rlim_t rlim_cur;
+    rlim_t rlim_max;
+};
+
+#endif /* _LUNAIX_UHDR_RESOURCE_H */
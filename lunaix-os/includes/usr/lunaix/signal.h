@@ -14,6 +14,7 @@
 #define SIGTERM 8
 #define SIGILL 9
 #define SIGSYS 10
+#define SIGPIPE 11
 
 #define SIG_BLOCK 1
 #define SIG_UNBLOCK 2
@@ -31,5 +31,7 @@
 #define EDQUOT              -32
 #define EPERM               -33
 #define EACCESS             -34
+#define EPIPE               -35
+#define ESPIPE              -36
 
 #endif /* _LUNAIX_UHDR_STATUS_H */
@@ -0,0 +1,26 @@
+#ifndef _LUNAIX_UHDR_TRACEPOINT_H
+#define _LUNAIX_UHDR_TRACEPOINT_H
+
+/*
+    Binary layout of /trace/buffer, a stream of tracepoint_record. The
+    meaning of `id` is listed in /trace/list, as "<id> <name> <on>".
+*/
+
+// records dropped as the reader was lapped, arg0 is the count.
+#define TRACE_ID_LOST       0xffff
+
+struct tracepoint_record
+{
+    unsigned long long cycles;
+    unsigned long long arg0;
+    unsigned long long arg1;
+    unsigned int seq;
+    unsigned short id;
+    unsigned short cpu;
+    int pid;
+    int tid;
+    unsigned int time;              // ms since boot
+    unsigned int __reserved;
+};
+
+#endif /* _LUNAIX_UHDR_TRACEPOINT_H */
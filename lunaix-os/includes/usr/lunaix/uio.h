@@ -0,0 +1,12 @@
+#ifndef _LUNAIX_UHDR_UIO_H
+#define _LUNAIX_UHDR_UIO_H
+
+#define IOV_MAX     1024
+
+struct iovec
+{
+    void* iov_base;
+    unsigned long iov_len;
+};
+
+#endif /* _LUNAIX_UHDR_UIO_H */
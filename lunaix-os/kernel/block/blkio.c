@@ -2,13 +2,26 @@
 #include <lunaix/syslog.h>
 #include <lunaix/mm/cake.h>
 #include <lunaix/mm/valloc.h>
+#include <lunaix/clock.h>
+#include <lunaix/kstats.h>
+#include <lunaix/tracepoint.h>
 
 #include <asm/cpu.h>
 
 static struct cake_pile* blkio_reqpile;
 
+static struct {
+    unsigned long nr_reads;
+    unsigned long nr_writes;
+    unsigned long nr_errors;
+    unsigned int lat_hist[KSTAT_LAT_BUCKETS];
+} blkio_stats;
+
 LOG_MODULE("blkio")
 
+DEFINE_TRACEPOINT(blkio_submit);
+DEFINE_TRACEPOINT(blkio_complete);
+
 void
 blkio_init()
 {
@@ -88,6 +101,9 @@ blkio_commit(struct blkio_req* req, int options)
     assert(req->io_ctx);
 
     req->flags |= BLKIO_PENDING;
+    req->committed = clock_systime();
+
+    trace_event(blkio_submit, req, req->blk_addr);
     
     if ((options & BLKIO_WAIT)) {
         req->flags |= BLKIO_SHOULD_WAIT;
@@ -159,6 +175,26 @@ blkio_schedule(struct blkio_context* ctx)
     ctx->handle_one(head);
 }
 
+static inline void
+__blkio_account(struct blkio_req* req)
+{
+    time_t lat;
+
+    if ((req->flags & BLKIO_WRITE)) {
+        blkio_stats.nr_writes++;
+    }
+    else {
+        blkio_stats.nr_reads++;
+    }
+
+    if (req->errcode) {
+        blkio_stats.nr_errors++;
+    }
+
+    lat = clock_systime() - req->committed;
+    blkio_stats.lat_hist[kstat_lat_bucket(lat)]++;
+}
+
 void
 blkio_complete(struct blkio_req* req)
 {
@@ -167,6 +203,9 @@ blkio_complete(struct blkio_req* req)
     ctx = req->io_ctx;
     req->flags &= ~(BLKIO_BUSY | BLKIO_PENDING);
 
+    __blkio_account(req);
+    trace_event(blkio_complete, req, req->errcode);
+
     // Wake all blocked processes on completion,
     //  albeit should be no more than one process in everycase (by design)
     if ((req->flags & BLKIO_SHOULD_WAIT)) {
@@ -189,3 +228,25 @@ blkio_complete(struct blkio_req* req)
 
     ctx->busy--;
 }
+
+static void
+__kstat_blkio(struct twimap* map)
+{
+    struct kstat_blkio_ent ent;
+    size_t rec;
+
+    ent = (struct kstat_blkio_ent) {
+        .nr_reads = blkio_stats.nr_reads,
+        .nr_writes = blkio_stats.nr_writes,
+        .nr_errors = blkio_stats.nr_errors
+    };
+
+    for (int i = 0; i < KSTAT_LAT_BUCKETS; i++) {
+        ent.lat_hist[i] = blkio_stats.lat_hist[i];
+    }
+
+    rec = kstat_begin(map, KSTAT_BLKIO, sizeof(ent));
+    kstat_put(map, &ent, sizeof(ent));
+    kstat_end(map, rec);
+}
+EXPORT_KSTAT(blkio, __kstat_blkio);
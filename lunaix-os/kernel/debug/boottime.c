@@ -0,0 +1,207 @@
+/**
+ * @file boottime.c
+ * @brief Boot timeline, timing the init functions, driver loading and
+ *        mounting from the kernel entry up to the exec of init.
+ *
+ * Spans are stamped with the TSC into a static table, as recording
+ * begins before the allocators are usable. Bootstrapping is serial
+ * up until the first user process, so neither lock nor per-CPU
+ * tracking is needed. Spans nest, each one remembers how deep it was
+ * opened, stages therefore enclose their init functions.
+ *
+ * Exported to twifs:
+ *      /boottime/timeline  "<start> <length> <depth> <kind> <name>"
+ *      /boottime/summary   time took to reach init, spans recorded
+ *
+ * Time is given in thousands of cycles, which leaves a boot of
+ * several minutes within 32 bits. Start of a span is counted from
+ * the kernel entry.
+ */
+
+#include <lunaix/boottime.h>
+#include <lunaix/trace.h>
+#include <lunaix/spike.h>
+#include <lunaix/fs/twifs.h>
+#include <lunaix/fs/twimap.h>
+
+#include <asm/cpu.h>
+#include <asm/muldiv64.h>
+
+#include <klibc/string.h>
+
+#define BOOTTIME_MAX_SPANS  512
+#define BOOTTIME_NAME_LEN   32
+
+struct boottime_span
+{
+    u64_t start;
+    u64_t cycles;
+    ptr_t fn;
+    char name[BOOTTIME_NAME_LEN];
+    unsigned char kind;
+    unsigned char depth;
+};
+
+static struct boottime_span spans[BOOTTIME_MAX_SPANS];
+static unsigned int nr_spans = 0;
+static unsigned int dropped = 0;
+static unsigned int depth = 0;
+static u64_t boot_base = 0;
+static u64_t boot_done = 0;
+
+static const char* kind_names[] = {
+    [BOOT_STAGE]    = "stage",
+    [BOOT_INITCALL] = "init",
+    [BOOT_DRIVER]   = "driver",
+    [BOOT_MOUNT]    = "mount",
+    [BOOT_STEP]     = "step"
+};
+
+void
+boottime_start()
+{
+    boot_base = cpu_cycles();
+}
+
+int
+boottime_begin(int kind, const char* name, ptr_t fn)
+{
+    struct boottime_span* span;
+
+    if (boot_done) {
+        return -1;
+    }
+
+    if (nr_spans >= BOOTTIME_MAX_SPANS) {
+        dropped++;
+        return -1;
+    }
+
+    span = &spans[nr_spans];
+    *span = (struct boottime_span) {
+        .fn = fn,
+        .kind = kind,
+        .depth = depth++
+    };
+
+    if (name) {
+        strncpy(span->name, name, BOOTTIME_NAME_LEN - 1);
+    }
+
+    span->start = cpu_cycles();
+    return nr_spans++;
+}
+
+void
+boottime_end(int span)
+{
+    u64_t now = cpu_cycles();
+
+    if (span < 0 || boot_done) {
+        return;
+    }
+
+    spans[span].cycles = now - spans[span].start;
+    depth--;
+}
+
+void
+boottime_finish()
+{
+    if (boot_done) {
+        return;
+    }
+
+    boot_done = cpu_cycles();
+}
+
+/*
+    twifs exports
+ */
+
+static inline u64_t
+__boottime_base()
+{
+    if (boot_base) {
+        return boot_base;
+    }
+
+    return nr_spans ? spans[0].start : 0;
+}
+
+static inline unsigned int
+__kcycles(u64_t cycles)
+{
+    return (unsigned int)udiv64(cycles, 1000);
+}
+
+static void
+__twimap_read_summary(struct twimap* map)
+{
+    u64_t total = 0;
+
+    if (boot_done) {
+        total = boot_done - __boottime_base();
+    }
+
+    twimap_printf(map, "to_init_kcycles: %u\nspans: %u\ndropped: %u\n",
+                  __kcycles(total), nr_spans, dropped);
+}
+
+static void
+__twimap_reset_timeline(struct twimap* map)
+{
+    map->index = (void*)0;
+    twimap_printf(map, "start_kcycles kcycles depth kind name\n");
+}
+
+static int
+__twimap_gonext_timeline(struct twimap* map)
+{
+    unsigned int index = (unsigned int)(ptr_t)map->index;
+
+    if (index + 1 >= nr_spans) {
+        return 0;
+    }
+
+    map->index = (void*)(ptr_t)(index + 1);
+    return 1;
+}
+
+static void
+__twimap_read_timeline(struct twimap* map)
+{
+    unsigned int index = (unsigned int)(ptr_t)map->index;
+    struct boottime_span* span;
+    struct ksym_entry* sym;
+    const char* name;
+
+    if (index >= nr_spans) {
+        return;
+    }
+
+    span = &spans[index];
+    name = span->name;
+
+    if (!span->name[0] && span->fn) {
+        sym = trace_sym_lookup(span->fn);
+        name = sym ? sym->label : "?";
+    }
+
+    twimap_printf(map, "%u %u %u %s %s\n",
+                  __kcycles(span->start - __boottime_base()),
+                  __kcycles(span->cycles),
+                  span->depth, kind_names[span->kind], name);
+}
+
+static void
+boottime_twimappable()
+{
+    struct twifs_node* bt_root;
+
+    bt_root = twifs_dir_node(NULL, "boottime");
+
+    twimap_export_list (bt_root, timeline, FSACL_ugR, NULL);
+    twimap_export_value(bt_root, summary,  FSACL_ugR, NULL);
+}
+EXPORT_TWIFS_PLUGIN(boottime, boottime_twimappable);
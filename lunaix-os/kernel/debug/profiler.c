@@ -0,0 +1,297 @@
+/**
+ * @file profiler.c
+ * @brief A statistical profiler sampling on the timer tick.
+ *
+ * Boot processor samples on the system timer, application processors
+ * on their local timer, which only ticks once per time slice, their
+ * tables are thus much sparser.
+ *
+ * Every tick, the interrupted context is walked back and each frame
+ * is resolved to the symbol it belongs to, the resulting stack is
+ * then counted in a per-CPU hash table. Doing the folding right
+ * away keeps the memory bounded regardless of how long the profiler
+ * runs, stacks that do not fit are counted as dropped.
+ *
+ * Exported to twifs:
+ *      /profile/enable     write 1 to (re)start, 0 to stop
+ *      /profile/stats      samples taken and dropped
+ *      /profile/folded     "outermost;...;innermost count" per stack
+ */
+
+#include <lunaix/profiler.h>
+#include <lunaix/trace.h>
+#include <lunaix/process.h>
+#include <lunaix/percpu.h>
+#include <lunaix/spike.h>
+#include <lunaix/fs/twifs.h>
+#include <lunaix/fs/twimap.h>
+
+#include <asm/hart.h>
+
+#include <klibc/string.h>
+
+#define PROF_DEPTH          8
+#define PROF_TABLE_SIZE     256
+#define PROF_MAX_PROBE      16
+
+// stands for whatever in user space
+#define PROF_USER_PC        ((ptr_t)-1)
+
+struct prof_stack
+{
+    ptr_t frames[PROF_DEPTH];   // innermost first
+    unsigned int depth;
+    volatile unsigned int count;
+};
+
+struct prof_table
+{
+    struct prof_stack stacks[PROF_TABLE_SIZE];
+    unsigned long samples;
+    unsigned long dropped;
+};
+
+volatile bool profiler_enabled = false;
+
+static struct prof_table prof_tables[CONFIG_NR_CPUS];
+
+static inline ptr_t
+__prof_symbolize(ptr_t pc)
+{
+    struct ksym_entry* sym;
+
+    sym = trace_sym_lookup(pc);
+    return sym ? sym->pc : pc;
+}
+
+static inline unsigned int
+__prof_hash(ptr_t* frames, unsigned int depth)
+{
+    unsigned int hash = 2166136261U;
+
+    for (unsigned int i = 0; i < depth; i++) {
+        hash = (hash ^ (unsigned int)frames[i]) * 16777619U;
+    }
+
+    return hash;
+}
+
+static unsigned int
+__prof_walk(struct hart_state* hstate, ptr_t* frames)
+{
+    struct trace_record tbs[PROF_DEPTH - 1];
+    unsigned int depth;
+    int n;
+
+    if (!kernel_context(hstate)) {
+        frames[0] = PROF_USER_PC;
+        return 1;
+    }
+
+    frames[0] = __prof_symbolize(hart_pc(hstate));
+    depth = 1;
+
+    n = trace_walkback(tbs, hart_stack_frame(hstate), PROF_DEPTH - 1, NULL);
+    for (int i = 0; i < n; i++) {
+        frames[depth++] = tbs[i].sym_pc ?: tbs[i].pc;
+    }
+
+    return depth;
+}
+
+static void
+__prof_count(struct prof_table* table, ptr_t* frames, unsigned int depth)
+{
+    struct prof_stack* stack;
+    unsigned int hash;
+
+    hash = __prof_hash(frames, depth);
+
+    for (int i = 0; i < PROF_MAX_PROBE; i++)
+    {
+        stack = &table->stacks[(hash + i) % PROF_TABLE_SIZE];
+
+        if (!stack->count) {
+            memcpy(stack->frames, frames, depth * sizeof(ptr_t));
+            stack->depth = depth;
+            barrier();
+            stack->count = 1;
+            return;
+        }
+
+        if (stack->depth == depth
+            && !memcmp(stack->frames, frames, depth * sizeof(ptr_t)))
+        {
+            stack->count++;
+            return;
+        }
+    }
+
+    table->dropped++;
+}
+
+void
+__profiler_sample()
+{
+    struct prof_table* table;
+    struct hart_state* hstate;
+    ptr_t frames[PROF_DEPTH];
+    unsigned int depth;
+
+    if (!current_thread || !(hstate = current_thread->hstate)) {
+        return;
+    }
+
+    table = &prof_tables[this_cpu_id()];
+    table->samples++;
+
+    depth = __prof_walk(hstate, frames);
+    __prof_count(table, frames, depth);
+}
+
+/*
+    twifs exports
+ */
+
+static int
+__twifs_read_enable(struct v_inode* inode, void* buffer,
+                    size_t len, size_t fpos)
+{
+    if (fpos || len < 2) {
+        return 0;
+    }
+
+    memcpy(buffer, profiler_enabled ? "1\n" : "0\n", 2);
+    return 2;
+}
+
+static int
+__twifs_write_enable(struct v_inode* inode, void* buffer,
+                     size_t len, size_t fpos)
+{
+    char val;
+
+    if (!len) {
+        return 0;
+    }
+
+    val = *(char*)buffer;
+    if (val != '0' && val != '1') {
+        return EINVAL;
+    }
+
+    profiler_enabled = false;
+
+    if (val == '1') {
+        // do not count in the ticks come in meanwhile.
+        barrier();
+        memset(prof_tables, 0, sizeof(prof_tables));
+        barrier();
+        profiler_enabled = true;
+    }
+
+    return len;
+}
+
+static void
+__twimap_read_stats(struct twimap* map)
+{
+    unsigned long samples = 0, dropped = 0;
+
+    for (int i = 0; i < CONFIG_NR_CPUS; i++) {
+        samples += prof_tables[i].samples;
+        dropped += prof_tables[i].dropped;
+    }
+
+    twimap_printf(map, "samples: %u\ndropped: %u\n", samples, dropped);
+}
+
+static inline struct prof_stack*
+__prof_stack_at(unsigned int index)
+{
+    return &prof_tables[index / PROF_TABLE_SIZE]
+                .stacks[index % PROF_TABLE_SIZE];
+}
+
+static int
+__twimap_gonext_folded(struct twimap* map)
+{
+    unsigned int index = (unsigned int)(ptr_t)map->index;
+
+    while (++index < CONFIG_NR_CPUS * PROF_TABLE_SIZE)
+    {
+        if (__prof_stack_at(index)->count) {
+            map->index = (void*)(ptr_t)index;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void
+__twimap_reset_folded(struct twimap* map)
+{
+    map->index = (void*)0;
+}
+
+static void
+__prof_print_frame(struct twimap* map, ptr_t pc)
+{
+    struct ksym_entry* sym;
+
+    if (pc == PROF_USER_PC) {
+        twimap_printf(map, "[user]");
+        return;
+    }
+
+    sym = trace_sym_lookup(pc);
+    if (sym && sym->pc == pc) {
+        twimap_printf(map, "%s", sym->label);
+    }
+    else {
+        twimap_printf(map, "0x%x", pc);
+    }
+}
+
+static void
+__twimap_read_folded(struct twimap* map)
+{
+    unsigned int index = (unsigned int)(ptr_t)map->index;
+    struct prof_stack* stack;
+    struct prof_stack snapshot;
+
+    stack = __prof_stack_at(index);
+    if (!stack->count) {
+        return;
+    }
+
+    snapshot = *stack;
+
+    for (int i = snapshot.depth - 1; i >= 0; i--) {
+        __prof_print_frame(map, snapshot.frames[i]);
+        twimap_printf(map, i ? ";" : " ");
+    }
+
+    twimap_printf(map, "%u\n", snapshot.count);
+}
+
+static void
+profiler_twimappable()
+{
+    struct twifs_node* prof_root;
+    struct twifs_export exp = {
+        .name = "enable",
+        .acl = FSACL_ugR | FSACL_ugW,
+        .stream = true,
+        .ops = { .read = __twifs_read_enable,
+                 .write = __twifs_write_enable }
+    };
+
+    prof_root = twifs_dir_node(NULL, "profile");
+
+    twifs_basic_node_from(prof_root, &exp, NULL);
+    twimap_export_value(prof_root, stats, FSACL_ugR, NULL);
+    twimap_export_list (prof_root, folded, FSACL_ugR, NULL);
+}
+EXPORT_TWIFS_PLUGIN(profiler, profiler_twimappable);
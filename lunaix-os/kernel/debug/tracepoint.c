@@ -0,0 +1,333 @@
+/**
+ * @file tracepoint.c
+ * @brief Static tracepoints and their per-CPU trace rings.
+ *
+ * Each processor has its own ring of fixed size records, written with
+ * interrupt off, so there is only ever one writer to a ring and no
+ * lock is needed. Readers are lock-free as well: a record is stamped
+ * with its sequence number only after it is fully written, and is
+ * invalidated before being overwritten, so a reader that copied a
+ * record being overwritten will find the stamp changed.
+ *
+ * Exported to twifs:
+ *      /trace/list             "<id> <name> <on>" of every tracepoint
+ *      /trace/events/<name>    write 1 or 0 to switch on or off
+ *      /trace/buffer           the records, as struct tracepoint_record
+ */
+
+#include <lunaix/tracepoint.h>
+#include <lunaix/percpu.h>
+#include <lunaix/process.h>
+#include <lunaix/clock.h>
+#include <lunaix/owloysius.h>
+#include <lunaix/spike.h>
+#include <lunaix/fs/twifs.h>
+#include <lunaix/fs/twimap.h>
+#include <lunaix/mm/valloc.h>
+
+#include <asm/cpu.h>
+
+#include <klibc/string.h>
+
+#define TRACE_RING_SIZE     512
+#define TRACE_SEQ_INVALID   ((unsigned int)-1)
+
+struct trace_ring
+{
+    struct tracepoint_record recs[TRACE_RING_SIZE];
+    volatile unsigned int head;
+};
+
+struct trace_reader
+{
+    unsigned int next[CONFIG_NR_CPUS];
+    unsigned int lost;
+};
+
+extern struct tracepoint* __lga_tracepoints_start[];
+extern struct tracepoint* __lga_tracepoints_end[];
+
+static struct trace_ring trace_rings[CONFIG_NR_CPUS];
+
+static inline struct tracepoint_record*
+__trace_slot(struct trace_ring* ring, unsigned int seq)
+{
+    return &ring->recs[seq % TRACE_RING_SIZE];
+}
+
+void
+__trace_emit(struct tracepoint* tp, unsigned long arg0, unsigned long arg1)
+{
+    struct trace_ring* ring;
+    struct tracepoint_record* rec;
+    struct thread* thread;
+    unsigned int seq, cpu;
+    reg_t flags;
+
+    flags  = cpu_save_interrupt();
+
+    cpu    = this_cpu_id();
+    ring   = &trace_rings[cpu];
+    thread = (struct thread*)current_thread;
+    seq    = ring->head;
+    rec    = __trace_slot(ring, seq);
+
+    rec->seq = TRACE_SEQ_INVALID;
+    barrier();
+
+    rec->cycles = cpu_cycles();
+    rec->time   = clock_systime();
+    rec->arg0   = arg0;
+    rec->arg1   = arg1;
+    rec->id     = tp->id;
+    rec->cpu    = cpu;
+    rec->pid    = thread ? thread->process->pid : -1;
+    rec->tid    = thread ? thread->tid : -1;
+
+    barrier();
+    rec->seq   = seq;
+    ring->head = seq + 1;
+
+    cpu_restore_interrupt(flags);
+}
+
+/*
+    Fetch the next record of `cpu` for the reader, skip over what has
+    been overwritten.
+ */
+static bool
+__trace_fetch(struct trace_reader* rd, unsigned int cpu,
+              struct tracepoint_record* out)
+{
+    struct trace_ring* ring = &trace_rings[cpu];
+    struct tracepoint_record* rec;
+    unsigned int seq, head;
+
+    while (1)
+    {
+        seq  = rd->next[cpu];
+        head = ring->head;
+
+        if (seq == head) {
+            return false;
+        }
+
+        if (head - seq > TRACE_RING_SIZE) {
+            rd->lost += head - TRACE_RING_SIZE - seq;
+            rd->next[cpu] = head - TRACE_RING_SIZE;
+            continue;
+        }
+
+        rec = __trace_slot(ring, seq);
+        barrier();
+        *out = *rec;
+        barrier();
+
+        if (out->seq == seq && rec->seq == seq) {
+            return true;
+        }
+
+        // lapped while copying, try the oldest again.
+        rd->next[cpu] = seq + 1;
+        rd->lost++;
+    }
+}
+
+/*
+    Records of all processors are merged by their cycle stamp, this
+    is fine as long as the time stamp counters are in sync.
+ */
+static bool
+__trace_next(struct trace_reader* rd, struct tracepoint_record* out)
+{
+    struct tracepoint_record rec;
+    int picked = -1;
+
+    if (rd->lost) {
+        *out = (struct tracepoint_record) {
+            .id = TRACE_ID_LOST,
+            .arg0 = rd->lost,
+            .cycles = cpu_cycles(),
+            .time = clock_systime()
+        };
+
+        rd->lost = 0;
+        return true;
+    }
+
+    for (unsigned int cpu = 0; cpu < CONFIG_NR_CPUS; cpu++)
+    {
+        if (!__trace_fetch(rd, cpu, &rec)) {
+            continue;
+        }
+
+        if (picked < 0 || rec.cycles < out->cycles) {
+            picked = cpu;
+            *out = rec;
+        }
+    }
+
+    if (picked < 0) {
+        return false;
+    }
+
+    rd->next[picked]++;
+    return true;
+}
+
+/*
+    twifs exports
+ */
+
+static int
+__twifs_read_buffer(struct v_file* file, void* buffer, size_t len, size_t fpos)
+{
+    struct trace_reader* rd;
+    struct tracepoint_record rec;
+    size_t copied = 0;
+
+    rd = (struct trace_reader*)file->data;
+    if (!rd) {
+        rd = vzalloc(sizeof(*rd));
+        if (!rd) {
+            return ENOMEM;
+        }
+
+        for (unsigned int cpu = 0; cpu < CONFIG_NR_CPUS; cpu++) {
+            rd->next[cpu] = trace_rings[cpu].head;
+            if (rd->next[cpu] > TRACE_RING_SIZE) {
+                rd->next[cpu] -= TRACE_RING_SIZE;
+            } else {
+                rd->next[cpu] = 0;
+            }
+        }
+
+        file->data = rd;
+    }
+
+    // only whole records are handed out.
+    while (copied + sizeof(rec) <= len && __trace_next(rd, &rec))
+    {
+        memcpy(buffer + copied, &rec, sizeof(rec));
+        copied += sizeof(rec);
+    }
+
+    return copied;
+}
+
+static int
+__twifs_close_buffer(struct v_file* file)
+{
+    vfree_safe(file->data);
+    file->data = NULL;
+
+    return 0;
+}
+
+static int
+__twifs_read_enable(struct v_inode* inode, void* buffer,
+                    size_t len, size_t fpos)
+{
+    struct tracepoint* tp;
+
+    tp = twinode_getdata(inode, struct tracepoint*);
+    if (fpos || len < 2) {
+        return 0;
+    }
+
+    memcpy(buffer, tp->enabled ? "1\n" : "0\n", 2);
+    return 2;
+}
+
+static int
+__twifs_write_enable(struct v_inode* inode, void* buffer,
+                     size_t len, size_t fpos)
+{
+    struct tracepoint* tp;
+    char val;
+
+    tp = twinode_getdata(inode, struct tracepoint*);
+    if (!len) {
+        return 0;
+    }
+
+    val = *(char*)buffer;
+    if (val != '0' && val != '1') {
+        return EINVAL;
+    }
+
+    tp->enabled = (val == '1');
+    return len;
+}
+
+static int
+__twimap_gonext_list(struct twimap* map)
+{
+    struct tracepoint** pos = twimap_index(map, struct tracepoint**);
+
+    if (pos + 1 >= __lga_tracepoints_end) {
+        return 0;
+    }
+
+    map->index = pos + 1;
+    return 1;
+}
+
+static void
+__twimap_reset_list(struct twimap* map)
+{
+    map->index = __lga_tracepoints_start;
+}
+
+static void
+__twimap_read_list(struct twimap* map)
+{
+    struct tracepoint** pos = twimap_index(map, struct tracepoint**);
+
+    if (pos >= __lga_tracepoints_end) {
+        return;
+    }
+
+    twimap_printf(map, "%d %s %d\n",
+                  (*pos)->id, (*pos)->name, (*pos)->enabled);
+}
+
+static void
+tracepoint_twimappable()
+{
+    struct twifs_node *trace_root, *events;
+    struct tracepoint** pos;
+
+    trace_root = twifs_dir_node(NULL, "trace");
+    events = twifs_dir_node(trace_root, "events");
+
+    twimap_export_list(trace_root, list, FSACL_ugR, NULL);
+    twifs_export_stream(trace_root, buffer, FSACL_ugR, NULL);
+
+    for (pos = __lga_tracepoints_start; pos < __lga_tracepoints_end; pos++)
+    {
+        struct twifs_export exp = {
+            .name = (char*)(*pos)->name,
+            .acl = FSACL_ugR | FSACL_ugW,
+            .stream = true,
+            .ops = { .read = __twifs_read_enable,
+                     .write = __twifs_write_enable }
+        };
+
+        twifs_basic_node_from(events, &exp, *pos);
+    }
+}
+EXPORT_TWIFS_PLUGIN(tracepoint, tracepoint_twimappable);
+
+static void
+tracepoint_init()
+{
+    unsigned short id = 0;
+    struct tracepoint** pos;
+
+    for (pos = __lga_tracepoints_start; pos < __lga_tracepoints_end; pos++)
+    {
+        (*pos)->id = id++;
+    }
+}
+owloysius_fetch_init(tracepoint_init, on_earlyboot);
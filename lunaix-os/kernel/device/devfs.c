@@ -22,6 +22,63 @@ devfs_read(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
     return dev->ops.read(dev, buffer, fpos, len);
 }
 
+int
+devfs_read_file(struct v_fd* fd, void* buffer, size_t len, size_t fpos)
+{
+    struct v_file* file = fd->file;
+    struct device* dev = resolve_device(file->inode->data);
+
+    if (dev && dev->ops.read_file) {
+        return dev->ops.read_file(dev, file, buffer, len);
+    }
+
+    return devfs_read(file->inode, buffer, len, fpos);
+}
+
+int
+devfs_poll(struct v_file* file, struct iopoller* poller)
+{
+    struct device* dev = resolve_device(file->inode->data);
+
+    if (!dev) {
+        return 0;
+    }
+
+    if (poller) {
+        iopoll_listen_on(poller, &dev->pollers);
+    }
+
+    if (dev->ops.poll_file) {
+        return dev->ops.poll_file(dev, file);
+    }
+
+    return dev->ops.poll ? dev->ops.poll(dev) : 0;
+}
+
+int
+devfs_open(struct v_inode* inode, struct v_file* file)
+{
+    struct device* dev;
+    
+    if (!inode->data || !(dev = resolve_device(inode->data))) {
+        return 0;
+    }
+
+    return dev->ops.open ? dev->ops.open(dev, file) : 0;
+}
+
+int
+devfs_close(struct v_file* file)
+{
+    struct device* dev;
+    
+    if (!file->inode->data || !(dev = resolve_device(file->inode->data))) {
+        return 0;
+    }
+
+    return dev->ops.close ? dev->ops.close(dev, file) : 0;
+}
+
 int
 devfs_write(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
 {
@@ -225,14 +282,16 @@ devfs_init()
 EXPORT_FILE_SYSTEM(devfs, devfs_init);
 
 struct v_inode_ops devfs_inode_ops = { .dir_lookup = devfs_dirlookup,
-                                       .open = default_inode_open,
+                                       .open = devfs_open,
                                        .mkdir = default_inode_mkdir,
                                        .rmdir = default_inode_rmdir };
 
-struct v_file_ops devfs_file_ops = { .close = default_file_close,
+struct v_file_ops devfs_file_ops = { .close = devfs_close,
                                      .read = devfs_read,
+                                     .read_file = devfs_read_file,
                                      .read_page = devfs_read_page,
                                      .write = devfs_write,
                                      .write_page = devfs_write_page,
                                      .seek = default_file_seek,
-                                     .readdir = devfs_readdir };
\ No newline at end of file
+                                     .readdir = devfs_readdir,
+                                     .poll = devfs_poll };
\ No newline at end of file
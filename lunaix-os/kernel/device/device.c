@@ -7,6 +7,7 @@
 #include <lunaix/syscall.h>
 #include <lunaix/syscall_utils.h>
 #include <lunaix/owloysius.h>
+#include <lunaix/boottime.h>
 
 #include <klibc/strfmt.h>
 #include <klibc/string.h>
@@ -236,6 +237,9 @@ void
 device_chain_load_once(struct device_def* def)
 {
     struct device_ldfn_chain *node, *next;
+    int span;
+
+    span = boottime_begin(BOOT_DRIVER, def->name, 0);
 
     if (def->load) {
         def->load(def);
@@ -253,16 +257,11 @@ device_chain_load_once(struct device_def* def)
         node = next;
     }
 
-    if (def->flags.no_default_realm) {
-        return;
-    }
-
-    if (!def->create) {
-        return;
+    if (!def->flags.no_default_realm && def->create) {
+        def->create(def, NULL);
     }
 
-    def->create(def, NULL);
-    
+    boottime_end(span);
 }
 
 __DEFINE_LXSYSCALL3(int, ioctl, int, fd, int, req, sc_va_list, _args)
@@ -1,5 +1,8 @@
 #include <lunaix/clock.h>
+#include <lunaix/foptions.h>
+#include <lunaix/fs.h>
 #include <lunaix/input.h>
+#include <lunaix/kpreempt.h>
 #include <lunaix/mm/pagetable.h>
 #include <lunaix/mm/valloc.h>
 #include <lunaix/spike.h>
@@ -7,6 +10,8 @@
 
 #include <klibc/string.h>
 
+#define RING_MASK   (INPUT_RING_SIZE - 1)
+
 static DEFINE_LLIST(listener_chain);
 
 static struct device_cat* input_devcat = NULL;
@@ -17,9 +22,38 @@ input_init()
     input_devcat = device_addcat(NULL, "input");
 }
 
+static inline unsigned int
+__reader_pending(struct input_reader* reader)
+{
+    return reader->head - reader->tail;
+}
+
+/*
+    Called with interrupt off. The oldest events are kept on overflow,
+    the lost ones are told by a PKT_OVERFLOW at the next read.
+ */
+static void
+__reader_push(struct input_reader* reader, struct input_evt_pkt* pkt)
+{
+    struct input_device* idev = reader->idev;
+
+    if (__reader_pending(reader) >= INPUT_RING_SIZE) {
+        reader->overflow++;
+        idev->dropped++;
+        return;
+    }
+
+    reader->ring[reader->head & RING_MASK] = *pkt;
+    barrier();
+    reader->head++;
+}
+
 void
 input_fire_event(struct input_device* idev, struct input_evt_pkt* pkt)
 {
+    struct input_reader *reader, *r;
+    reg_t flags;
+
     pkt->timestamp = clock_systime();
     idev->current_pkt = *pkt;
 
@@ -31,8 +65,18 @@ input_fire_event(struct input_device* idev, struct input_evt_pkt* pkt)
         }
     }
 
+    flags = cpu_save_interrupt();
+
+    llist_for_each(reader, r, &idev->reader_list, link)
+    {
+        __reader_push(reader, pkt);
+    }
+
+    cpu_restore_interrupt(flags);
+
     // wake up all pending readers
     pwake_all(&idev->readers);
+    iopoll_wake_pollers(&idev->dev_if->pollers);
 }
 
 void
@@ -46,6 +90,133 @@ input_add_listener(input_evt_cb listener)
     chain->evt_cb = listener;
 }
 
+static int
+__input_dev_open(struct device* dev, struct v_file* file)
+{
+    struct input_device* idev = dev->underlay;
+    struct input_reader* reader;
+    reg_t flags;
+
+    reader = vzalloc(sizeof(*reader));
+    if (!reader) {
+        return ENOMEM;
+    }
+
+    reader->idev = idev;
+
+    flags = cpu_save_interrupt();
+    llist_append(&idev->reader_list, &reader->link);
+    cpu_restore_interrupt(flags);
+
+    file->data = reader;
+    return 0;
+}
+
+static int
+__input_dev_close(struct device* dev, struct v_file* file)
+{
+    struct input_reader* reader = file->data;
+    reg_t flags;
+
+    if (!reader) {
+        return 0;
+    }
+
+    flags = cpu_save_interrupt();
+    llist_delete(&reader->link);
+    cpu_restore_interrupt(flags);
+
+    vfree(reader);
+    file->data = NULL;
+    return 0;
+}
+
+static int
+__input_dev_poll(struct device* dev, struct v_file* file)
+{
+    struct input_reader* reader = file->data;
+
+    if (!reader) {
+        return 0;
+    }
+
+    return __reader_pending(reader) || reader->overflow ? _POLLIN : 0;
+}
+
+/*
+    Read as many whole packets as the buffer can hold, block only
+    when there is none, unless opened with O_NONBLOCK.
+ */
+static int
+__input_dev_read_file(struct device* dev, struct v_file* file,
+                      void* buf, size_t len)
+{
+    struct input_device* idev = dev->underlay;
+    struct input_reader* reader = file->data;
+    struct input_evt_pkt* out = buf;
+    struct thread* th = current_thread;
+    unsigned int max, nr, tail, lost;
+    reg_t flags;
+
+    if (!reader) {
+        return EBADF;
+    }
+
+    max = len / sizeof(struct input_evt_pkt);
+    if (!max) {
+        return ERANGE;
+    }
+
+    while (!__reader_pending(reader) && !reader->overflow) 
+    {
+        if ((file->f_options & FO_NONBLOCK)) {
+            return EAGAIN;
+        }
+
+        no_preemption();
+
+        if (__reader_pending(reader) || reader->overflow) {
+            set_preemption();
+            break;
+        }
+
+        prepare_to_wait(&idev->readers);
+        try_wait();
+        set_preemption();
+
+        if ((pending_sigs(th) & ~th->sigctx.sig_mask)) {
+            return EINTR;
+        }
+    }
+
+    nr = 0;
+
+    flags = cpu_save_interrupt();
+    lost = reader->overflow;
+    reader->overflow = 0;
+    cpu_restore_interrupt(flags);
+
+    if (lost) {
+        out[nr++] = (struct input_evt_pkt) {
+            .pkt_type  = PKT_OVERFLOW,
+            .scan_code = lost,
+            .timestamp = clock_systime()
+        };
+    }
+
+    // slots in [tail, head) is never touched by the producer
+    tail = reader->tail;
+    while (nr < max && tail != reader->head) {
+        out[nr++] = reader->ring[tail & RING_MASK];
+        tail++;
+    }
+
+    barrier();
+    reader->tail = tail;
+
+    return nr * sizeof(struct input_evt_pkt);
+}
+
 int
 __input_dev_read(struct device* dev, void* buf, size_t offset, size_t len)
 {
@@ -76,6 +247,7 @@ input_add_device(struct devclass* class, char* name_fmt, ...)
 
     struct input_device* idev = vzalloc(sizeof(*idev));
     waitq_init(&idev->readers);
+    llist_init_head(&idev->reader_list);
 
     va_list args;
     va_start(args, name_fmt);
@@ -88,6 +260,10 @@ input_add_device(struct devclass* class, char* name_fmt, ...)
     idev->dev_if = dev;
     dev->ops.read = __input_dev_read;
     dev->ops.read_page = __input_dev_read_pg;
+    dev->ops.open = __input_dev_open;
+    dev->ops.close = __input_dev_close;
+    dev->ops.read_file = __input_dev_read_file;
+    dev->ops.poll_file = __input_dev_poll;
 
     va_end(args);
 
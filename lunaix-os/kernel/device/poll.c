@@ -9,7 +9,25 @@
 #include <lunaix/syscall_utils.h>
 #include <lunaix/kpreempt.h>
 
-#define MAX_POLLER_COUNT 16
+#include <klibc/string.h>
+
+#define POLLER_INIT_COUNT   16
+
+/*
+    Readiness is pushed, not pulled. Every event source (device,
+    pipe, ...) keeps a queue of pollers listening on it, and raise an
+    edge with iopoll_wake_pollers(). That put the poller onto the
+    ready list of its owning iopoll and wake up whoever waiting on it.
+
+    A wait then only have to re-validate the ready list against the
+    actual state of the file, cost is O(ready) rather than O(pollers).
+    A level-triggered poller stays on the ready list as long as the
+    file remains ready, an edge-triggered (_POLLEE_EDGE) one is taken
+    off once it is reported, and only return upon the next edge.
+
+    The ready list may be touched from interrupt context, thus any
+    manipulation is done with interrupt off.
+*/
 
 static inline void
 current_rmiopoll(int pld)
@@ -20,13 +38,47 @@ current_rmiopoll(int pld)
 static struct iopoller*
 iopoll_getpoller(struct iopoll* ctx, int pld)
 {
-    if (pld < 0 || pld >= MAX_POLLER_COUNT) {
+    if (pld < 0 || pld >= ctx->size) {
         return NULL;
     }
 
     return ctx->pollers[pld];
 }
 
+static inline int
+__poll_file(struct v_file* file)
+{
+    struct device* dev;
+
+    if (file->ops->poll) {
+        return file->ops->poll(file, NULL);
+    }
+
+    if ((dev = resolve_device(file->inode->data))) {
+        return dev->ops.poll ? dev->ops.poll(dev) : 0;
+    }
+
+    /*
+        N.B. In Linux, polling on any of the non-device mapped file cause
+        immediate return of poller, in other words, the I/O signal on file
+        is always active. We do the same for now, monitoring modification
+        of a file is a job for something else.
+    */
+    return _POLLIN | _POLLOUT;
+}
+
+static inline void
+__mark_ready(struct iopoller* poller)
+{
+    struct iopoll* ctx = poller->ctx;
+
+    if (llist_empty(&poller->ready)) {
+        llist_append(&ctx->ready, &poller->ready);
+    }
+
+    ctx->wake_seq++;
+}
+
 static inline int
 __do_poll(struct poll_info* pinfo, int pld)
 {
@@ -35,23 +87,7 @@ __do_poll(struct poll_info* pinfo, int pld)
         return 0;
     }
 
-    struct device* dev;
-    int evt = 0;
-
-    if ((dev = resolve_device(poller->file_ref->inode->data))) {
-        dev->ops.poll(dev);
-    } else {
-        // TODO handle generic file
-        /*
-            N.B. In Linux, polling on any of the non-device mapped file cause
-           immediate return of poller, in other words, the I/O signal on file is
-           always active. Which make it no use on monitoring any file
-           modifications. However, polling for such modifications
-           must go through inotify_* API. Which is not that elegant as it breaks
-           the nice consistency that *poll(2) should have. Let see want can we
-           do in Lunaix.
-        */
-    }
+    int evt = __poll_file(poller->file_ref);
 
     if (evt < 0) {
         poll_setrevt(pinfo, _POLLERR);
@@ -83,8 +119,6 @@ static int
 __do_poll_round(struct poll_info* pinfos, int ninfo)
 {
     int nc = 0;
-    struct v_fd* fd_s;
-    struct device* dev;
     for (int i = 0; i < ninfo; i++) {
         struct poll_info* pinfo = &pinfos[i];
         int pld = pinfo->pld;
@@ -97,33 +131,132 @@ __do_poll_round(struct poll_info* pinfos, int ninfo)
     return nc;
 }
 
+/*
+    Move the poller onto another ready list. The poller must never be
+    seen off-list (llist_empty) by __mark_ready, or it gets appended to
+    ctx->ready while still linked into ours.
+ */
+static inline void
+__move_ready(struct iopoller* poller, struct llist_header* list)
+{
+    reg_t flags;
+
+    flags = cpu_save_interrupt();
+    llist_delete(&poller->ready);
+    llist_append(list, &poller->ready);
+    cpu_restore_interrupt(flags);
+}
+
+/*
+    Harvest at most `max` events from ready list. The list is
+    detached first, as checking the file may sleep (e.g. on the pipe
+    lock), and those still worth a look later are put back at the
+    tail, so a busy level-triggered file can not starve the others.
+ */
 static int
-__do_poll_all(struct poll_info* pinfo)
+__do_poll_ready(struct iopoll* ctx, struct poll_info* pinfos, int max)
 {
-    for (int i = 0; i < MAX_POLLER_COUNT; i++) {
-        if (!__do_poll(pinfo, i)) {
+    struct llist_header pending, keep, dropped;
+    struct iopoller *pos, *n;
+    unsigned int seq;
+    reg_t flags;
+    int evt, nc = 0;
+
+    llist_init_head(&pending);
+    llist_init_head(&keep);
+    llist_init_head(&dropped);
+
+    flags = cpu_save_interrupt();
+    seq = ctx->wake_seq;
+    llist_splice(&pending, &ctx->ready);
+    cpu_restore_interrupt(flags);
+
+    llist_for_each(pos, n, &pending, ready)
+    {
+        if (nc >= max) {
+            break;
+        }
+
+        evt = __poll_file(pos->file_ref);
+        evt = evt < 0 ? _POLLERR : evt & (pos->events | _POLLERR | _POLLHUP);
+
+        if (!pos->events || !evt) {
+            __move_ready(pos, &dropped);
             continue;
         }
 
-        pinfo->pld = i;
-        return 1;
+        pinfos[nc++] = (struct poll_info) {
+            .pld = pos->pld,
+            .events = pos->events,
+            .revents = evt,
+            .flags = pos->flags
+        };
+
+        if ((pos->flags & _POLLEE_ONESHOT)) {
+            pos->events = 0;
+        }
+
+        if ((pos->flags & (_POLLEE_EDGE | _POLLEE_ONESHOT))) {
+            __move_ready(pos, &dropped);
+        } else {
+            __move_ready(pos, &keep);
+        }
     }
 
-    return 0;
-}
+    flags = cpu_save_interrupt();
 
-#define fd2dev(fd) resolve_device((fd)->file->inode->data)
+    // not yet visited first, then the newly signaled, then the kept.
+    llist_splice(&pending, &ctx->ready);
+    llist_splice(&pending, &keep);
+
+    // an edge came in while we were looking, play safe and keep all.
+    if (seq != ctx->wake_seq) {
+        llist_splice(&pending, &dropped);
+    } 
+    else {
+        llist_for_each(pos, n, &dropped, ready) {
+            llist_delete(&pos->ready);
+        }
+    }
+
+    llist_splice(&ctx->ready, &pending);
+
+    cpu_restore_interrupt(flags);
+
+    return nc;
+}
 
 static int
-__alloc_pld()
+__alloc_pld(struct iopoll* ctx)
 {
-    for (size_t i = 0; i < MAX_POLLER_COUNT; i++) {
-        if (!__current->pollctx.pollers[i]) {
+    struct iopoller** pollers;
+    int size, limit, old;
+
+    for (int i = 0; i < ctx->size; i++) {
+        if (!ctx->pollers[i]) {
             return i;
         }
     }
 
-    return -1;
+    limit = __current->fdtable->limit;
+    if (ctx->size >= limit) {
+        return -1;
+    }
+
+    old  = ctx->size;
+    size = MIN(old * 2, limit);
+    pollers = vzalloc(sizeof(struct iopoller*) * size);
+    if (!pollers) {
+        return -1;
+    }
+
+    memcpy(pollers, ctx->pollers, sizeof(struct iopoller*) * old);
+    vfree(ctx->pollers);
+
+    ctx->pollers = pollers;
+    ctx->size = size;
+
+    return old;
 }
 
 static int
@@ -150,18 +283,61 @@ __append_pollers(int* ds, int npoller)
     return nc;
 }
 
+static int
+__modify_poller(int pld, short events, int pflags)
+{
+    struct iopoll* ctx = &__current->pollctx;
+    struct iopoller* poller;
+    reg_t flags;
+
+    if (!(poller = iopoll_getpoller(ctx, pld))) {
+        return ENOENT;
+    }
+
+    poller->events = events;
+    poller->flags  = pflags;
+
+    // re-arm, let the next wait decide
+    flags = cpu_save_interrupt();
+    __mark_ready(poller);
+    cpu_restore_interrupt(flags);
+
+    return 0;
+}
+
+/*
+    Sleep until any of our pollers get signaled, or check back later
+    if caller has a deadline (we have no timed wait yet).
+ */
 static void
-__wait_until_event()
+__wait_until_event(struct iopoll* ctx, unsigned int seq, int timeout)
 {
-    wait_current_thread();
-    yield_current();
+    if (timeout >= 0) {
+        yield_current();
+        return;
+    }
+
+    no_preemption();
+
+    if (seq == ctx->wake_seq) {
+        prepare_to_wait(&ctx->waiters);
+        try_wait();
+    }
+
+    set_preemption();
 }
 
 void
 iopoll_init(struct iopoll* ctx)
 {
-    ctx->pollers = vzalloc(sizeof(ptr_t) * MAX_POLLER_COUNT);
+    ctx->pollers = vzalloc(sizeof(ptr_t) * POLLER_INIT_COUNT);
+    ctx->size = POLLER_INIT_COUNT;
     ctx->n_poller = 0;
+    ctx->wake_seq = 0;
+
+    mutex_init(&ctx->lock);
+    llist_init_head(&ctx->ready);
+    waitq_init(&ctx->waiters);
 }
 
 void
@@ -169,15 +345,22 @@ iopoll_free(struct proc_info* proc)
 {
     pid_t pid = proc->pid;
     struct iopoll* ctx = &proc->pollctx;
-    for (int i = 0; i < MAX_POLLER_COUNT; i++) {
+    reg_t flags;
+
+    for (int i = 0; i < ctx->size; i++) {
         struct iopoller* poller = ctx->pollers[i];
         if (poller) {
             vfs_pclose(poller->file_ref, pid);
+
+            flags = cpu_save_interrupt();
             llist_delete(&poller->evt_listener);
+            llist_delete(&poller->ready);
+            cpu_restore_interrupt(flags);
+
             vfree(poller);
         }
     }
-    
+
     vfree(ctx->pollers);
 }
 
@@ -185,15 +368,17 @@ void
 iopoll_wake_pollers(poll_evt_q* pollers_q)
 {
     struct iopoller *pos, *n;
+    reg_t flags;
+
+    flags = cpu_save_interrupt();
+
     llist_for_each(pos, n, pollers_q, evt_listener)
     {
-        struct thread* thread = pos->thread;
-        assert(!proc_terminated(thread));
-        
-        if (proc_waiting(thread)) {
-            resume_thread(thread);
-        }
+        __mark_ready(pos);
+        pwake_all(&pos->ctx->waiters);
     }
+
+    cpu_restore_interrupt(flags);
 }
 
 int
@@ -201,13 +386,21 @@ iopoll_remove(struct thread* thread, int pld)
 {
     struct proc_info* proc = thread->process;
     struct iopoll* ctx = &proc->pollctx;
-    struct iopoller* poller = ctx->pollers[pld];
+    struct iopoller* poller = iopoll_getpoller(ctx, pld);
+    reg_t flags;
+
     if (!poller) {
         return ENOENT;
     }
 
     // FIXME vfs locking model need to rethink in the presence of threads
     vfs_pclose(poller->file_ref, proc->pid);
+
+    flags = cpu_save_interrupt();
+    llist_delete(&poller->evt_listener);
+    llist_delete(&poller->ready);
+    cpu_restore_interrupt(flags);
+
     vfree(poller);
     ctx->pollers[pld] = NULL;
     ctx->n_poller--;
@@ -218,7 +411,11 @@ iopoll_remove(struct thread* thread, int pld)
 int
 iopoll_install(struct thread* thread, struct v_fd* fd)
 {
-    int pld = __alloc_pld();
+    struct proc_info* proc = thread->process;
+    struct iopoll* ctx = &proc->pollctx;
+    reg_t flags;
+
+    int pld = __alloc_pld(ctx);
     if (pld < 0) {
         return EMFILE;
     }
@@ -226,32 +423,46 @@ iopoll_install(struct thread* thread, struct v_fd* fd)
     struct iopoller* iop = valloc(sizeof(struct iopoller));
     *iop = (struct iopoller){
         .file_ref = fd->file,
-        .thread = thread,
+        .ctx = ctx,
+        .pld = pld,
+        .events = _POLLIN | _POLLPRI | _POLLOUT | _POLLRDHUP,
+        .flags = 0
     };
 
+    llist_init_head(&iop->evt_listener);
+    llist_init_head(&iop->ready);
     vfs_ref_file(fd->file);
 
-    struct proc_info* proc = thread->process;
-    proc->pollctx.pollers[pld] = iop;
-    proc->pollctx.n_poller++;
+    ctx->pollers[pld] = iop;
+    ctx->n_poller++;
 
     struct device* dev;
-    if ((dev = fd2dev(fd))) {
+    struct v_file* file = fd->file;
+    if (file->ops->poll) {
+        file->ops->poll(file, iop);
+    } else if ((dev = resolve_device(file->inode->data))) {
         iopoll_listen_on(iop, &dev->pollers);
-    } else {
-        // TODO handle generic file
     }
 
+    // it might be ready already, let the first wait find out.
+    flags = cpu_save_interrupt();
+    __mark_ready(iop);
+    cpu_restore_interrupt(flags);
+
     return pld;
 }
 
 __DEFINE_LXSYSCALL2(int, pollctl, int, action, sc_va_list, _ap)
 {
     int retcode = 0;
+    unsigned int seq;
     va_list va;
+    struct iopoll* ctx = &__current->pollctx;
 
     convert_valist(&va, _ap);
-    
+
+    mutex_lock(&ctx->lock);
+
     switch (action) {
         case _SPOLL_ADD: {
             int* ds = va_arg(va, int*);
@@ -263,29 +474,52 @@ __DEFINE_LXSYSCALL2(int, pollctl, int, action, sc_va_list, _ap)
             // FIXME [2026-QUALIFIER] volatile
             retcode = iopoll_remove(current_thread, pld);
         } break;
+        case _SPOLL_MOD: {
+            int pld = va_arg(va, int);
+            int events = va_arg(va, int);
+            int flags = va_arg(va, int);
+            retcode = __modify_poller(pld, events, flags);
+        } break;
         case _SPOLL_WAIT: {
             struct poll_info* pinfos = va_arg(va, struct poll_info*);
             int npinfos = va_arg(va, int);
             int timeout = va_arg(va, int);
 
             time_t t1 = clock_systime() + timeout;
-            while (!(retcode == __do_poll_round(pinfos, npinfos))) {
+            while (seq = ctx->wake_seq,
+                   !(retcode = __do_poll_round(pinfos, npinfos)))
+            {
                 if (timeout >= 0 && t1 < clock_systime()) {
                     break;
                 }
-                __wait_until_event();
+
+                mutex_unlock(&ctx->lock);
+                __wait_until_event(ctx, seq, timeout);
+                mutex_lock(&ctx->lock);
             }
         } break;
-        case _SPOLL_WAIT_ANY: {
-            struct poll_info* pinfo = va_arg(va, struct poll_info*);
+        case _SPOLL_WAIT_ANY:
+        case _SPOLL_WAIT_READY: {
+            struct poll_info* pinfos = va_arg(va, struct poll_info*);
+            int max = action == _SPOLL_WAIT_ANY ? 1 : va_arg(va, int);
             int timeout = va_arg(va, int);
 
+            if (max <= 0) {
+                retcode = EINVAL;
+                break;
+            }
+
             time_t t1 = clock_systime() + timeout;
-            while (!(retcode == __do_poll_all(pinfo))) {
+            while (seq = ctx->wake_seq,
+                   !(retcode = __do_poll_ready(ctx, pinfos, max)))
+            {
                 if (timeout >= 0 && t1 < clock_systime()) {
                     break;
                 }
-                __wait_until_event();
+
+                mutex_unlock(&ctx->lock);
+                __wait_until_event(ctx, seq, timeout);
+                mutex_lock(&ctx->lock);
             }
         } break;
         default:
@@ -293,5 +527,7 @@ __DEFINE_LXSYSCALL2(int, pollctl, int, action, sc_va_list, _ap)
             break;
     }
 
+    mutex_unlock(&ctx->lock);
+
     return DO_STATUS(retcode);
 }
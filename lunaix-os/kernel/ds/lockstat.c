@@ -0,0 +1,58 @@
+#include <lunaix/ds/spinlock.h>
+#include <lunaix/fs/twifs.h>
+
+/*
+    Every site of spinlock_acquire (and friends) leaves a reference
+    to its record in this linker generated array
+ */
+extern struct lockstat_site* __lga_lockstat_start[];
+extern struct lockstat_site* __lga_lockstat_end[];
+
+#define kcycles(cycles)     ((unsigned long)((cycles) >> 10))
+
+static int
+__twimap_gonext_lockstat(struct twimap* map)
+{
+    struct lockstat_site** pos = twimap_index(map, struct lockstat_site**);
+    
+    if (pos + 1 >= __lga_lockstat_end) {
+        return 0;
+    }
+
+    map->index = pos + 1;
+    return 1;
+}
+
+static void
+__twimap_reset_lockstat(struct twimap* map)
+{
+    map->index = __lga_lockstat_start;
+}
+
+static void
+__twimap_read_lockstat(struct twimap* map)
+{
+    struct lockstat_site** pos = twimap_index(map, struct lockstat_site**);
+    struct lockstat_site* site;
+
+    if (pos == __lga_lockstat_start) {
+        twimap_printf(map, "site acquired contended hold_kcyc max_kcyc\n");
+    }
+
+    if (pos >= __lga_lockstat_end) {
+        return;
+    }
+
+    site = *pos;
+    twimap_printf(map, "%s:%u %u %u %u %u\n",
+                  site->file, site->line,
+                  site->acquired, site->contended,
+                  kcycles(site->hold_cycles), kcycles(site->max_hold));
+}
+
+static void
+lockstat_export()
+{
+    twimap_export_list(NULL, lockstat, FSACL_ugR, NULL);
+}
+EXPORT_TWIFS_PLUGIN(lockstat, lockstat_export);
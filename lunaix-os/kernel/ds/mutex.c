@@ -2,11 +2,11 @@
 #include <lunaix/process.h>
 #include <lunaix/kpreempt.h>
 
-#define __do_lock(mutext)               \
-    ({                                  \
-        atomic_fetch_add(&mutex->lk, 1);\
-        mutex->owner = __current->pid;  \
-    })
+/*
+    Upper bound of cpu_relax() rounds a contender may spin on a
+    running holder before it goes to sleep.
+ */
+#define MUTEX_SPIN_LIMIT    1024
 
 static inline bool must_inline
 __mutex_check_owner(mutex_t* mutex)
@@ -15,42 +15,191 @@ __mutex_check_owner(mutex_t* mutex)
 }
 
 static inline void must_inline
-__mutext_lock(mutex_t* mutex)
+__mutex_set_holder(mutex_t* mutex, struct thread* th, pid_t pid)
 {
-    while (atomic_load(&mutex->lk)) {
-        preempt_current();
+    mutex->holder = th;
+    mutex->owner  = pid;
+}
+
+static inline bool must_inline
+__mutex_try_acquire(mutex_t* mutex)
+{
+    unsigned int free = 0;
+
+    if (!atomic_compare_exchange_strong(&mutex->lk, &free, 1)) {
+        return false;
+    }
+
+    __mutex_set_holder(mutex, current_thread, __current->pid);
+    return true;
+}
+
+/*
+    Whether `holder` is what some processor is running. The holder may
+    exit and be freed while we spin, so it is only ever compared, never
+    dereferenced.
+ */
+static inline bool
+__mutex_holder_running(struct thread* holder)
+{
+    struct cpu_local* cpu;
+
+    for_each_cpu(cpu) {
+        if (cpu->thread == holder) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+    Only worth to spin when the holder is running on other processor,
+    it will then likely release the mutex before we could finish a
+    round trip through the scheduler.
+ */
+static bool
+__mutex_spin_on_holder(mutex_t* mutex)
+{
+    struct thread* holder;
+
+    if (nr_cpus == 1) {
+        return false;
+    }
+
+    for (int i = 0; i < MUTEX_SPIN_LIMIT; i++)
+    {
+        if (__mutex_try_acquire(mutex)) {
+            return true;
+        }
+
+        holder = mutex->holder;
+        if (!holder || !__mutex_holder_running(holder)) {
+            break;
+        }
+
+        cpu_relax();
     }
 
-    __do_lock(mutex);
+    return false;
+}
+
+static void
+__mutex_lock_slowpath(mutex_t* mutex)
+{
+    reg_t flags;
+
+    if (__mutex_spin_on_holder(mutex)) {
+        return;
+    }
+
+    while (1)
+    {
+        // caller may well be in a non-preemptive section already
+        flags = spinlock_acquire_irqsave(&mutex->wait_lock);
+
+        if (__mutex_try_acquire(mutex)) {
+            spinlock_release_irqrestore(&mutex->wait_lock, flags);
+            return;
+        }
+
+        prepare_to_wait(&mutex->waiters);
+        spinlock_release(&mutex->wait_lock);
+
+        try_wait();
+        cpu_restore_interrupt(flags);
+
+        /*
+            We are either handed the mutex, or the wait got cancelled
+            (e.g., signal), in which case just queue up again.
+         */
+        if (mutex->holder == current_thread) {
+            return;
+        }
+    }
 }
 
 static inline void must_inline
-__mutext_unlock(mutex_t* mutex)
+__mutex_lock(mutex_t* mutex)
 {
-    if (__mutex_check_owner(mutex))
+    if (likely(__mutex_try_acquire(mutex))) {
+        return;
+    }
+
+    __mutex_lock_slowpath(mutex);
+}
+
+/*
+    Pick the first waiter that could still take the mutex. A waiter
+    killed while asleep stays queued until it is destroyed, handing
+    the mutex to it would leave the mutex held forever.
+ */
+static struct thread*
+__mutex_next_waiter(mutex_t* mutex)
+{
+    struct thread* th;
+    waitq_t *pos, *n;
+
+    llist_for_each(pos, n, &mutex->waiters.waiters, waiters)
+    {
+        th = container_of(pos, struct thread, waitqueue);
+        if (!proc_terminated(th) && !proc_terminated(th->process)) {
+            return th;
+        }
+
+        waitq_cancel_wait(pos);
+    }
+
+    return NULL;
+}
+
+static void
+__mutex_release(mutex_t* mutex)
+{
+    struct thread* next;
+    reg_t flags;
+
+    if (atomic_load(&mutex->lk) > 1) {
         atomic_fetch_sub(&mutex->lk, 1);
+        return;
+    }
+
+    // unlock must not turn the interrupt back on behind caller's back
+    flags = spinlock_acquire_irqsave(&mutex->wait_lock);
+
+    next = __mutex_next_waiter(mutex);
+    if (!next) {
+        mutex->holder = NULL;
+        mutex->owner  = 0;
+        atomic_store(&mutex->lk, 0);
+        goto done;
+    }
+
+    // hand over, keep `lk` held so no one could cut in line.
+    __mutex_set_holder(mutex, next, next->process->pid);
+    pwake_one(&mutex->waiters);
+
+done:
+    spinlock_release_irqrestore(&mutex->wait_lock, flags);
 }
 
 void
 mutex_lock(mutex_t* mutex)
 {
-    __mutext_lock(mutex);
+    __mutex_lock(mutex);
 }
 
 bool
 mutex_trylock(mutex_t* mutex)
 {
-    if (atomic_load(&mutex->lk))
-        return false;
-
-    __do_lock(mutex);
-    return true;
+    return __mutex_try_acquire(mutex);
 }
 
 void
 mutex_unlock(mutex_t* mutex)
 {
-    __mutext_unlock(mutex);
+    if (__mutex_check_owner(mutex))
+        __mutex_release(mutex);
 }
 
 void
@@ -59,7 +208,8 @@ mutex_unlock_for(mutex_t* mutex, pid_t pid)
     if (mutex->owner != pid || !atomic_load(&mutex->lk)) {
         return;
     }
-    atomic_fetch_sub(&mutex->lk, 1);
+    
+    __mutex_release(mutex);
 }
 
 void
@@ -70,11 +220,11 @@ mutex_lock_nested(mutex_t* mutex)
         return;
     }
 
-    __mutext_lock(mutex);
+    __mutex_lock(mutex);
 }
 
 void
 mutex_unlock_nested(mutex_t* mutex)
 {
     mutex_unlock_for(mutex, __current->pid);
-}
\ No newline at end of file
+}
@@ -1,58 +1,164 @@
 #include <lunaix/ds/rwlock.h>
+#include <lunaix/kpreempt.h>
 #include <lunaix/spike.h>
 
+/*
+    The uncontended reader or writer is a single cmpxchg on `state`.
+    Anything else goes through `wait_lock`, under which the waiters
+    re-check the state before sleeping. Wakeups are only issued on
+    transitions that could unblock someone: last reader leaving with
+    writer waiting, or writer releasing the lock.
+ */
+
+static inline unsigned int
+__reader_blockers(rwlock_t* rwlock)
+{
+    if (rwlock->prefer_writer) {
+        return RWLOCK_WRITER | RWLOCK_WRITER_WAIT;
+    }
+
+    return RWLOCK_WRITER;
+}
+
+static inline bool
+__try_read(rwlock_t* rwlock)
+{
+    unsigned int blockers = __reader_blockers(rwlock);
+    unsigned int v = atomic_load(&rwlock->state);
+
+    while (!(v & blockers)) {
+        if (atomic_compare_exchange_weak(&rwlock->state, &v, v + 1)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static inline bool
+__try_write(rwlock_t* rwlock)
+{
+    unsigned int v = atomic_load(&rwlock->state);
+
+    while (!(v & (RWLOCK_WRITER | RWLOCK_READERS))) {
+        if (atomic_compare_exchange_weak(&rwlock->state, &v, 
+                                         v | RWLOCK_WRITER)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static inline void
+__sleep_on(rwlock_t* rwlock, waitq_t* queue)
+{
+    prepare_to_wait(queue);
+    spinlock_release(&rwlock->wait_lock);
+
+    try_wait();
+    
+    // the caller restores its own interrupt state once done
+    no_preemption();
+    spinlock_acquire(&rwlock->wait_lock);
+}
+
 void
 rwlock_init(rwlock_t* rwlock)
 {
     waitq_init(&rwlock->waiting_readers);
     waitq_init(&rwlock->waiting_writers);
-    atomic_init(&rwlock->readers, 0);
-    atomic_flag_clear(&rwlock->writer);
+    spinlock_init(&rwlock->wait_lock);
+    atomic_init(&rwlock->state, 0);
+
+    rwlock->nr_wwait = 0;
+    rwlock->prefer_writer = true;
 }
 
 void
 rwlock_begin_read(rwlock_t* rwlock)
 {
-    while (atomic_flag_test_and_set(&rwlock->writer)) {
-        pwait(&rwlock->waiting_readers);
+    reg_t flags;
+
+    if (likely(__try_read(rwlock))) {
+        return;
     }
-    atomic_fetch_add(&rwlock->readers, 1);
-    atomic_flag_clear(&rwlock->writer);
-    pwake_all(&rwlock->waiting_readers);
+
+    flags = spinlock_acquire_irqsave(&rwlock->wait_lock);
+
+    while (!__try_read(rwlock)) {
+        __sleep_on(rwlock, &rwlock->waiting_readers);
+    }
+
+    spinlock_release_irqrestore(&rwlock->wait_lock, flags);
 }
 
 void
 rwlock_end_read(rwlock_t* rwlock)
 {
-    assert(atomic_load(&rwlock->readers) > 0);
-    atomic_fetch_sub(&rwlock->readers, 1);
+    unsigned int v;
+    reg_t flags;
 
-    if (!atomic_load(&rwlock->readers)) {
-        pwake_one(&rwlock->waiting_writers);
+    v = atomic_fetch_sub(&rwlock->state, 1) - 1;
+    assert((v & RWLOCK_READERS) != RWLOCK_READERS);
+
+    if ((v & RWLOCK_READERS) || !(v & RWLOCK_WRITER_WAIT)) {
+        return;
     }
+
+    flags = spinlock_acquire_irqsave(&rwlock->wait_lock);
+
+    pwake_one(&rwlock->waiting_writers);
+
+    spinlock_release_irqrestore(&rwlock->wait_lock, flags);
 }
 
 void
 rwlock_begin_write(rwlock_t* rwlock)
 {
-    // first, acquire writer lock, prevent any incoming readers
-    while (atomic_flag_test_and_set(&rwlock->writer)) {
-        pwait(&rwlock->waiting_writers);
+    reg_t flags;
+
+    if (likely(__try_write(rwlock))) {
+        return;
+    }
+
+    flags = spinlock_acquire_irqsave(&rwlock->wait_lock);
+
+    // announce ourself before checking, so last reader knows to wake us
+    if (!rwlock->nr_wwait++) {
+        atomic_fetch_or(&rwlock->state, RWLOCK_WRITER_WAIT);
     }
 
-    // then, wait for reader finish the read.
-    while (atomic_load(&rwlock->readers)) {
-        pwait(&rwlock->waiting_writers);
+    while (!__try_write(rwlock)) {
+        __sleep_on(rwlock, &rwlock->waiting_writers);
     }
+
+    if (!--rwlock->nr_wwait) {
+        atomic_fetch_and(&rwlock->state, ~RWLOCK_WRITER_WAIT);
+    }
+
+    spinlock_release_irqrestore(&rwlock->wait_lock, flags);
 }
 
 void
 rwlock_end_write(rwlock_t* rwlock)
 {
-    atomic_flag_clear(&rwlock->writer);
-    if (waitq_empty(&rwlock->waiting_writers)) {
-        pwake_all(&rwlock->waiting_readers);
-    } else {
+    reg_t flags;
+
+    assert(atomic_load(&rwlock->state) & RWLOCK_WRITER);
+
+    flags = spinlock_acquire_irqsave(&rwlock->wait_lock);
+
+    atomic_fetch_and(&rwlock->state, ~RWLOCK_WRITER);
+
+    if (rwlock->nr_wwait && 
+        (rwlock->prefer_writer || waitq_empty(&rwlock->waiting_readers))) 
+    {
         pwake_one(&rwlock->waiting_writers);
     }
-}
\ No newline at end of file
+    else {
+        pwake_all(&rwlock->waiting_readers);
+    }
+
+    spinlock_release_irqrestore(&rwlock->wait_lock, flags);
+}
@@ -3,6 +3,7 @@
 #include <lunaix/sched.h>
 #include <lunaix/spike.h>
 #include <lunaix/kpreempt.h>
+#include <lunaix/clock.h>
 
 /**
  * The pwait/wait_queue
@@ -32,6 +33,17 @@
  *
  */ 
 
+static inline void
+__stamp_woken(waitq_t* waiter, time_t now)
+{
+    struct thread_stats* stats;
+
+    // a waiter is always some thread's own waitqueue
+    stats = &container_of(waiter, struct thread, waitqueue)->stats;
+    stats->woken_at = now;
+    stats->woken_cycles = cpu_cycles();
+}
+
 static inline void must_inline
 __try_wait(bool check_stall) 
 {
@@ -45,6 +57,7 @@ __try_wait(bool check_stall)
     }
 
     wait_current_thread();
+    current_thread->stats.wait_since = clock_systime();
 
     if (!check_stall) {
         // if we are not checking stall, we give up voluntarily
@@ -88,6 +101,8 @@ pwake_one(waitq_t* queue)
 
     waitq_t* wq = list_entry(queue->waiters.next, waitq_t, waiters);
     llist_delete(&wq->waiters);
+
+    __stamp_woken(wq, clock_systime());
 }
 
 void
@@ -99,10 +114,13 @@ pwake_all(waitq_t* queue)
 
     struct thread* thread;
     waitq_t *pos, *n;
+    time_t now = clock_systime();
+
     llist_for_each(pos, n, &queue->waiters, waiters)
     {
         // already awaken or killed by other event, just remove it
         llist_delete(&pos->waiters);
+        __stamp_woken(pos, now);
     }
 }
 
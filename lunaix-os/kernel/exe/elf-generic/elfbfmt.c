@@ -5,6 +5,8 @@
 
 #include <klibc/string.h>
 
+extern struct lru_zone* inode_lru;
+
 static inline int
 elf_read(struct v_file* elf, void* data, size_t off, size_t len)
 {
@@ -12,15 +14,76 @@ elf_read(struct v_file* elf, void* data, size_t off, size_t len)
     return pcache_read(elf->inode, data, len, off);
 }
 
+/*
+    Headers parsed from an executable are cached on its inode, so
+    the repeated exec of the same file no longer touch them again.
+    Each opened elf holds a reference, as the cache may be dropped
+    by a write while the image is still being loaded.
+ */
+
+#define ELF_INTERP_MAX  256
+
+struct elf_image
+{
+    struct elf_ehdr eheader;
+    struct elf_phdr* pheaders;
+    char* interp;
+    unsigned int ref;
+};
+
+static void
+__elf_image_put(struct elf_image* img)
+{
+    if (--img->ref) {
+        return;
+    }
+
+    vfree_safe(img->pheaders);
+    vfree_safe(img->interp);
+    vfree(img);
+}
+
 static int
-elf_do_open(struct elf* elf, struct v_file* elf_file)
+__elf_read_interp(struct elf* elf, struct elf_image* img)
+{
+    struct elf_phdr* phdre;
+    int status;
+
+    for (size_t i = 0; i < elf->eheader.e_phnum; i++) {
+        phdre = &elf->pheaders[i];
+        if (phdre->p_type != PT_INTERP) {
+            continue;
+        }
+
+        if (!phdre->p_filesz || phdre->p_filesz >= ELF_INTERP_MAX) {
+            return ENOEXEC;
+        }
+
+        img->interp = valloc(phdre->p_filesz + 1);
+        if (!img->interp) {
+            return ENOMEM;
+        }
+
+        status = elf_read((struct v_file*)elf->elf_file, img->interp,
+                          phdre->p_offset, phdre->p_filesz);
+        if (status < 0) {
+            return status;
+        }
+
+        img->interp[phdre->p_filesz] = '\0';
+        break;
+    }
+
+    return 0;
+}
+
+static int
+__elf_image_build(struct elf* elf, struct elf_image** img_out)
 {
     int status = 0;
-    elf->pheaders = NULL;
-    elf->elf_file = elf_file;
+    struct elf_image* img;
 
     if ((status = elf_read_ehdr(elf)) < 0) {
-        elf_close(elf);
         return status;
     }
 
@@ -29,13 +92,79 @@ elf_do_open(struct elf* elf, struct v_file* elf_file)
     }
 
     if ((status = elf_read_phdr(elf)) < 0) {
+        return status;
+    }
+
+    img = vzalloc(sizeof(*img));
+    if (!img) {
+        vfree(elf->pheaders);
+        return ENOMEM;
+    }
+
+    img->eheader  = elf->eheader;
+    img->pheaders = elf->pheaders;
+    img->ref      = 1;
+
+    if ((status = __elf_read_interp(elf, img))) {
+        __elf_image_put(img);
+        return status;
+    }
+
+    *img_out = img;
+    return 0;
+}
+
+static int
+elf_do_open(struct elf* elf, struct v_file* elf_file)
+{
+    int status = 0;
+    struct v_inode* inode = elf_file->inode;
+    struct elf_image* img;
+
+    elf->pheaders = NULL;
+    elf->image = NULL;
+    elf->elf_file = elf_file;
+
+    lock_inode(inode);
+
+    img = (struct elf_image*)inode->exec_cache;
+    if (!img && !(status = __elf_image_build(elf, &img))) {
+        inode->exec_cache = img;
+    }
+
+    if (!status) {
+        img->ref++;
+    }
+
+    unlock_inode(inode);
+
+    if (status) {
+        elf->pheaders = NULL;
         elf_close(elf);
         return status;
     }
 
+    elf->image    = img;
+    elf->eheader  = img->eheader;
+    elf->pheaders = img->pheaders;
+
     return 0;
 }
 
+void
+exec_cache_drop(struct v_inode* inode)
+{
+    struct elf_image* img;
+
+    img = (struct elf_image*)inode->exec_cache;
+    if (!img) {
+        return;
+    }
+
+    inode->exec_cache = NULL;
+    __elf_image_put(img);
+}
+
 _default int
 elf_open(struct elf* elf, const char* path)
 {
@@ -65,12 +194,19 @@ elf_openat(struct elf* elf, void* elf_vfile)
 _default int
 elf_close(struct elf* elf)
 {
-    if (elf->pheaders) {
+    struct v_file* elfile = (struct v_file*)elf->elf_file;
+
+    if (elf->image) {
+        lock_inode(elfile->inode);
+        __elf_image_put(elf->image);
+        unlock_inode(elfile->inode);
+    }
+    else if (elf->pheaders) {
         vfree(elf->pheaders);
     }
 
-    if (elf->elf_file) {
-        vfs_close((struct v_file*)elf->elf_file);
+    if (elfile) {
+        vfs_close(elfile);
     }
 
     memset(elf, 0, sizeof(*elf));
@@ -112,31 +248,29 @@ elf_loadable_memsz(const struct elf* elf)
 _default int
 elf_find_loader(const struct elf* elf, char* path_out, size_t len)
 {
-    int retval = NO_LOADER;
+    const char* interp;
+    size_t interp_len;
 
     assert_msg(len >= sizeof(DEFAULT_LOADER), "path_out: too small");
 
-    struct v_file* elfile = (struct v_file*)elf->elf_file;
-
-    for (size_t i = 0; i < elf->eheader.e_phnum; i++) {
-        struct elf_phdr* phdre = &elf->pheaders[i];
-        if (phdre->p_type == PT_INTERP) {
-            if (len >= phdre->p_filesz) {
-                return EINVAL;
-            }
-
-            retval =
-              elf_read(elfile, path_out, phdre->p_offset, phdre->p_filesz);
-
-            if (retval < 0) {
-                return retval;
-            }
+    interp = elf_interp(elf);
+    if (!interp) {
+        return NO_LOADER;
+    }
 
-            break;
-        }
+    interp_len = strlen(interp);
+    if (interp_len >= len) {
+        return EINVAL;
     }
 
-    return retval;
+    memcpy(path_out, interp, interp_len + 1);
+    return interp_len;
+}
+
+_default const char*
+elf_interp(const struct elf* elf)
+{
+    return elf->image ? elf->image->interp : NULL;
 }
 
 _default int
@@ -59,8 +59,8 @@ load_executable(struct load_context* context, const struct v_file* exefile)
 {
     int errno = 0;
 
-    char* ldpath = NULL;
-    struct elf elf;
+    const char* ldpath;
+    struct elf elf, ldelf;
     struct exec_host* container = context->container;
 
     if ((errno = elf_openat(&elf, (void*)exefile))) {
@@ -69,27 +69,22 @@ load_executable(struct load_context* context, const struct v_file* exefile)
 
     if (!(elf_check_exec(&elf, ET_EXEC) || elf_check_exec(&elf, ET_DYN))) {
         errno = ENOEXEC;
-        goto done;
+        goto done_close_elf32;
     }
 
-    ldpath = valloc(256);
-    errno = elf_find_loader(&elf, ldpath, 256);
+    ldpath = elf_interp(&elf);
     uintptr_t load_base = 0;
 
-    if (errno < 0) {
-        goto done;
-    }
+    if (ldpath) {
+        // open the loader instead, before the path goes with the elf
+        errno = elf_open(&ldelf, ldpath);
+        elf_close(&elf);
 
-    if (errno != NO_LOADER) {
-        // close old elf
-        if ((errno = elf_close(&elf))) {
+        if (errno) {
             goto done;
         }
 
-        // open the loader instead
-        if ((errno = elf_open(&elf, ldpath))) {
-            goto done;
-        }
+        elf = ldelf;
 
         // Is this the valid loader?
         if (!elf_static_linked(&elf) || !elf_check_exec(&elf, ET_DYN)) {
@@ -102,8 +97,6 @@ load_executable(struct load_context* context, const struct v_file* exefile)
 
     context->entry = elf.eheader.e_entry + load_base;
 
-    struct v_file* elfile = (struct v_file*)elf.elf_file;
-
     for (size_t i = 0; i < elf.eheader.e_phnum && !errno; i++) {
         struct elf_phdr* phdr = &elf.pheaders[i];
 
@@ -124,6 +117,5 @@ done_close_elf32:
     elf_close(&elf);
 
 done:
-    vfree_safe(ldpath);
     return errno;
 }
@@ -12,71 +12,116 @@
 #include <lunaix/syscall_utils.h>
 
 #include <asm/abi.h>
+#include <asm/hart.h>
 #include <asm/mm_defs.h>
 
 #include <klibc/string.h>
 
-#define _push(ptr, type, val)               \
-    do {                                    \
-        ptr = __ptr(&((type*)ptr)[-1]);   \
-        *((type*)ptr) = (val);            \
-    } while(0)
+/*
+    argv and envp are copied in one go: every string is measured while
+    being copied into the free part of the new stack, below whatever
+    the caller is still using, and the whole lot is then slid up to
+    the stack top. The staging keeps us from overwriting the strings
+    we are reading, as they may well be on the same stack. Result:
 
-static int
-__place_arrayptrs(struct exec_host* container, struct exec_arrptr* param)
-{
-    int len;
-    ptr_t usp, usp_top;
-    ptr_t* ptrs;
-    unsigned int* reloc_off;
-    
-    usp_top = container->stack_top;
-    usp  = usp_top;
-    ptrs = (ptr_t*)param->raw;
+        stack_top ->  argc, argv[0..argc-1], NULL,
+                      envc, envp[0..envc-1], NULL,
+                      strings...
+ */
 
-    if (!param->len) {
-        _push(usp, unsigned int, 0);
-
-        goto done;
+static inline size_t
+__copy_param(char* dest, const char* src, size_t room)
+{
+    for (size_t i = 0; i < room; i++)
+    {
+        if (!(dest[i] = src[i])) {
+            return i + 1;
+        }
     }
 
-    len = param->len;
-    reloc_off = valloc(len * sizeof(unsigned int));
+    return 0;
+}
 
-    char* el;
+static int
+__stage_arrayptrs(struct exec_arrptr* param, ptr_t* toc, 
+                  ptr_t base, ptr_t* pos, ptr_t end)
+{
+    char** strs = (char**)param->raw;
     size_t el_sz, sz_acc = 0;
-    for (int i = 0; i < len; i++)
+    unsigned int len = param->len;
+
+    toc[0] = (ptr_t)len;
+
+    for (unsigned int i = 0; i < len; i++)
     {
-        el= (char*)ptrs[i];
-        el_sz = strnlen(el, MAX_PARAM_SIZE) + 1;
+        el_sz = __copy_param((char*)*pos, strs[i], end - *pos);
+        if (!el_sz) {
+            return E2BIG;
+        }
 
-        usp -= el_sz;
+        // offset for now, relocated once moved in place
+        toc[i + 1] = *pos - base;
+
+        *pos   += el_sz;
         sz_acc += el_sz;
-        strncpy((char*)usp, el, el_sz);
-        
-        reloc_off[i] = sz_acc;
     }
 
+    toc[len + 1] = 0;
     param->size = sz_acc;
-    
-    ptr_t* toc = (ptr_t*)(usp) - 1;
-    toc[0] = 0;
 
-    toc = &toc[-1];
-    for (int i = 0, j = len - 1; i < len; i++, j--)
-    {
-        toc[-i] = usp_top - (ptr_t)reloc_off[j];
+    return 0;
+}
+
+static int
+__place_params(struct exec_host* container)
+{
+    int errno;
+    ptr_t base, pos, end, usp;
+    ptr_t *argv_toc, *envp_toc, *toc;
+    size_t toc_len, total;
+
+    struct exec_arrptr* argv = &container->argv;
+    struct exec_arrptr* envp = &container->envp;
+
+    toc_len = argv->len + envp->len + 4;
+    base = container->param_lo;
+    end  = container->param_hi;
+    pos  = base + toc_len * sizeof(ptr_t);
+
+    if (pos >= end) {
+        return E2BIG;
+    }
+
+    argv_toc = (ptr_t*)base;
+    envp_toc = &argv_toc[argv->len + 2];
+
+    if ((errno = __stage_arrayptrs(argv, argv_toc, base, &pos, end))) {
+        return errno;
     }
 
-    toc[-len] = (ptr_t)len;
+    if ((errno = __stage_arrayptrs(envp, envp_toc, base, &pos, end))) {
+        return errno;
+    }
 
-    usp = __ptr(&toc[-len]);
-    param->copied = __ptr(&toc[-len + 1]);
+    total = pos - base;
+    usp = ROUNDDOWN(container->stack_top - total, sizeof(ptr_t));
 
-    vfree(reloc_off);
+    memmove((void*)usp, (void*)base, total);
 
-done:
+    toc = (ptr_t*)usp;
+    for (unsigned int i = 1; i <= argv->len; i++) {
+        toc[i] += usp;
+    }
+
+    toc = &toc[argv->len + 2];
+    for (unsigned int i = 1; i <= envp->len; i++) {
+        toc[i] += usp;
+    }
+
+    argv->copied = usp + sizeof(ptr_t);
+    envp->copied = __ptr(&toc[1]);
     container->stack_top = usp;
+
     return 0;
 }
 
@@ -86,8 +131,28 @@ exec_init_container(struct exec_host* param,
                const char** argv,
                const char** envp)
 {
-    assert(thread->ustack);
-    ptr_t ustack_top = align_stack(thread->ustack->end - 1);
+    struct mm_region* ustack = thread->ustack;
+    ptr_t ustack_top, param_lo, param_hi;
+    size_t param_max;
+
+    assert(ustack);
+    ustack_top = align_stack(ustack->end - 1);
+    param_max  = (ustack->end - ustack->start) / MAX_PARAM_SHARE;
+
+    param_hi = ustack_top;
+
+    // what the caller is still using could be where the params are
+    if (thread->hstate && !kernel_context(thread->hstate)) {
+        param_hi = MIN(param_hi, hart_sp(thread->hstate));
+    }
+
+    // stage right below, the new stack is going to use these pages
+    //  anyway. The lowest page is the guard.
+    param_lo = ustack->start + PAGE_SIZE;
+    if (param_hi > param_lo + param_max) {
+        param_lo = param_hi - param_max;
+    }
+
     *param = (struct exec_host) 
     { 
         .proc = thread->process,
@@ -100,14 +165,17 @@ exec_init_container(struct exec_host* param,
         .envp = {
             .raw = __ptr(envp)
         },
-        .stack_top = ustack_top 
+        .stack_top = ustack_top,
+        .param_max = param_max,
+        .param_lo = param_lo,
+        .param_hi = MAX(param_hi, param_lo)
     };
 }
 
-int
-count_length(struct exec_arrptr* param)
+static int
+count_length(struct exec_arrptr* param, size_t max_len)
 {
-    int i = 0;
+    size_t i = 0;
     ptr_t* arr = (ptr_t*)param->raw;
 
     if (!arr) {
@@ -115,57 +183,55 @@ count_length(struct exec_arrptr* param)
         return 0;
     }
 
-    for (; i < MAX_PARAM_LEN && arr[i]; i++);
+    for (; i < max_len && arr[i]; i++);
     
     param->len = i;
-    return i > 0 && arr[i] ? E2BIG : 0;
+    return i == max_len ? E2BIG : 0;
 }
 
 static void
 save_process_cmd(struct proc_info* proc, struct exec_arrptr* argv)
 {
-    ptr_t ptr, *argv_ptrs;
+    ptr_t* argv_ptrs;
     char* cmd_;
+    size_t len;
 
     if (proc->cmd) {
         vfree(proc->cmd);
+        proc->cmd = NULL;
+        proc->cmd_len = 0;
     }
 
-    argv_ptrs = (ptr_t*)argv->copied;
-    cmd_  = (char*)valloc(argv->size);
-
-    proc->cmd = cmd_;
-    while ((ptr = *argv_ptrs)) {
-        cmd_ = strcpy(cmd_, (const char*)ptr);
-        cmd_[-1] = ' ';
-        argv_ptrs++;
+    len  = MIN(MAX(argv->size, 1), PROC_CMD_MAXLEN);
+    cmd_ = (char*)valloc(len);
+    if (!cmd_) {
+        return;
     }
-    cmd_[-1] = '\0';
-    
-    proc->cmd_len = argv->size;
-}
 
+    // argv strings are packed back to back, join them with spaces
+    argv_ptrs = (ptr_t*)argv->copied;
+    if (argv->len) {
+        memcpy(cmd_, (void*)argv_ptrs[0], len);
+    }
 
-static int
-__place_params(struct exec_host* container)
-{
-    int errno = 0;
-
-    errno = __place_arrayptrs(container, &container->envp);
-    if (errno) {
-        goto done;
+    for (size_t i = 0; i < len - 1; i++) {
+        if (!cmd_[i]) {
+            cmd_[i] = ' ';
+        }
     }
 
-    errno = __place_arrayptrs(container, &container->argv);
+    cmd_[len - 1] = '\0';
 
-done:
-    return errno;
+    proc->cmd = cmd_;
+    proc->cmd_len = len;
 }
 
+
 int
 exec_load(struct exec_host* container, struct v_file* executable)
 {
     int errno = 0;
+    size_t max_len;
 
     struct exec_arrptr* argv = &container->argv;
     struct exec_arrptr* envp = &container->envp;
@@ -178,11 +244,13 @@ exec_load(struct exec_host* container, struct v_file* executable)
         pvms->heap = NULL;
     }
 
-    if ((errno = count_length(argv))) {
+    max_len = container->param_max / sizeof(ptr_t);
+
+    if ((errno = count_length(argv, max_len))) {
         goto done;
     }
 
-    if ((errno = count_length(envp))) {
+    if ((errno = count_length(envp, max_len))) {
         goto done;
     }
 
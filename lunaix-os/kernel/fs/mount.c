@@ -6,6 +6,7 @@
 #include <lunaix/syscall_utils.h>
 #include <lunaix/syslog.h>
 #include <lunaix/types.h>
+#include <lunaix/boottime.h>
 
 LOG_MODULE("fs")
 
@@ -182,7 +183,7 @@ vfs_mount_fsat(struct filesystem* fs,
         return ENODEV;
     }
 
-    int errno = 0;
+    int errno = 0, span;
     char* dev_name;
     char* fsname;
     struct v_mount *parent_mnt, *vmnt;
@@ -209,7 +210,12 @@ vfs_mount_fsat(struct filesystem* fs,
     __vfs_attach_vmnt(mnt_point, vmnt);
 
     mnt_point->mnt->flags = options;
-    if (!(errno = fs->mount(sb, mnt_point))) {
+
+    span = boottime_begin(BOOT_MOUNT, fsname, 0);
+    errno = fs->mount(sb, mnt_point);
+    boottime_end(span);
+
+    if (!errno) {
         kprintf("mount: dev=%s, fs=%s, mode=%d", 
                     dev_name, fsname, options);
     } else {
@@ -198,9 +198,10 @@ cont:
 }
 
 int
-pcache_read(struct v_inode* inode, void* data, u32_t len, u32_t fpos)
+pcache_read_actor(struct v_inode* inode, u32_t len, u32_t fpos,
+                  pcache_actor_t actor, void* ctx)
 {
-    int errno = 0;
+    int errno = 0, consumed;
     unsigned int tag, off, rd_cnt;
     unsigned int end = fpos + len, size = 0;
     struct pcache* pcache;
@@ -209,23 +210,31 @@ pcache_read(struct v_inode* inode, void* data, u32_t len, u32_t fpos)
 
     pcache = inode->pg_cache;
 
-    while (fpos < ROUNDUP(end, PAGE_SIZE)) {
+    while (fpos < end) {
         tag = page_index(fpos);
         off = page_offset(fpos);
 
         obj = __getpage_and_lock(pcache, tag, &pg);
 
+        if (!obj && !pg) {
+            errno = ENOMEM;
+            break;
+        }
+
         if (!obj) {
             errno = __fill_page(inode, pg, tag);
             if (errno < 0) {
-                return errno;
+                pcache_free_page(pg->data);
+                vfree(pg);
+                break;
             }
 
-            end -= (PAGE_SIZE - errno);
+            // short fill, we have hit the end of file.
+            end = MIN(end, tag * PAGE_SIZE + errno);
         }
 
-        rd_cnt = MIN(end - fpos, PAGE_SIZE - off);
-        memcpy(data, pg->data + off, rd_cnt);
+        rd_cnt = fpos < end ? MIN(end - fpos, PAGE_SIZE - off) : 0;
+        consumed = rd_cnt ? actor(ctx, pg->data + off, rd_cnt) : 0;
 
         if (obj) {
             bcache_return(obj);
@@ -233,12 +242,41 @@ pcache_read(struct v_inode* inode, void* data, u32_t len, u32_t fpos)
             bcache_put(&pcache->cache, tag, pg);
         }
 
-        data += rd_cnt;
-        size += rd_cnt;
-        fpos = page_frame(fpos + PAGE_SIZE);
+        if (consumed < 0) {
+            errno = consumed;
+            break;
+        }
+
+        size += consumed;
+        fpos += consumed;
+
+        if ((unsigned int)consumed < rd_cnt || !rd_cnt) {
+            break;
+        }
+    }
+
+    if (size) {
+        return (int)size;
     }
 
-    return errno < 0 ? errno : (int)size;
+    return errno < 0 ? errno : 0;
+}
+
+static int
+__pcache_copy_actor(void* ctx, void* chunk, u32_t len)
+{
+    void** dest = (void**)ctx;
+
+    memcpy(*dest, chunk, len);
+    *dest = offset(*dest, len);
+
+    return len;
+}
+
+int
+pcache_read(struct v_inode* inode, void* data, u32_t len, u32_t fpos)
+{
+    return pcache_read_actor(inode, len, fpos, __pcache_copy_actor, &data);
 }
 
 void
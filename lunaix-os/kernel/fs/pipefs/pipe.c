@@ -0,0 +1,504 @@
+/**
+ * @file pipe.c
+ * @brief PipeFS - anonymous pipe for inter-process data streaming
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <lunaix/fs/api.h>
+#include <lunaix/ds/rbuffer.h>
+#include <lunaix/ds/waitq.h>
+#include <lunaix/mm/page.h>
+#include <lunaix/mm/valloc.h>
+#include <lunaix/process.h>
+#include <lunaix/kpreempt.h>
+#include <lunaix/spike.h>
+#include <lunaix/syscall.h>
+#include <lunaix/syscall_utils.h>
+
+#include <klibc/strfmt.h>
+
+/*
+    A pipe is a pair of inodes, one for each end, sharing a single
+    ring buffer. Having separate inodes for reader and writer is
+    intentional: the vfs holds the inode lock for the entire read
+    or write, so a blocking reader would otherwise starve the very
+    writer it is waiting for.
+
+    Pipe inodes are not attached to any directory tree. They live
+    under a private, never mounted, super block and got recycled
+    by the lru once both ends are closed.
+*/
+
+#define PIPE_BUF_ORDER      2
+#define PIPE_BUF_SIZE       (PAGE_SIZE << PIPE_BUF_ORDER)
+
+#define PIPE_READ_END       0
+#define PIPE_WRITE_END      1
+
+struct pipe;
+
+struct pipe_end
+{
+    // N.B. must come first, this keeps `inode->data` of a pipe
+    //  from being mis-revealed as changeling by resolve_device
+    int role;
+    struct pipe* pipe;
+};
+
+struct pipe
+{
+    mutex_t lock;
+    struct rbuffer buffer;
+    struct leaflet* buf_page;
+
+    waitq_t rd_wait;
+    waitq_t wr_wait;
+    poll_evt_q pollers;
+
+    int readers;
+    int writers;
+    int inodes;
+
+    struct pipe_end ends[2];
+};
+
+static struct v_mount pipefs_mnt;
+static volatile u32_t pipe_ino = 0;
+
+extern const struct v_inode_ops pipe_inode_ops;
+extern const struct v_file_ops pipe_file_ops;
+
+static inline struct pipe*
+__pipe_of(struct v_inode* inode)
+{
+    return ((struct pipe_end*)inode->data)->pipe;
+}
+
+static inline size_t
+__pipe_room(struct pipe* pipe)
+{
+    return pipe->buffer.maxsz - rbuffer_len(&pipe->buffer);
+}
+
+static inline void
+__pipe_notify(struct pipe* pipe, waitq_t* waiters)
+{
+    pwake_all(waiters);
+    iopoll_wake_pollers(&pipe->pollers);
+}
+
+static int
+__pipe_wait(struct pipe* pipe, waitq_t* queue)
+{
+    struct thread* th = current_thread;
+
+    // go to sleep with pipe unlocked, otherwise the other end
+    //  will never get a chance to make progress
+    no_preemption();
+    prepare_to_wait(queue);
+    mutex_unlock(&pipe->lock);
+    try_wait();
+    set_preemption();
+
+    mutex_lock(&pipe->lock);
+
+    if ((pending_sigs(th) & ~th->sigctx.sig_mask)) {
+        return EINTR;
+    }
+
+    return 0;
+}
+
+static int
+__pipe_open(struct v_inode* this, struct v_file* file)
+{
+    struct pipe_end* end = this->data;
+    struct pipe* pipe = end->pipe;
+
+    mutex_lock(&pipe->lock);
+
+    if (end->role == PIPE_READ_END) {
+        pipe->readers++;
+    } else {
+        pipe->writers++;
+    }
+
+    mutex_unlock(&pipe->lock);
+
+    return 0;
+}
+
+static int
+__pipe_close(struct v_file* file)
+{
+    struct pipe_end* end = file->inode->data;
+    struct pipe* pipe = end->pipe;
+
+    mutex_lock(&pipe->lock);
+
+    if (end->role == PIPE_READ_END) {
+        pipe->readers--;
+        __pipe_notify(pipe, &pipe->wr_wait);
+    } else {
+        pipe->writers--;
+        __pipe_notify(pipe, &pipe->rd_wait);
+    }
+
+    // nobody could ever touch the content again, give the pages
+    //  back early rather than waiting for inode recycling
+    if (!pipe->readers && !pipe->writers && pipe->buf_page) {
+        leaflet_return(pipe->buf_page);
+        pipe->buf_page = NULL;
+        rbuffer_init(&pipe->buffer, NULL, 0);
+    }
+
+    mutex_unlock(&pipe->lock);
+
+    return 0;
+}
+
+static int
+__pipe_do_read(struct v_inode* inode, void* buffer, size_t len, bool nonblock)
+{
+    int errno = 0;
+    struct pipe_end* end = inode->data;
+    struct pipe* pipe = end->pipe;
+
+    if (end->role != PIPE_READ_END) {
+        return EBADF;
+    }
+
+    if (!len) {
+        return 0;
+    }
+
+    mutex_lock(&pipe->lock);
+
+    while (rbuffer_empty(&pipe->buffer)) {
+        if (!pipe->writers) {
+            // end of stream
+            goto done;
+        }
+
+        if (nonblock) {
+            errno = EAGAIN;
+            goto done;
+        }
+
+        if ((errno = __pipe_wait(pipe, &pipe->rd_wait))) {
+            goto done;
+        }
+    }
+
+    errno = rbuffer_gets(&pipe->buffer, (char*)buffer, len);
+    __pipe_notify(pipe, &pipe->wr_wait);
+
+done:
+    mutex_unlock(&pipe->lock);
+    return errno;
+}
+
+static int
+__pipe_do_write(struct v_inode* inode, void* buffer, size_t len, bool nonblock)
+{
+    int errno = 0;
+    size_t written = 0, room, chunk, need;
+    struct pipe_end* end = inode->data;
+    struct pipe* pipe = end->pipe;
+
+    if (end->role != PIPE_WRITE_END) {
+        return EBADF;
+    }
+
+    mutex_lock(&pipe->lock);
+
+    while (written < len) {
+        if (!pipe->readers) {
+            if (!kernel_process(__current)) {
+                thread_setsignal(current_thread, SIGPIPE);
+            }
+
+            errno = EPIPE;
+            break;
+        }
+
+        /*
+            write no larger than PIPE_BUF is atomic, it shall
+            never be interleaved with other writers. Larger one
+            can be split at any point.
+        */
+        need = len <= PIPE_BUF ? len : 1;
+        room = __pipe_room(pipe);
+
+        if (room < need) {
+            if (nonblock) {
+                errno = EAGAIN;
+                break;
+            }
+
+            if ((errno = __pipe_wait(pipe, &pipe->wr_wait))) {
+                break;
+            }
+
+            continue;
+        }
+
+        chunk = MIN(room, len - written);
+        rbuffer_puts(&pipe->buffer, (char*)buffer + written, chunk);
+        written += chunk;
+
+        __pipe_notify(pipe, &pipe->rd_wait);
+    }
+
+    mutex_unlock(&pipe->lock);
+
+    return written ? (int)written : errno;
+}
+
+static int
+__pipe_read(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
+{
+    return __pipe_do_read(inode, buffer, len, false);
+}
+
+static int
+__pipe_write(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
+{
+    return __pipe_do_write(inode, buffer, len, false);
+}
+
+// O_NONBLOCK belongs to the descriptor, not to the end it refers to
+static int
+__pipe_read_fd(struct v_fd* fd, void* buffer, size_t len, size_t fpos)
+{
+    return __pipe_do_read(fd->file->inode, buffer, len, 
+                          !!(fd->flags & FO_NONBLOCK));
+}
+
+static int
+__pipe_write_fd(struct v_fd* fd, void* buffer, size_t len, size_t fpos)
+{
+    return __pipe_do_write(fd->file->inode, buffer, len, 
+                           !!(fd->flags & FO_NONBLOCK));
+}
+
+static int
+__pipe_poll(struct v_file* file, struct iopoller* poller)
+{
+    int evt = 0;
+    struct pipe_end* end = file->inode->data;
+    struct pipe* pipe = end->pipe;
+
+    mutex_lock(&pipe->lock);
+
+    if (poller) {
+        iopoll_listen_on(poller, &pipe->pollers);
+    }
+
+    if (end->role == PIPE_READ_END) {
+        evt |= !rbuffer_empty(&pipe->buffer) ? _POLLIN : 0;
+        evt |= !pipe->writers ? _POLLHUP : 0;
+    } else {
+        evt |= __pipe_room(pipe) >= PIPE_BUF ? _POLLOUT : 0;
+        evt |= !pipe->readers ? _POLLERR : 0;
+    }
+
+    mutex_unlock(&pipe->lock);
+
+    return evt;
+}
+
+static void
+__pipe_inode_destruct(struct v_inode* inode)
+{
+    struct pipe* pipe = __pipe_of(inode);
+
+    if (--pipe->inodes) {
+        return;
+    }
+
+    if (pipe->buf_page) {
+        leaflet_return(pipe->buf_page);
+    }
+
+    vfree(pipe);
+}
+
+static void
+__pipefs_init_inode(struct v_superblock* vsb, struct v_inode* inode)
+{
+    fsapi_inode_setops(inode, (struct v_inode_ops*)&pipe_inode_ops);
+    fsapi_inode_setfops(inode, (struct v_file_ops*)&pipe_file_ops);
+    fsapi_inode_settype(inode, VFS_IFPIPE);
+    fsapi_inode_setid(inode, pipe_ino++, 0);
+    fsapi_inode_setaccess(inode, FSACL_uR | FSACL_uW);
+    fsapi_inode_setdector(inode, __pipe_inode_destruct);
+}
+
+static struct pipe*
+__pipe_alloc()
+{
+    struct pipe* pipe;
+    struct leaflet* leaflet;
+
+    leaflet = leaflet_alloc_order(PGPOL_NORMAL, PIPE_BUF_ORDER);
+    if (!leaflet) {
+        return NULL;
+    }
+
+    pipe = vzalloc(sizeof(*pipe));
+
+    mutex_init(&pipe->lock);
+    waitq_init(&pipe->rd_wait);
+    waitq_init(&pipe->wr_wait);
+    iopoll_init_evt_q(&pipe->pollers);
+
+    pipe->buf_page = leaflet;
+    rbuffer_init(&pipe->buffer, (char*)leaflet_va(leaflet), PIPE_BUF_SIZE);
+
+    for (int i = 0; i < 2; i++) {
+        pipe->ends[i].role = i;
+        pipe->ends[i].pipe = pipe;
+    }
+
+    return pipe;
+}
+
+static int
+__pipe_open_end(struct pipe* pipe, int role, struct v_file** file)
+{
+    char name[32];
+    struct hstr hname;
+    struct v_inode* inode;
+    struct v_dnode* dnode;
+
+    hname = HSTR(name, ksnprintf(name, sizeof(name), "pipe:[%d]", pipe_ino));
+    hstr_rehash(&hname, HSTR_FULL_HASH);
+
+    dnode = vfs_d_alloc(NULL, &hname);
+    if (!dnode) {
+        return ENOMEM;
+    }
+
+    // an orphaned dnode, held by nobody but the opened file.
+    vfs_d_assign_vmnt(dnode, &pipefs_mnt);
+    vfs_ref_dnode(dnode);
+
+    inode = vfs_i_alloc(pipefs_mnt.super_block);
+    if (!inode) {
+        return ENOMEM;
+    }
+
+    fsapi_inode_setowner(inode, current_euid(), current_egid());
+    fsapi_inode_complete(inode, &pipe->ends[role]);
+    pipe->inodes++;
+
+    vfs_assign_inode(dnode, inode);
+
+    // on failure, lru will take care of the leftover
+    return vfs_open(dnode, file);
+}
+
+static int
+__pipe_install_end(struct pipe* pipe, int role, int options, int* fd)
+{
+    int errno;
+    struct v_file* file;
+
+    if ((errno = __pipe_open_end(pipe, role, &file))) {
+        return errno;
+    }
+
+    options |= role == PIPE_READ_END ? FO_RDONLY : FO_WRONLY;
+    if ((errno = vfs_install_fd(file, options)) < 0) {
+        vfs_close(file);
+        return errno;
+    }
+
+    *fd = errno;
+    return 0;
+}
+
+const struct v_file_ops pipe_file_ops = { .close = __pipe_close,
+                                          .read = __pipe_read,
+                                          .read_page = default_file_read_page,
+                                          .write = __pipe_write,
+                                          .write_page = default_file_write_page,
+                                          .read_file = __pipe_read_fd,
+                                          .write_file = __pipe_write_fd,
+                                          .poll = __pipe_poll };
+
+const struct v_inode_ops pipe_inode_ops = { .open = __pipe_open };
+
+static int
+__pipefs_mount(struct v_superblock* vsb, struct v_dnode* mount_point)
+{
+    return ENOTSUP;
+}
+
+static int
+__pipefs_unmount(struct v_superblock* vsb)
+{
+    return ENOTSUP;
+}
+
+static void
+pipefs_init()
+{
+    struct filesystem* fs;
+    struct v_superblock* vsb;
+
+    fs = fsapi_fs_declare("pipefs", FSTYPE_PSEUDO);
+
+    fsapi_fs_set_mntops(fs, __pipefs_mount, __pipefs_unmount);
+    fsapi_fs_finalise(fs);
+
+    vsb = vfs_sb_alloc();
+    vsb->fs = fs;
+    fsapi_set_inode_initiator(vsb, __pipefs_init_inode);
+
+    mutex_init(&pipefs_mnt.lock);
+    llist_init_head(&pipefs_mnt.list);
+    llist_init_head(&pipefs_mnt.submnts);
+    llist_init_head(&pipefs_mnt.sibmnts);
+    vfs_vmnt_assign_sb(&pipefs_mnt, vsb);
+
+    // held by the private mount only
+    vfs_sb_unref(vsb);
+}
+EXPORT_FILE_SYSTEM(pipefs, pipefs_init);
+
+__DEFINE_LXSYSCALL2(int, pipe2, int*, fds, int, flags)
+{
+    int errno, rd_fd;
+    struct pipe* pipe;
+
+    if ((flags & ~FO_NONBLOCK)) {
+        return DO_STATUS(EINVAL);
+    }
+
+    if (!(pipe = __pipe_alloc())) {
+        return DO_STATUS(ENOMEM);
+    }
+
+    if ((errno = __pipe_install_end(pipe, PIPE_READ_END, flags, &rd_fd))) {
+        goto fail;
+    }
+
+    if ((errno = __pipe_install_end(pipe, PIPE_WRITE_END, flags, &fds[1]))) {
+        vfs_close_fd(rd_fd);
+        goto fail;
+    }
+
+    fds[0] = rd_fd;
+    return 0;
+
+fail:
+    if (!pipe->inodes) {
+        leaflet_return(pipe->buf_page);
+        vfree(pipe);
+    }
+
+    return DO_STATUS(errno);
+}
@@ -113,6 +113,27 @@ __twifs_fread(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
     return twi_node->ops.read(inode, buffer, len, fpos);
 }
 
+static int
+__twifs_fread_file(struct v_fd* fd, void* buffer, size_t len, size_t fpos)
+{
+    struct v_file* file = fd->file;
+    struct twifs_node* twi_node = (struct twifs_node*)file->inode->data;
+    if (twi_node && twi_node->ops.read_file) {
+        return twi_node->ops.read_file(file, buffer, len, fpos);
+    }
+    return __twifs_fread(file->inode, buffer, len, fpos);
+}
+
+static int
+__twifs_close(struct v_file* file)
+{
+    struct twifs_node* twi_node = (struct twifs_node*)file->inode->data;
+    if (twi_node && twi_node->ops.close) {
+        return twi_node->ops.close(file);
+    }
+    return 0;
+}
+
 static int
 __twifs_fread_pg(struct v_inode* inode, void* buffer, size_t fpos)
 {
@@ -229,6 +250,27 @@ __twifs_twimap_file_read(struct v_inode* inode,
     return twimap_read(map, buf, len, fpos);
 }
 
+static int
+__twifs_twimap_file_read_file(struct v_file* file, 
+                              void* buf, size_t len, size_t fpos)
+{
+    struct twimap* map = twinode_getdata(file->inode, struct twimap*);
+    return twimap_read_file(map, file, buf, len, fpos);
+}
+
+static inline void
+__twifs_mapped_node(struct twifs_node* twi_node, struct twimap* map)
+{
+    twi_node->data = map;
+    twi_node->ops.read = __twifs_twimap_file_read;
+    twi_node->ops.read_file = __twifs_twimap_file_read_file;
+    twi_node->ops.close = twimap_close_file;
+
+    // records are generated on the fly, let each open iterate
+    // on its own rather than caching them.
+    twi_node->itype = VFS_IFSEQDEV;
+}
+
 
 int
 twifs_rm_node(struct twifs_node* node)
@@ -282,6 +324,11 @@ twifs_basic_node_from(struct twifs_node* parent,
     twi_node->ops = def->ops;
     twi_node->data = data;
 
+    if (def->stream) {
+        // bypass the page cache, each open reads at its own pace.
+        twi_node->itype = VFS_IFSEQDEV;
+    }
+
     return twi_node;
 }
 
@@ -295,8 +342,7 @@ twifs_mapped_node_from(struct twifs_node* parent,
     map_     = twimap_create(data);
     twi_node = __twifs_create_node(parent, def->name, def->acl);
 
-    twi_node->data = map_;
-    twi_node->ops.read = __twifs_twimap_file_read;
+    __twifs_mapped_node(twi_node, map_);
     // twi_node->ops.write = __twifs_twimap_file_write;
 
     if (def->ops.go_next) {
@@ -322,8 +368,7 @@ twifs_mapping(struct twifs_node* parent,
     struct twimap* map = twimap_create(data);
     struct twifs_node* node = twifs_file_node_vargs(parent, fmt, args);
     
-    node->ops.read = __twifs_twimap_file_read;
-    node->data = map;
+    __twifs_mapped_node(node, map);
     node->acl = acl;
 
     return map;
@@ -335,8 +380,9 @@ twifs_register_plugins()
     ldga_invoke_fn0(twiplugin_inits);
 }
 
-const struct v_file_ops twifs_file_ops = { .close = default_file_close,
+const struct v_file_ops twifs_file_ops = { .close = __twifs_close,
                                            .read = __twifs_fread,
+                                           .read_file = __twifs_fread_file,
                                            .read_page = __twifs_fread_pg,
                                            .write = __twifs_fwrite,
                                            .write_page = __twifs_fwrite_pg,
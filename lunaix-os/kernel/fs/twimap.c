@@ -8,7 +8,10 @@
 
 #include <lunaix/mm/pagetable.h>
 
-#define TWIMAP_BUFFER_SIZE PAGE_SIZE
+#define TWIMAP_BUFFER_SIZE 512
+
+// largest class valloc can offer
+#define TWIMAP_BUFFER_MAX  (2 * PAGE_SIZE)
 
 void
 __twimap_default_reset(struct twimap* map)
@@ -22,6 +25,170 @@ __twimap_default_gonext(struct twimap* map)
     return 0;
 }
 
+static bool
+__twimap_grow(struct twimap* map, size_t need)
+{
+    size_t size = map->buf_size;
+    void* buf;
+
+    while (size < map->size_acc + need && size < TWIMAP_BUFFER_MAX) {
+        size *= 2;
+    }
+
+    size = MIN(size, TWIMAP_BUFFER_MAX);
+    if (size == map->buf_size) {
+        return false;
+    }
+
+    buf = valloc(size);
+    if (!buf) {
+        return false;
+    }
+
+    memcpy(buf, map->buffer, map->size_acc);
+    vfree(map->buffer);
+
+    map->buffer = buf;
+    map->buf_size = size;
+
+    return true;
+}
+
+static bool
+__twimap_iter_init(struct twimap_iter* iter, struct twimap* map)
+{
+    *iter = (struct twimap_iter) { .map = *map };
+
+    iter->map.index = NULL;
+    iter->map.size_acc = 0;
+    iter->map.buf_size = TWIMAP_BUFFER_SIZE;
+    iter->map.buffer = valloc(TWIMAP_BUFFER_SIZE);
+
+    return !!iter->map.buffer;
+}
+
+static void
+__twimap_iter_rewind(struct twimap_iter* iter)
+{
+    iter->map.size_acc = 0;
+    iter->consumed = 0;
+    iter->fpos = 0;
+    iter->nr_record = 0;
+    iter->started = false;
+    iter->eof = false;
+}
+
+/*
+    Walk from the start again to the record we were at. Records added
+    or removed meanwhile shift the walk, as would a fresh read.
+ */
+static bool
+__twimap_iter_seek(struct twimap_iter* iter)
+{
+    struct twimap* map = &iter->map;
+
+    map->reset(map);
+
+    for (unsigned long i = 0; i < iter->nr_record; i++) {
+        if (!map->go_next(map)) {
+            return false;
+        }
+    }
+
+    iter->stale = false;
+    return true;
+}
+
+/*
+    Render the next record into the buffer. Whatever reset() prints
+    goes ahead of the first record.
+ */
+static bool
+__twimap_iter_next(struct twimap_iter* iter)
+{
+    struct twimap* map = &iter->map;
+
+    if (iter->eof) {
+        return false;
+    }
+
+    if (iter->started && iter->stale && !__twimap_iter_seek(iter)) {
+        goto eof;
+    }
+
+    map->size_acc = 0;
+    iter->consumed = 0;
+
+    if (!iter->started) {
+        iter->started = true;
+        iter->stale = false;
+        map->reset(map);
+    }
+    else if (!map->go_next(map)) {
+        goto eof;
+    }
+    else {
+        iter->nr_record++;
+    }
+
+    map->read(map);
+    return true;
+
+eof:
+    map->size_acc = 0;
+    iter->consumed = 0;
+    iter->eof = true;
+    return false;
+}
+
+static int
+__twimap_iter_read(struct twimap_iter* iter, 
+                   void* buffer, size_t len, size_t fpos)
+{
+    struct twimap* map = &iter->map;
+    size_t avail, sz, copied = 0;
+
+    if (fpos < iter->fpos) {
+        __twimap_iter_rewind(iter);
+    }
+
+    iter->stale = true;
+
+    // only the first read after a seek pays for the skipping
+    while (iter->fpos < fpos) {
+        avail = map->size_acc - iter->consumed;
+        if (!avail) {
+            if (!__twimap_iter_next(iter)) {
+                return 0;
+            }
+            continue;
+        }
+
+        sz = MIN(avail, fpos - iter->fpos);
+        iter->consumed += sz;
+        iter->fpos += sz;
+    }
+
+    while (copied < len) {
+        avail = map->size_acc - iter->consumed;
+        if (!avail) {
+            if (!__twimap_iter_next(iter)) {
+                break;
+            }
+            continue;
+        }
+
+        sz = MIN(avail, len - copied);
+        memcpy(buffer + copied, map->buffer + iter->consumed, sz);
+
+        iter->consumed += sz;
+        iter->fpos += sz;
+        copied += sz;
+    }
+
+    return copied;
+}
+
 static int
 __twimap_file_read(struct v_inode* inode, void* buf, size_t len, size_t fpos)
 {
@@ -35,82 +202,123 @@ __twimap_file_read_page(struct v_inode* inode, void* buf, size_t fpos)
     return __twimap_file_read(inode, buf, PAGE_SIZE, fpos);
 }
 
+static int
+__twimap_file_read_file(struct v_fd* fd, 
+                        void* buf, size_t len, size_t fpos)
+{
+    struct twimap* map = (struct twimap*)(fd->file->inode->data);
+    return twimap_read_file(map, fd->file, buf, len, fpos);
+}
+
 int
 twimap_read(struct twimap* map, void* buffer, size_t len, size_t fpos)
 {
-    map->buffer = valloc(TWIMAP_BUFFER_SIZE);
-    map->size_acc = 0;
+    struct twimap_iter iter;
+    int rdlen;
 
-    map->reset(map);
+    if (!__twimap_iter_init(&iter, map)) {
+        return ENOMEM;
+    }
 
-    // FIXME what if TWIMAP_BUFFER_SIZE is not big enough?
+    rdlen = __twimap_iter_read(&iter, buffer, len, fpos);
 
-    size_t pos = map->size_acc;
-    while (pos <= fpos) {
-        map->size_acc = 0;
-        map->read(map);
-        pos += map->size_acc;
-        
-        if (!map->go_next(map)) {
-            break;
+    vfree(iter.map.buffer);
+    return rdlen;
+}
+
+int
+twimap_read_file(struct twimap* map, struct v_file* file, 
+                 void* buffer, size_t len, size_t fpos)
+{
+    struct twimap_iter* iter;
+
+    iter = (struct twimap_iter*)file->data;
+    if (!iter) {
+        iter = valloc(sizeof(*iter));
+        if (!iter) {
+            return ENOMEM;
         }
-    }
 
-    if (pos <= fpos) {
-        vfree(map->buffer);
-        return 0;
-    }
+        if (!__twimap_iter_init(iter, map)) {
+            vfree(iter);
+            return ENOMEM;
+        }
 
-    if (!fpos) {
-        pos = 0;
+        file->data = iter;
     }
 
-    size_t acc_size = MIN(len, map->size_acc - (pos - fpos)), rdlen = acc_size;
-    memcpy(buffer, map->buffer + (pos - fpos), acc_size);
+    return __twimap_iter_read(iter, buffer, len, fpos);
+}
 
-    while (acc_size < len && map->go_next(map)) {
-        map->size_acc = 0;
-        map->read(map);
-        rdlen = MIN(len - acc_size, map->size_acc);
-        memcpy(buffer + acc_size, map->buffer, rdlen);
-        acc_size += rdlen;
-    }
+int
+twimap_close_file(struct v_file* file)
+{
+    struct twimap_iter* iter;
 
-    if (acc_size <= len - 1) {
-        // pad zero
-        *(char*)(buffer + acc_size + 1) = 0;
+    iter = (struct twimap_iter*)file->data;
+    if (!iter) {
+        return 0;
     }
 
-    vfree(map->buffer);
-    return acc_size;
+    vfree(iter->map.buffer);
+    vfree(iter);
+    file->data = NULL;
+
+    return 0;
 }
 
 void
 twimap_printf(struct twimap* mapping, const char* fmt, ...)
 {
-    va_list args;
+    va_list args, tries;
+    size_t room, sz;
+
     va_start(args, fmt);
 
-    char* buf = mapping->buffer + mapping->size_acc;
+    while (1) {
+        room = mapping->buf_size - mapping->size_acc;
+        if (room <= 1) {
+            if (!__twimap_grow(mapping, 2)) {
+                goto done;
+            }
+            continue;
+        }
+
+        va_copy(tries, args);
+        sz = ksnprintfv(mapping->buffer + mapping->size_acc, 
+                        fmt, room, tries) - 1;
+        va_end(tries);
+
+        // truncated, have it in a larger buffer.
+        if (sz + 1 < room || !__twimap_grow(mapping, room * 2)) {
+            break;
+        }
+    }
 
-    mapping->size_acc += ksnprintfv(buf, fmt, TWIMAP_BUFFER_SIZE, args) - 1;
+    mapping->size_acc += sz;
 
+done:
     va_end(args);
 }
 
 int
 twimap_memcpy(struct twimap* mapping, const void* src, const size_t len)
 {
-    mapping->size_acc = MIN(TWIMAP_BUFFER_SIZE, len);
-    memcpy(mapping->buffer, src, mapping->size_acc);
+    mapping->size_acc = 0;
 
-    return mapping->size_acc;
+    return twimap_memappend(mapping, src, len);
 }
 
 int
 twimap_memappend(struct twimap* mapping, const void* src, const size_t len)
 {
-    size_t cpy_len = MIN(TWIMAP_BUFFER_SIZE - mapping->size_acc, len);
+    size_t cpy_len;
+
+    if (mapping->buf_size - mapping->size_acc < len) {
+        __twimap_grow(mapping, len);
+    }
+
+    cpy_len = MIN(mapping->buf_size - mapping->size_acc, len);
     memcpy(mapping->buffer + mapping->size_acc, src, cpy_len);
     mapping->size_acc += cpy_len;
 
@@ -128,8 +336,9 @@ twimap_create(void* data)
     return map;
 }
 
-struct v_file_ops twimap_file_ops = { .close = default_file_close,
+struct v_file_ops twimap_file_ops = { .close = twimap_close_file,
                                       .read = __twimap_file_read,
+                                      .read_file = __twimap_file_read_file,
                                       .read_page = __twimap_file_read_page,
                                       .readdir = default_file_readdir,
                                       .seek = default_file_seek,
@@ -46,6 +46,7 @@
 #include <klibc/string.h>
 #include <lunaix/foptions.h>
 #include <lunaix/fs.h>
+#include <lunaix/load.h>
 #include <lunaix/mm/cake.h>
 #include <lunaix/mm/valloc.h>
 #include <lunaix/process.h>
@@ -56,6 +57,10 @@
 #include <lunaix/fs/twifs.h>
 
 #include <usr/lunaix/dirent.h>
+#include <usr/lunaix/uio.h>
+
+// largest transfer that a vectored I/O can report back
+#define IOV_TOTAL_MAX   ((size_t)(-1U >> 1))
 
 #define INODE_ACCESSED  0
 #define INODE_MODIFY    1
@@ -205,6 +210,7 @@ __vfs_touch_inode(struct v_inode* inode, const int type)
 {
     if (type == INODE_MODIFY) {
         inode->mtime = clock_unixtime();
+        exec_cache_drop(inode);
     }
 
     else if (type == INODE_ACCESSED) {
@@ -442,26 +448,153 @@ vfs_fsync(struct v_file* file)
     return vfs_isync(file->inode);
 }
 
+static int
+__fdtable_expand(struct v_fdtable* fdtab, unsigned int min_size)
+{
+    struct v_fd** fds;
+    unsigned long* bitmap;
+    unsigned int size, words;
+
+    size = fdtab->size ? fdtab->size : VFS_FD_INIT;
+    while (size < min_size) {
+        size *= 2;
+    }
+
+    size = MIN(size, VFS_MAX_FD);
+    if (size < min_size) {
+        return EMFILE;
+    }
+
+    words = size / FDBITMAP_BITS;
+    fds = vzalloc(size * sizeof(struct v_fd*));
+    bitmap = vzalloc(words * sizeof(unsigned long));
+
+    if (!fds || !bitmap) {
+        vfree_safe(fds);
+        vfree_safe(bitmap);
+        return ENOMEM;
+    }
+
+    if (fdtab->size) {
+        memcpy(fds, fdtab->fds, fdtab->size * sizeof(struct v_fd*));
+        memcpy(bitmap, fdtab->bitmap, 
+               fdtab->size / FDBITMAP_BITS * sizeof(unsigned long));
+
+        vfree(fdtab->fds);
+        vfree(fdtab->bitmap);
+    }
+
+    fdtab->fds = fds;
+    fdtab->bitmap = bitmap;
+    fdtab->size = size;
+
+    return 0;
+}
+
+/*
+ * Find the lowest vacant slot. The search start from the
+ * hinted word, anything below it is known to be fully occupied.
+ */
+static int
+__fdtable_alloc_nolock(struct v_fdtable* fdtab, int* fd)
+{
+    int errno;
+    unsigned long word;
+    unsigned int i, nwords, slot;
+
+    nwords = fdtab->size / FDBITMAP_BITS;
+    for (i = fdtab->hint; i < nwords; i++) {
+        word = fdtab->bitmap[i];
+        if (~word) {
+            break;
+        }
+    }
+
+    fdtab->hint = i;
+    slot = i < nwords ? i * FDBITMAP_BITS + ctzl(~word) : fdtab->size;
+
+    if (slot >= fdtab->limit) {
+        return EMFILE;
+    }
+
+    if ((errno = fdtable_ensure(fdtab, slot))) {
+        return errno;
+    }
+
+    *fd = slot;
+    return 0;
+}
+
+int
+fdtable_ensure(struct v_fdtable* fdtab, int fd)
+{
+    if ((unsigned int)fd < fdtab->size) {
+        return 0;
+    }
+
+    return __fdtable_expand(fdtab, fd + 1);
+}
+
+void
+fdtable_set(struct v_fdtable* fdtab, int fd, struct v_fd* fd_s)
+{
+    unsigned int word = fd / FDBITMAP_BITS;
+    unsigned long mask = 1UL << (fd % FDBITMAP_BITS);
+
+    assert(TEST_FD(fdtab, fd));
+
+    fdtab->fds[fd] = fd_s;
+
+    if (fd_s) {
+        fdtab->bitmap[word] |= mask;
+        return;
+    }
+
+    fdtab->bitmap[word] &= ~mask;
+    fdtab->hint = MIN(fdtab->hint, word);
+}
+
+int
+fdtable_setlimit(struct v_fdtable* fdtab, unsigned int limit)
+{
+    if (!limit || limit > VFS_MAX_FD) {
+        return EINVAL;
+    }
+
+    // existing fd beyond the new limit stay valid, as per POSIX
+    lock_fdtable(fdtab);
+    fdtab->limit = limit;
+    unlock_fdtable(fdtab);
+
+    return 0;
+}
+
 int
-vfs_alloc_fdslot(int* fd)
+vfs_install_fd(struct v_file* file, int options)
 {
+    int fd, errno;
+    struct v_fd* fd_s;
     struct v_fdtable* fdtab;
 
     fdtab = __current->fdtable;
     lock_fdtable(fdtab);
 
-    for (size_t i = 0; i < VFS_MAX_FD; i++) {
-        if (__current->fdtable->fds[i]) {
-            continue;
-        }
-
-        *fd = i;
+    if ((errno = __fdtable_alloc_nolock(fdtab, &fd))) {
         unlock_fdtable(fdtab);
-        return 0;
+        return errno;
     }
 
+    fd_s = cake_grab(fd_pile);
+    memset(fd_s, 0, sizeof(*fd_s));
+
+    fd_s->file = file;
+    fd_s->flags = options;
+    file->f_options = options;
+    fdtable_set(fdtab, fd, fd_s);
+
     unlock_fdtable(fdtab);
-    return EMFILE;
+
+    return fd;
 }
 
 struct v_superblock*
@@ -671,6 +804,8 @@ vfs_i_free(struct v_inode* inode)
         vfree(inode->pg_cache);
     }
 
+    exec_cache_drop(inode);
+
     // we don't need to sync inode.
     // If an inode can be free, then it must be properly closed.
     // Hence it must be synced already!
@@ -702,14 +837,10 @@ vfs_getfd(int fd, struct v_fd** fd_s)
 {
     struct v_fdtable* fdtab;
 
-    if (!TEST_FD(fd)) {
-        return EBADF;
-    }
-
     fdtab = __current->fdtable;
 
     lock_fdtable(fdtab);
-    *fd_s = __current->fdtable->fds[fd];
+    *fd_s = TEST_FD(fdtab, fd) ? fdtab->fds[fd] : NULL;
     unlock_fdtable(fdtab);
 
     return !*fd_s ? EBADF : 0;
@@ -868,7 +999,7 @@ vfs_do_open(const char* path, int options)
 
     errno = __vfs_try_locate_file(path, &floc, loptions);
 
-    if (errno || (errno = vfs_alloc_fdslot(&fd))) {
+    if (errno) {
         return errno;
     }
 
@@ -891,23 +1022,24 @@ vfs_do_open(const char* path, int options)
         return errno;
     }
 
+    // fdtable lock nests outside of inode lock (see vfs_dup2), install
+    //  the fd before taking the inode.
+    if ((fd = vfs_install_fd(ofile, options)) < 0) {
+        vfs_close(ofile);
+        return fd;
+    }
+
     inode = ofile->inode;
     lock_inode(inode);
 
-    struct v_fd* fd_s = cake_grab(fd_pile);
-    memset(fd_s, 0, sizeof(*fd_s));
-
     if ((options & O_TRUNC)) {
-        file->inode->fsize = 0;   
+        inode->fsize = 0;
+        __vfs_touch_inode(inode, INODE_MODIFY);
     }
 
     if (vfs_get_dtype(inode->itype) == DT_DIR) {
         ofile->f_pos = 0;
     }
-    
-    fd_s->file = ofile;
-    fd_s->flags = options;
-    __current->fdtable->fds[fd] = fd_s;
 
     unlock_inode(inode);
     
@@ -920,23 +1052,31 @@ __DEFINE_LXSYSCALL2(int, open, const char*, path, int, options)
     return DO_STATUS_OR_RETURN(errno);
 }
 
-__DEFINE_LXSYSCALL1(int, close, int, fd)
+int
+vfs_close_fd(int fd)
 {
     struct v_fd* fd_s;
     int errno = 0;
     if ((errno = vfs_getfd(fd, &fd_s))) {
-        goto done_err;
+        return errno;
     }
 
     if ((errno = vfs_close(fd_s->file))) {
-        goto done_err;
+        return errno;
     }
 
     cake_release(fd_pile, fd_s);
-    __current->fdtable->fds[fd] = 0;
 
-done_err:
-    return DO_STATUS(errno);
+    lock_fdtable(__current->fdtable);
+    fdtable_set(__current->fdtable, fd, NULL);
+    unlock_fdtable(__current->fdtable);
+
+    return 0;
+}
+
+__DEFINE_LXSYSCALL1(int, close, int, fd)
+{
+    return DO_STATUS(vfs_close_fd(fd));
 }
 
 void
@@ -993,22 +1133,90 @@ done:
     return DO_STATUS_OR_RETURN(errno);
 }
 
-__DEFINE_LXSYSCALL3(int, read, int, fd, void*, buf, size_t, count)
+static inline int
+__vfs_read_at(struct v_fd* fd_s, void* buf, size_t count, u32_t fpos)
+{
+    struct v_file* file = fd_s->file;
+
+    if (check_seqdev_node(file->inode) || (fd_s->flags & FO_DIRECT)) {
+        if (file->ops->read_file) {
+            return file->ops->read_file(fd_s, buf, count, fpos);
+        }
+
+        return file->ops->read(file->inode, buf, count, fpos);
+    }
+    
+    return pcache_read(file->inode, buf, count, fpos);
+}
+
+static inline int
+__vfs_write_at(struct v_fd* fd_s, void* buf, size_t count, u32_t fpos)
+{
+    struct v_file* file = fd_s->file;
+
+    if (check_seqdev_node(file->inode) || (fd_s->flags & FO_DIRECT)) {
+        if (file->ops->write_file) {
+            return file->ops->write_file(fd_s, buf, count, fpos);
+        }
+
+        return file->ops->write(file->inode, buf, count, fpos);
+    }
+    
+    return pcache_write(file->inode, buf, count, fpos);
+}
+
+static int
+__vfs_check_iovec(const struct iovec* iov, int iovcnt)
+{
+    size_t total = 0;
+
+    if (iovcnt <= 0 || iovcnt > IOV_MAX) {
+        return EINVAL;
+    }
+
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (iov[i].iov_len > IOV_TOTAL_MAX - total) {
+            return EINVAL;
+        }
+
+        total += iov[i].iov_len;
+    }
+
+    return 0;
+}
+
+/**
+ * Read into the scatter list, starting at fpos (or current file
+ * position if fpos is not given). The inode lock is only taken once
+ * for the whole list, the transfer stops at the first short read.
+ */
+static int
+__vfs_do_readv(int fd, const struct iovec* iov, int iovcnt, u32_t* fpos)
 {
     int errno = 0;
+    size_t total = 0;
+    u32_t pos;
     struct v_fd* fd_s;
     struct v_inode* inode;
+    struct v_file* file;
 
     if ((errno = vfs_getfd(fd, &fd_s))) {
         goto done;
     }
 
-    struct v_file* file = fd_s->file;
+    file = fd_s->file;
     if (check_directory_node(file->inode)) {
         errno = EISDIR;
         goto done;
     }
 
+    // positional read makes no sense on a stream
+    if (fpos && check_seqdev_node(file->inode)) {
+        errno = ESPIPE;
+        goto done;
+    }
+
     if (!check_allow_read(file->inode)) {
         errno = EPERM;
         goto done;
@@ -1019,39 +1227,69 @@ __DEFINE_LXSYSCALL3(int, read, int, fd, void*, buf, size_t, count)
 
     __vfs_touch_inode(inode, INODE_ACCESSED);
 
-    if (check_seqdev_node(inode) || (fd_s->flags & FO_DIRECT)) {
-        errno = file->ops->read(inode, buf, count, file->f_pos);
-    } else {
-        errno = pcache_read(inode, buf, count, file->f_pos);
+    pos = fpos ? *fpos : file->f_pos;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (!iov[i].iov_len) {
+            continue;
+        }
+
+        errno = __vfs_read_at(fd_s, iov[i].iov_base, iov[i].iov_len, pos);
+        if (errno <= 0) {
+            break;
+        }
+
+        pos   += errno;
+        total += errno;
+
+        if ((size_t)errno < iov[i].iov_len) {
+            break;
+        }
     }
 
-    if (errno > 0) {
-        file->f_pos += errno;
-        unlock_inode(inode);
-        return errno;
+    if (!fpos) {
+        file->f_pos = pos;
     }
 
     unlock_inode(inode);
 
+    if (total) {
+        return total;
+    }
+
 done:
     return DO_STATUS(errno);
 }
 
-__DEFINE_LXSYSCALL3(int, write, int, fd, void*, buf, size_t, count)
+/**
+ * Write out the gather list, starting at fpos (or current file
+ * position if fpos is not given). The inode lock is only taken once
+ * for the whole list, the transfer stops at the first short write.
+ */
+static int
+__vfs_do_writev(int fd, const struct iovec* iov, int iovcnt, u32_t* fpos)
 {
     int errno = 0;
+    size_t total = 0;
+    u32_t pos;
     struct v_fd* fd_s;
+    struct v_inode* inode;
+    struct v_file* file;
+
     if ((errno = vfs_getfd(fd, &fd_s))) {
         goto done;
     }
 
-    struct v_inode* inode;
-    struct v_file* file = fd_s->file;
-
+    file = fd_s->file;
     if ((errno = vfs_check_writable(file->dnode))) {
         goto done;
     }
 
+    if (fpos && check_seqdev_node(file->inode)) {
+        errno = ESPIPE;
+        goto done;
+    }
+
     if (check_directory_node(file->inode)) {
         errno = EISDIR;
         goto done;
@@ -1061,30 +1299,269 @@ __DEFINE_LXSYSCALL3(int, write, int, fd, void*, buf, size_t, count)
     lock_inode(inode);
 
     __vfs_touch_inode(inode, INODE_MODIFY);
-    if ((fd_s->flags & O_APPEND)) {
+    if (!fpos && (fd_s->flags & O_APPEND)) {
         file->f_pos = inode->fsize;
     }
 
-    if (check_seqdev_node(inode) || (fd_s->flags & FO_DIRECT)) {
-        errno = file->ops->write(inode, buf, count, file->f_pos);
-    } else {
-        errno = pcache_write(inode, buf, count, file->f_pos);
+    pos = fpos ? *fpos : file->f_pos;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (!iov[i].iov_len) {
+            continue;
+        }
+
+        errno = __vfs_write_at(fd_s, iov[i].iov_base, iov[i].iov_len, pos);
+        if (errno <= 0) {
+            break;
+        }
+
+        pos   += errno;
+        total += errno;
+
+        if ((size_t)errno < iov[i].iov_len) {
+            break;
+        }
     }
 
-    if (errno > 0) {
-        file->f_pos += errno;
-        inode->fsize = MAX(inode->fsize, file->f_pos);
+    if (total) {
+        inode->fsize = MAX(inode->fsize, pos);
+    }
 
-        unlock_inode(inode);
-        return errno;
+    if (!fpos) {
+        file->f_pos = pos;
     }
 
     unlock_inode(inode);
 
+    if (total) {
+        return total;
+    }
+
 done:
     return DO_STATUS(errno);
 }
 
+__DEFINE_LXSYSCALL3(int, read, int, fd, void*, buf, size_t, count)
+{
+    struct iovec iov = { .iov_base = buf, .iov_len = count };
+
+    return __vfs_do_readv(fd, &iov, 1, NULL);
+}
+
+__DEFINE_LXSYSCALL3(int, write, int, fd, void*, buf, size_t, count)
+{
+    struct iovec iov = { .iov_base = buf, .iov_len = count };
+
+    return __vfs_do_writev(fd, &iov, 1, NULL);
+}
+
+__DEFINE_LXSYSCALL3(int, readv, int, fd, const struct iovec*, iov, int, iovcnt)
+{
+    int errno;
+
+    if ((errno = __vfs_check_iovec(iov, iovcnt))) {
+        return DO_STATUS(errno);
+    }
+
+    return __vfs_do_readv(fd, iov, iovcnt, NULL);
+}
+
+__DEFINE_LXSYSCALL3(int, writev, int, fd, const struct iovec*, iov, int, iovcnt)
+{
+    int errno;
+
+    if ((errno = __vfs_check_iovec(iov, iovcnt))) {
+        return DO_STATUS(errno);
+    }
+
+    return __vfs_do_writev(fd, iov, iovcnt, NULL);
+}
+
+__DEFINE_LXSYSCALL4(int, pread, int, fd, void*, buf, size_t, count, 
+                    off_t, offset)
+{
+    u32_t fpos = offset;
+    struct iovec iov = { .iov_base = buf, .iov_len = count };
+
+    // off_t is unsigned here, a negative offset from user shows up
+    // with the sign bit set.
+    if ((long)offset < 0 || (off_t)fpos != offset) {
+        return DO_STATUS(EINVAL);
+    }
+
+    return __vfs_do_readv(fd, &iov, 1, &fpos);
+}
+
+__DEFINE_LXSYSCALL4(int, pwrite, int, fd, void*, buf, size_t, count, 
+                    off_t, offset)
+{
+    u32_t fpos = offset;
+    struct iovec iov = { .iov_base = buf, .iov_len = count };
+
+    if ((long)offset < 0 || (off_t)fpos != offset) {
+        return DO_STATUS(EINVAL);
+    }
+
+    return __vfs_do_writev(fd, &iov, 1, &fpos);
+}
+
+struct __sendfile_ctx
+{
+    struct v_fd* out;
+    u32_t out_pos;
+};
+
+static int
+__sendfile_actor(void* ctx, void* chunk, u32_t len)
+{
+    int written;
+    struct __sendfile_ctx* sf;
+
+    sf = (struct __sendfile_ctx*)ctx;
+
+    // device sinks go straight to the device ops, other sinks 
+    // land in their own page cache. Either way, no user buffer.
+    written = __vfs_write_at(sf->out, chunk, len, sf->out_pos);
+    if (written > 0) {
+        sf->out_pos += written;
+    }
+
+    return written;
+}
+
+static int
+__sendfile_bounced(struct v_fd* in, struct __sendfile_ctx* ctx, 
+                   u32_t len, u32_t fpos)
+{
+    int errno = 0, rdsz, wrsz;
+    u32_t total = 0;
+    void* bounce;
+
+    // source has no page cache to splice from, stage it in a page instead.
+    bounce = valloc(PAGE_SIZE);
+    if (!bounce) {
+        return ENOMEM;
+    }
+
+    while (total < len) {
+        rdsz = __vfs_read_at(in, bounce, MIN(len - total, PAGE_SIZE), fpos);
+        if (rdsz <= 0) {
+            errno = rdsz;
+            break;
+        }
+
+        wrsz = __sendfile_actor(ctx, bounce, rdsz);
+        if (wrsz <= 0) {
+            errno = wrsz;
+            break;
+        }
+
+        total += wrsz;
+        fpos  += wrsz;
+
+        if (wrsz < rdsz) {
+            break;
+        }
+    }
+
+    vfree(bounce);
+    return total ? (int)total : errno;
+}
+
+static inline void
+__lock_inode_pair(struct v_inode* a, struct v_inode* b)
+{
+    // lock in a stable order, so two opposing transfers can't deadlock
+    if ((ptr_t)a > (ptr_t)b) {
+        lock_inode(b);
+        lock_inode(a);
+    } else {
+        lock_inode(a);
+        lock_inode(b);
+    }
+}
+
+__DEFINE_LXSYSCALL4(int, sendfile, int, out_fd, int, in_fd, 
+                    off_t*, offset, size_t, count)
+{
+    int errno = 0;
+    u32_t pos;
+    struct v_fd *in_s, *out_s;
+    struct v_file *in, *out;
+    struct __sendfile_ctx ctx;
+
+    if ((errno = vfs_getfd(in_fd, &in_s))) {
+        goto done;
+    }
+
+    if ((errno = vfs_getfd(out_fd, &out_s))) {
+        goto done;
+    }
+
+    in  = in_s->file;
+    out = out_s->file;
+
+    if (check_directory_node(in->inode) || check_directory_node(out->inode)) {
+        errno = EISDIR;
+        goto done;
+    }
+
+    if (!check_allow_read(in->inode)) {
+        errno = EPERM;
+        goto done;
+    }
+
+    if ((errno = vfs_check_writable(out->dnode))) {
+        goto done;
+    }
+
+    if (in->inode == out->inode) {
+        errno = EINVAL;
+        goto done;
+    }
+
+    count = MIN(count, IOV_TOTAL_MAX);
+
+    __lock_inode_pair(in->inode, out->inode);
+
+    __vfs_touch_inode(in->inode, INODE_ACCESSED);
+    __vfs_touch_inode(out->inode, INODE_MODIFY);
+
+    pos = offset ? *offset : in->f_pos;
+
+    ctx.out = out_s;
+    ctx.out_pos = (out_s->flags & O_APPEND) ? out->inode->fsize : out->f_pos;
+
+    if (check_seqdev_node(in->inode) || (in_s->flags & FO_DIRECT)) {
+        errno = __sendfile_bounced(in_s, &ctx, count, pos);
+    } 
+    else if (pos >= in->inode->fsize) {
+        errno = 0;
+    }
+    else {
+        count = MIN(count, in->inode->fsize - pos);
+        errno = pcache_read_actor(in->inode, count, pos, 
+                                  __sendfile_actor, &ctx);
+    }
+
+    if (errno > 0) {
+        out->f_pos = ctx.out_pos;
+        out->inode->fsize = MAX(out->inode->fsize, ctx.out_pos);
+
+        if (offset) {
+            *offset = pos + errno;
+        } else {
+            in->f_pos = pos + errno;
+        }
+    }
+
+    unlock_inode(out->inode);
+    unlock_inode(in->inode);
+
+done:
+    return DO_STATUS_OR_RETURN(errno);
+}
+
 __DEFINE_LXSYSCALL3(int, lseek, int, fd, int, offset, int, options)
 {
     int errno = 0;
@@ -1214,6 +1691,10 @@ vfs_get_dtype(int itype)
         return dtype;
     }
 
+    if (check_itype(itype, VFS_IFPIPE)) {
+        return DT_PIPE;
+    }
+
     // TODO other types
     
     return dtype;
@@ -1227,24 +1708,46 @@ fdtable_create()
     fdtab = vzalloc(sizeof(struct v_fdtable));
     mutex_init(&fdtab->lock);
 
+    fdtab->limit = VFS_FD_DEFAULT_LIMIT;
+    if (__fdtable_expand(fdtab, VFS_FD_INIT)) {
+        vfree(fdtab);
+        return NULL;
+    }
+
     return fdtab;
 }
 
-void
+int
 fdtable_copy(struct v_fdtable* dest, struct v_fdtable* src)
 {
+    int errno;
+    struct v_fd* fd_s;
+
     lock_fdtable(dest);
     lock_fdtable(src);
-    
-    for (size_t i = 0; i < VFS_MAX_FD; i++) {
+
+    dest->limit = src->limit;
+    if ((errno = fdtable_ensure(dest, src->size - 1))) {
+        goto done;
+    }
+
+    for (size_t i = 0; i < src->size; i++) {
         struct v_fd* fd = src->fds[i];
         if (!fd)
             continue;
-        vfs_dup_fd(fd, &dest->fds[i]);
+
+        if ((errno = vfs_dup_fd(fd, &fd_s))) {
+            goto done;
+        }
+
+        fdtable_set(dest, i, fd_s);
     }
 
+done:
     unlock_fdtable(dest);
     unlock_fdtable(src);
+
+    return errno;
 }
 
 void
@@ -1252,6 +1755,8 @@ fdtable_free(struct v_fdtable* table)
 {
     assert(!mutex_on_hold(&table->lock));
 
+    vfree(table->fds);
+    vfree(table->bitmap);
     vfree(table);
 }
 
@@ -1576,24 +2081,34 @@ vfs_dup2(int oldfd, int newfd)
         goto done;
     }
 
-    if (!TEST_FD(newfd)) {
+    fdtab = __current->fdtable;
+
+    if (newfd < 0 || (unsigned int)newfd >= fdtab->limit) {
         errno = EBADF;
         goto done;
     }
 
-    fdtab = __current->fdtable;
     lock_fdtable(fdtab);
 
-    newfd_s = fdtab->fds[newfd];
-    if (newfd_s && (errno = vfs_close(newfd_s->file))) {
+    if ((errno = fdtable_ensure(fdtab, newfd))) {
         goto unlock_and_done;
     }
 
+    newfd_s = fdtab->fds[newfd];
+    if (newfd_s) {
+        if ((errno = vfs_close(newfd_s->file))) {
+            goto unlock_and_done;
+        }
+
+        vfs_free_fd(newfd_s);
+        fdtable_set(fdtab, newfd, NULL);
+    }
+
     if ((errno = vfs_dup_fd(oldfd_s, &newfd_s))) {
         goto unlock_and_done;
     }
 
-    fdtab->fds[newfd] = newfd_s;
+    fdtable_set(fdtab, newfd, newfd_s);
     
     unlock_fdtable(fdtab);
     return newfd;
@@ -1618,12 +2133,17 @@ __DEFINE_LXSYSCALL1(int, dup, int, oldfd)
         goto done;
     }
 
-    if (!(errno = vfs_alloc_fdslot(&newfd)) &&
+    lock_fdtable(__current->fdtable);
+
+    if (!(errno = __fdtable_alloc_nolock(__current->fdtable, &newfd)) &&
         !(errno = vfs_dup_fd(oldfd_s, &newfd_s))) {
-        __current->fdtable->fds[newfd] = newfd_s;
+        fdtable_set(__current->fdtable, newfd, newfd_s);
+        unlock_fdtable(__current->fdtable);
         return newfd;
     }
 
+    unlock_fdtable(__current->fdtable);
+
 done:
     return DO_STATUS(errno);
 }
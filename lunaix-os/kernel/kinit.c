@@ -15,6 +15,7 @@
 #include <lunaix/spike.h>
 #include <lunaix/trace.h>
 #include <lunaix/owloysius.h>
+#include <lunaix/boottime.h>
 #include <lunaix/hart_state.h>
 #include <lunaix/syslog.h>
 #include <lunaix/sections.h>
@@ -104,6 +105,8 @@ log_bootup_time()
 void
 kernel_bootstrap(struct boot_handoff* bhctx)
 {
+    boottime_start();
+
     pmm_init(bhctx);
     // now we can start reserving physical space
 
@@ -121,12 +124,12 @@ kernel_bootstrap(struct boot_handoff* bhctx)
     /* Prepare stack trace environment */
     trace_modksyms_init(bhctx);
 
-    device_scan_drivers();
+    boottime_step(device_scan_drivers());
 
     initfn_invoke_sysconf();
     
     __remap_and_load_dtb(bhctx);
-    device_sysconf_load();
+    boottime_step(device_sysconf_load());
 
     // TODO register devtree hooks
     // TODO re-scan devtree to bind devices.
@@ -137,13 +140,13 @@ kernel_bootstrap(struct boot_handoff* bhctx)
 
     initfn_invoke_earlyboot();
 
-    vfs_init();
-    fsm_init();
+    boottime_step(vfs_init());
+    boottime_step(fsm_init());
     input_init();
     block_init();
     sched_init();
 
-    device_onboot_load();
+    boottime_step(device_onboot_load());
 
     /* the bare metal are now happy, let's get software over with */
 
@@ -1,57 +1,168 @@
 #include <klibc/string.h>
 #include <lunaix/clock.h>
-#include <lunaix/mm/valloc.h>
+#include <lunaix/compiler.h>
 #include <lunaix/spike.h>
 #include <lunaix/syslog.h>
 
 #include "kp_records.h"
 
-struct kp_records*
-kprec_create(int max_recs)
+static inline u32_t
+__ent_size(u32_t len)
 {
-    struct kp_records* recs = (struct kp_records*)valloc(KP_RECS_SIZE);
+    return ROUNDUP(KP_ENT_SIZE + len, sizeof(u32_t));
+}
 
-    *recs = (struct kp_records){ .max_recs = max_recs,
-                                 .log_lvl = KLOG_DEBUG,
-                                 .kp_ent_wp = &recs->kp_ents.ents };
+static inline struct kp_entry*
+__ent_at(struct kp_records* recs, u32_t off)
+{
+    return (struct kp_entry*)&recs->ring[off];
+}
 
-    llist_init_head(&recs->kp_ents.ents);
+static inline bool
+__wraps_at(struct kp_records* recs, u32_t off)
+{
+    return off + KP_ENT_SIZE > recs->size
+            || __ent_at(recs, off)->len == KP_ENT_WRAP;
+}
 
-    return recs;
+static inline bool
+__kprecs_empty(struct kp_records* recs)
+{
+    return recs->first_seq == recs->next_seq;
 }
 
-static inline int
-kprecs_full(struct kp_records* recs)
+/*
+    Evict every record starting within [from, to). The first_seq is
+    bumped before the space is reused, so that a reader copying a
+    record being overwritten will notice.
+ */
+static void
+__evict_range(struct kp_records* recs, u32_t from, u32_t to)
 {
-    return recs->cur_recs >= recs->max_recs;
+    while (!__kprecs_empty(recs)
+            && recs->head >= from && recs->head < to)
+    {
+        if (__wraps_at(recs, recs->head)) {
+            recs->head = 0;
+            continue;
+        }
+
+        recs->head += __ent_size(__ent_at(recs, recs->head)->len);
+        recs->first_seq++;
+    }
+
+    barrier();
 }
 
 struct kp_entry*
-kprec_put(struct kp_records* recs, int lvl, char* content, size_t len)
+kprec_put(struct kp_records* recs, int lvl, const char* content, size_t len)
 {
+    struct kp_entry* ent;
+    u32_t need;
+    reg_t flags;
+
     assert(len < 256);
 
-    struct kp_entry* ent;
-    if (!kprecs_full(recs)) {
-        assert(recs->kp_ent_wp == &recs->kp_ents.ents);
+    need  = __ent_size(len + 1);
+    flags = spinlock_acquire_irqsave(&recs->lock);
 
-        ent = (struct kp_entry*)vzalloc(KP_ENT_SIZE);
-        llist_append(&recs->kp_ents.ents, &ent->ents);
-        recs->cur_recs++;
-    } else {
-        recs->kp_ent_wp = recs->kp_ent_wp->next;
-        ent = container_of(recs->kp_ent_wp, struct kp_entry, ents);
+    if (recs->tail + need > recs->size) {
+        __evict_range(recs, recs->tail, recs->size);
+
+        if (recs->tail + KP_ENT_SIZE <= recs->size) {
+            __ent_at(recs, recs->tail)->len = KP_ENT_WRAP;
+        }
+
+        recs->tail = 0;
     }
 
-    vfree_safe(ent->content);
+    __evict_range(recs, recs->tail, recs->tail + need);
 
-    char* _content = valloc(len);
-    memcpy(_content, content, len);
+    if (__kprecs_empty(recs)) {
+        recs->head = recs->tail;
+    }
 
-    ent->lvl = lvl;
-    ent->content = _content;
+    ent = __ent_at(recs, recs->tail);
+    ent->seq  = recs->next_seq;
     ent->time = clock_systime();
-    ent->len = len;
+    ent->lvl  = lvl;
+    ent->len  = len + 1;
+
+    memcpy(ent->content, content, len);
+    ent->content[len] = '\0';
+
+    barrier();
+
+    recs->tail += need;
+    recs->next_seq++;
+
+    spinlock_release_irqrestore(&recs->lock, flags);
 
     return ent;
-}
\ No newline at end of file
+}
+
+void
+kprec_cursor_oldest(struct kp_records* recs, struct kp_cursor* cursor)
+{
+    reg_t flags;
+
+    flags = spinlock_acquire_irqsave(&recs->lock);
+
+    cursor->seq = recs->first_seq;
+    cursor->off = recs->head;
+
+    spinlock_release_irqrestore(&recs->lock, flags);
+}
+
+int
+kprec_read(struct kp_records* recs, struct kp_cursor* cursor,
+           struct kp_entry* hdr, char* buf, size_t len)
+{
+    struct kp_entry* ent;
+    u32_t off;
+    size_t sz;
+
+    assert(len);
+
+retry:
+    if (cursor->seq - recs->first_seq > recs->next_seq - recs->first_seq) {
+        // lapped by the writer
+        kprec_cursor_oldest(recs, cursor);
+    }
+
+    if (cursor->seq == recs->next_seq) {
+        return 0;
+    }
+
+    barrier();
+
+    off = cursor->off;
+    if (__wraps_at(recs, off)) {
+        off = 0;
+    }
+
+    ent  = __ent_at(recs, off);
+    *hdr = *ent;
+
+    sz = MIN(len - 1, (size_t)hdr->len);
+    if (hdr->len != KP_ENT_WRAP && off + KP_ENT_SIZE + sz <= recs->size) {
+        memcpy(buf, ent->content, sz);
+    }
+
+    barrier();
+
+    if (hdr->seq != cursor->seq
+        || cursor->seq - recs->first_seq >= recs->next_seq - recs->first_seq)
+    {
+        // overwritten while we were copying
+        kprec_cursor_oldest(recs, cursor);
+        goto retry;
+    }
+
+    buf[sz] = '\0';
+
+    cursor->seq++;
+    cursor->off = off + __ent_size(hdr->len);
+
+    return 1;
+}
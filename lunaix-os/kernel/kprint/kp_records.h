@@ -1,35 +1,88 @@
 #ifndef __LUNAIX_KP_RECORDS_H
 #define __LUNAIX_KP_RECORDS_H
 
-#include <lunaix/ds/llist.h>
+#include <lunaix/ds/spinlock.h>
 #include <lunaix/time.h>
+#include <lunaix/types.h>
 
+/*
+    Marks the end of the used part of the ring, the next record is
+    at the very beginning.
+ */
+#define KP_ENT_WRAP     0xffff
+
+/**
+ * @brief A log record, laid inline in the ring and immediately
+ * followed by its NUL terminated content.
+ */
 struct kp_entry
 {
-    struct llist_header ents;
-    int lvl;
+    u32_t seq;
     time_t time;
-    char* content;
-    size_t len;
+    u16_t len;          // of the content, including the NUL
+    u16_t lvl;
+    char content[0];
 };
 #define KP_ENT_SIZE sizeof(struct kp_entry)
 
+/**
+ * @brief Where a reader is in the records. A reader that has been
+ * lapped by the writer is put back to the oldest record.
+ */
+struct kp_cursor
+{
+    u32_t seq;
+    u32_t off;
+};
+
+/**
+ * @brief A preallocated byte ring of variable length records. There
+ * is only one writer at a time, serialized by the lock, while readers
+ * go lock-free and validate what they copied by sequence number.
+ */
 struct kp_records
 {
-    struct kp_entry kp_ents;
+    char* ring;
+    u32_t size;
 
-    struct llist_header* kp_ent_wp;
+    // byte offset of the oldest record, and of the next record
+    u32_t head;
+    u32_t tail;
 
-    int max_recs;
-    int cur_recs;
+    // sequence number of the oldest record, and of the next record
+    volatile u32_t first_seq;
+    volatile u32_t next_seq;
+
+    spinlock_t lock;
     int log_lvl;
 };
 #define KP_RECS_SIZE sizeof(struct kp_records)
 
-struct kp_records*
-kprec_create(int max_recs);
+#define DEFINE_KP_RECORDS(name, buffer)                                 \
+    struct kp_records name = { .ring = (buffer),                        \
+                               .size = sizeof(buffer) }
 
+/**
+ * @brief Append a record, the oldest records are evicted to make
+ * room. Never allocates.
+ *
+ * @return the record in the ring, it is valid until being evicted.
+ */
 struct kp_entry*
-kprec_put(struct kp_records*, int lvl, char* content, size_t len);
+kprec_put(struct kp_records*, int lvl, const char* content, size_t len);
+
+void
+kprec_cursor_oldest(struct kp_records*, struct kp_cursor* cursor);
+
+/**
+ * @brief Read the record under the cursor and advance it. The header
+ * is copied to `hdr`, and the content to `buf`, truncated to `len`
+ * but always NUL terminated.
+ *
+ * @return 0 if there is nothing new, 1 otherwise.
+ */
+int
+kprec_read(struct kp_records*, struct kp_cursor* cursor,
+           struct kp_entry* hdr, char* buf, size_t len);
 
 #endif /* __LUNAIX_KP_RECORDS_H */
@@ -6,25 +6,23 @@
 #include <lunaix/device.h>
 #include <lunaix/owloysius.h>
 #include <lunaix/ds/flipbuf.h>
+#include <lunaix/mm/valloc.h>
 
 #include <hal/term.h>
 
 #include <klibc/strfmt.h>
+#include <klibc/string.h>
 
 #include "kp_records.h"
 
 #define MAX_BUFSZ_HLF 256
-#define MAX_KPENT_NUM 1024
+#define KP_LOG_SIZE   (32 * 1024)
 
 static char tmp_buf[MAX_BUFSZ_HLF * 2];
 static DEFINE_FLIPBUF(fmtbuf, MAX_BUFSZ_HLF, tmp_buf);
 
-static struct kp_records kprecs = {
-    .kp_ents = { .ents = { .next = &kprecs.kp_ents.ents,
-                           .prev = &kprecs.kp_ents.ents } },
-    .max_recs = MAX_KPENT_NUM,
-    .kp_ent_wp = &kprecs.kp_ents.ents
-};
+static char kp_log_ring[KP_LOG_SIZE];
+static DEFINE_KP_RECORDS(kprecs, kp_log_ring);
 export_symbol(debug, kprintf, kprecs);
 
 static char*
@@ -41,7 +39,7 @@ shift_level(const char* str, int* level)
 }
 
 static inline void
-__put_console(const struct kp_entry* ent)
+__put_console(const struct kp_entry* ent, const char* content)
 {
     char* buf;
     time_t s, ms;
@@ -55,7 +53,7 @@ __put_console(const struct kp_entry* ent)
     ms  = ent->time % 1000;
     buf = flipbuf_flip(&fmtbuf);
     sz  = ksnprintf(buf, MAX_BUFSZ_HLF, 
-                    "[%04d.%03d] %s", s, ms, ent->content);
+                    "[%04d.%03d] %s", s, ms, content);
     
     sysconsole->ops.write(sysconsole, buf, 0, sz);
 }
@@ -63,7 +61,10 @@ __put_console(const struct kp_entry* ent)
 static inline void
 kprintf_put(int level, const char* buf, size_t sz)
 {
-    __put_console(kprec_put(&kprecs, level, buf, sz));
+    struct kp_entry* ent;
+
+    ent = kprec_put(&kprecs, level, buf, sz);
+    __put_console(ent, ent->content);
 }
 
 static inline void
@@ -98,42 +99,93 @@ kprintf_v(const char* component, const char* fmt, ...)
     va_end(args);
 }
 
-static void
-__twimap_read_kmsg(struct twimap* map)
+/*
+    Each open of /kmsg carries its own cursor, so a reader picks up
+    from where it left off rather than re-reading everything.
+ */
+
+static int
+__twifs_read_kmsg(struct v_file* file, void* buffer, size_t len, size_t fpos)
 {
-    struct kp_records* __kprecs = twimap_data(map, struct kp_records*);
-
-    /*
-        XXX we can foreach all records in a single twimap read call,
-            as records is monotonic increasing by design.
-    */
-    struct kp_entry *pos, *n;
-    llist_for_each(pos, n, __kprecs->kp_ent_wp, ents)
+    struct kp_records* recs;
+    struct kp_cursor* cursor;
+    struct kp_entry hdr;
+    char line[MAX_BUFSZ_HLF];
+    char content[MAX_BUFSZ_HLF];
+    struct kp_cursor saved;
+    size_t sz, copied = 0;
+
+    recs   = twinode_getdata(file->inode, struct kp_records*);
+    cursor = (struct kp_cursor*)file->data;
+
+    if (!cursor) {
+        cursor = valloc(sizeof(*cursor));
+        if (!cursor) {
+            return ENOMEM;
+        }
+
+        kprec_cursor_oldest(recs, cursor);
+        file->data = cursor;
+    }
+
+    while (copied < len)
     {
-        time_t s = pos->time / 1000;
-        time_t ms = pos->time % 1000;
-        twimap_printf(map, "[%05d.%03d] %s", s, ms, pos->content);
+        saved = *cursor;
+        if (!kprec_read(recs, cursor, &hdr, content, sizeof(content))) {
+            break;
+        }
+
+        sz = ksnprintf(line, sizeof(line), "[%05d.%03d] %s",
+                       hdr.time / 1000, hdr.time % 1000, content) - 1;
+
+        if (copied + sz > len) {
+            if (copied) {
+                // leave it for the next read.
+                *cursor = saved;
+                break;
+            }
+
+            sz = len;
+        }
+
+        memcpy(buffer + copied, line, sz);
+        copied += sz;
     }
+
+    return copied;
+}
+
+static int
+__twifs_close_kmsg(struct v_file* file)
+{
+    vfree_safe(file->data);
+    file->data = NULL;
+
+    return 0;
 }
 
 static void
 kprintf_mapping_init()
 {
-    twimap_export_value(NULL, kmsg, FSACL_ugR, &kprecs);
+    twifs_export_stream(NULL, kmsg, FSACL_ugR, &kprecs);
 }
 EXPORT_TWIFS_PLUGIN(kprintf, kprintf_mapping_init);
 
 
 void 
 kprintf_dump_logs() {
+    struct kp_cursor cursor;
+    struct kp_entry hdr;
+    char content[MAX_BUFSZ_HLF];
+
     if (unlikely(!sysconsole)) {
         return;
     }
 
-    struct kp_entry *pos, *n;
-    llist_for_each(pos, n, kprecs.kp_ent_wp, ents)
+    kprec_cursor_oldest(&kprecs, &cursor);
+    while (kprec_read(&kprecs, &cursor, &hdr, content, sizeof(content)))
     {
-        __put_console(pos);
+        __put_console(&hdr, content);
     }
 }
 
@@ -0,0 +1,93 @@
+/**
+ * @file kstats.c
+ * @brief Binary statistics, exported as /kstats.
+ *
+ * Subsystems contribute records with EXPORT_KSTAT, each is rendered
+ * as one twimap record, so a reader gets all of them in a single
+ * read() of a large enough buffer, without any text formatting. The
+ * layout is defined in <usr/lunaix/kstats.h>.
+ */
+
+#include <lunaix/kstats.h>
+#include <lunaix/clock.h>
+#include <lunaix/fs/twifs.h>
+
+extern ptr_t __lga_kstats_start[];
+extern ptr_t __lga_kstats_end[];
+
+size_t
+kstat_begin(struct twimap* map, int type, size_t ent_size)
+{
+    struct kstat_record rec;
+    size_t off;
+
+    rec = (struct kstat_record) {
+        .type = type,
+        .version = KSTAT_VERSION,
+        .ent_size = ent_size
+    };
+
+    off = map->size_acc;
+    twimap_memappend(map, &rec, sizeof(rec));
+
+    return off;
+}
+
+void
+kstat_end(struct twimap* map, size_t rec_off)
+{
+    struct kstat_record* rec;
+
+    rec = (struct kstat_record*)(map->buffer + rec_off);
+    rec->size = map->size_acc - rec_off;
+    rec->nr_ents = (rec->size - sizeof(*rec)) / rec->ent_size;
+}
+
+static int
+__twimap_gonext_kstats(struct twimap* map)
+{
+    ptr_t* pos = twimap_index(map, ptr_t*);
+
+    if (pos + 1 >= __lga_kstats_end) {
+        return 0;
+    }
+
+    map->index = pos + 1;
+    return 1;
+}
+
+static void
+__twimap_reset_kstats(struct twimap* map)
+{
+    struct kstat_header hdr;
+
+    map->index = __lga_kstats_start;
+
+    hdr = (struct kstat_header) {
+        .magic = KSTAT_MAGIC,
+        .version = KSTAT_VERSION,
+        .hdr_size = sizeof(hdr),
+        .timestamp = clock_systime()
+    };
+
+    twimap_memappend(map, &hdr, sizeof(hdr));
+}
+
+static void
+__twimap_read_kstats(struct twimap* map)
+{
+    ptr_t* pos = twimap_index(map, ptr_t*);
+
+    if (pos >= __lga_kstats_end) {
+        return;
+    }
+
+    ((kstat_fn)*pos)(map);
+}
+
+static void
+kstats_export()
+{
+    twimap_export_list(NULL, kstats, FSACL_ugR, NULL);
+}
+EXPORT_TWIFS_PLUGIN(kstats, kstats_export);
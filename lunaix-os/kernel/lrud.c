@@ -1,15 +1,39 @@
 #include <lunaix/ds/lru.h>
+#include <lunaix/ds/mutex.h>
 #include <lunaix/mm/valloc.h>
+#include <lunaix/owloysius.h>
 #include <lunaix/spike.h>
 #include <lunaix/fs/twimap.h>
 #include <lunaix/fs/twifs.h>
+#include <lunaix/workqueue.h>
+#include <lunaix/kstats.h>
 
 #include <klibc/string.h>
 
 static struct llist_header zone_lead = { .next = &zone_lead, .prev = &zone_lead };
 
+/*
+    Guards the zone list, nests outside of the zone lock. A sleeping
+    lock, as the reaper walks the list from a preemptible worker.
+ */
+static DEFINE_MUTEX(zone_lead_lock);
+
 DEFINE_SPINLOCK_OPS(struct lru_zone*, lock);
 
+// retry interval (in ms) for the zones that failed to be freed
+#define LRU_REAP_INTERVAL   1000
+
+static void
+__lru_reap_zones(struct work* work);
+
+static struct delayed_work lru_reaper;
+
+static void
+lru_init()
+{
+    delayed_work_init(&lru_reaper, __lru_reap_zones);
+}
+owloysius_fetch_init(lru_init, on_earlyboot);
 
 static void
 __do_evict_lockless(struct lru_zone* zone, struct llist_header* elem)
@@ -30,10 +54,12 @@ __do_evict_lockless(struct lru_zone* zone, struct llist_header* elem)
 static void
 __lru_evict_all_lockness(struct lru_zone* zone)
 {
-    struct llist_header* tail = zone->lead_node.prev;
+    struct llist_header *tail = zone->lead_node.prev, *prev;
     while (tail != &zone->lead_node) {
+        // tail is orphaned (or even gone) once evicted
+        prev = tail->prev;
         __do_evict_lockless(zone, tail);
-        tail = tail->prev;
+        tail = prev;
     }
 }
 
@@ -49,21 +75,26 @@ lru_new_zone(const char* name, evict_cb try_evict_cb)
 
     strncpy(zone->name, name, sizeof(zone->name) - 1);
     llist_init_head(&zone->lead_node);
-    llist_append(&zone_lead, &zone->zones);
     spinlock_init(&zone->lock);
 
+    mutex_lock(&zone_lead_lock);
+    llist_append(&zone_lead, &zone->zones);
+    mutex_unlock(&zone_lead_lock);
+
     return zone;
 }
 
 void
 lru_free_zone(struct lru_zone* zone)
 {
+    mutex_lock(&zone_lead_lock);
     lock(zone);
 
     __lru_evict_all_lockness(zone);
 
     if (llist_empty(&zone->lead_node)) {
         llist_delete(&zone->zones);
+        mutex_unlock(&zone_lead_lock);
         vfree(zone);
         return;
     }
@@ -78,6 +109,49 @@ lru_free_zone(struct lru_zone* zone)
     zone->attempts++;
 
     unlock(zone);
+    mutex_unlock(&zone_lead_lock);
+
+    if (system_wq) {
+        queue_delayed_work(system_wq, &lru_reaper, LRU_REAP_INTERVAL);
+    }
+}
+
+static void
+__lru_reap_zones(struct work* work)
+{
+    struct lru_zone *pos, *n;
+    bool again = false;
+
+    mutex_lock(&zone_lead_lock);
+
+    llist_for_each(pos, n, &zone_lead, zones)
+    {
+        if (!pos->delayed_free) {
+            continue;
+        }
+
+        lock(pos);
+
+        __lru_evict_all_lockness(pos);
+
+        if (llist_empty(&pos->lead_node)) {
+            llist_delete(&pos->zones);
+            vfree(pos);
+            continue;
+        }
+
+        pos->attempts++;
+        again = true;
+
+        unlock(pos);
+    }
+
+    mutex_unlock(&zone_lead_lock);
+
+    if (again) {
+        queue_delayed_work(system_wq, to_delayed_work(work), 
+                           LRU_REAP_INTERVAL);
+    }
 }
 
 void
@@ -107,6 +181,7 @@ lru_evict_one(struct lru_zone* zone)
 
     struct llist_header* tail = zone->lead_node.prev;
     if (tail == &zone->lead_node) {
+        unlock(zone);
         return;
     }
 
@@ -121,10 +196,11 @@ lru_evict_half(struct lru_zone* zone)
     lock(zone);
 
     int target = (int)(zone->objects / 2);
-    struct llist_header* tail = zone->lead_node.prev;
+    struct llist_header *tail = zone->lead_node.prev, *prev;
     while (tail != &zone->lead_node && target > 0) {
+        prev = tail->prev;
         __do_evict_lockless(zone, tail);
-        tail = tail->prev;
+        tail = prev;
         target--;
     }
 
@@ -208,4 +284,34 @@ lru_pool_twimappable()
 {
     twimap_export_list(NULL, lru_pool, FSACL_aR, NULL);
 }
-EXPORT_TWIFS_PLUGIN(__lru_twimap, lru_pool_twimappable);
\ No newline at end of file
+EXPORT_TWIFS_PLUGIN(__lru_twimap, lru_pool_twimappable);
+
+static void
+__kstat_lru(struct twimap* map)
+{
+    struct lru_zone *pos, *n;
+    struct kstat_lru_ent ent;
+    size_t rec;
+
+    rec = kstat_begin(map, KSTAT_LRU, sizeof(ent));
+
+    mutex_lock(&zone_lead_lock);
+
+    llist_for_each(pos, n, &zone_lead, zones) {
+        ent = (struct kstat_lru_ent) {
+            .objects = pos->objects,
+            .hotness = pos->hotness,
+            .n_single = pos->evict_stats.n_single,
+            .n_half = pos->evict_stats.n_half,
+            .n_full = pos->evict_stats.n_full
+        };
+
+        strncpy(ent.name, pos->name, KSTAT_NAME_LEN - 1);
+        kstat_put(map, &ent, sizeof(ent));
+    }
+
+    mutex_unlock(&zone_lead_lock);
+
+    kstat_end(map, rec);
+}
+EXPORT_KSTAT(lru, __kstat_lru);
\ No newline at end of file
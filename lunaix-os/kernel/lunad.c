@@ -10,6 +10,7 @@
 #include <lunaix/sched.h>
 #include <lunaix/kpreempt.h>
 #include <lunaix/kcmd.h>
+#include <lunaix/boottime.h>
 
 #include <klibc/string.h>
 
@@ -63,6 +64,8 @@ exec_initd()
 
     kcmd_get_option("init", (char**)&argv[0]);
 
+    boottime_finish();
+
     if ((errno = exec_kexecve(argv[0], argv, envp))) {
         goto fail;
     }
@@ -96,6 +99,7 @@ void
 lunad_main()
 {
     spawn_kthread((ptr_t)init_platform);
+    sched_start_cpus();
 
     /*
         NOTE Kernel preemption after this point.
@@ -119,10 +123,10 @@ lunad_main()
 void
 init_platform()
 {    
-    device_postboot_load();
+    boottime_step(device_postboot_load());
     invoke_init_function(on_postboot);
 
-    twifs_register_plugins();
+    boottime_step(twifs_register_plugins());
 
     if (!mount_bootmedium()) {
         ERROR("failed to boot");
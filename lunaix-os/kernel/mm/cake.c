@@ -16,9 +16,12 @@
 #include <lunaix/mm/page.h>
 #include <lunaix/spike.h>
 #include <lunaix/syslog.h>
+#include <lunaix/tracepoint.h>
 
 LOG_MODULE("CAKE")
 
+DEFINE_TRACEPOINT(cake_grab);
+
 #define CACHE_LINE_SIZE 128
 
 static struct cake_pile master_pile, fl_pile, cakes;
@@ -326,6 +329,8 @@ cake_grab(struct cake_pile* pile)
         pile->ctor(pile, piece);
     }
 
+    trace_event(cake_grab, pile, piece);
+
     return piece;
 }
 
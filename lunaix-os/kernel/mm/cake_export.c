@@ -1,5 +1,8 @@
 #include <lunaix/fs/twifs.h>
 #include <lunaix/mm/cake.h>
+#include <lunaix/kstats.h>
+
+#include <klibc/string.h>
 
 extern struct llist_header piles;
 
@@ -98,4 +101,30 @@ cake_export()
         cake_export_pile(cake_root, pos);
     }
 }
-EXPORT_TWIFS_PLUGIN(cake_alloc, cake_export);
\ No newline at end of file
+EXPORT_TWIFS_PLUGIN(cake_alloc, cake_export);
+
+static void
+__kstat_cake(struct twimap* map)
+{
+    struct cake_pile *pos, *n;
+    struct kstat_cake_ent ent;
+    size_t rec;
+
+    rec = kstat_begin(map, KSTAT_CAKE, sizeof(ent));
+
+    llist_for_each(pos, n, &piles, piles) {
+        ent = (struct kstat_cake_ent) {
+            .piece_size = pos->piece_size,
+            .cakes = pos->cakes_count,
+            .pages_per_cake = pos->pg_per_cake,
+            .pieces_per_cake = pos->pieces_per_cake,
+            .alloced = pos->alloced_pieces
+        };
+
+        strncpy(ent.name, pos->pile_name, KSTAT_NAME_LEN - 1);
+        kstat_put(map, &ent, sizeof(ent));
+    }
+
+    kstat_end(map, rec);
+}
+EXPORT_KSTAT(cake, __kstat_cake);
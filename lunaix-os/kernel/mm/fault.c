@@ -10,6 +10,7 @@
 #include <lunaix/trace.h>
 #include <lunaix/hart_state.h>
 #include <lunaix/failsafe.h>
+#include <lunaix/tracepoint.h>
 
 #include <asm/mm_defs.h>
 
@@ -17,6 +18,9 @@
 
 LOG_MODULE("pf")
 
+DEFINE_TRACEPOINT(page_fault);
+DEFINE_TRACEPOINT(page_fault_done);
+
 static void
 __prepare_fault_context(struct fault_context* fault)
 {
@@ -296,9 +300,12 @@ handle_page_fault(struct fault_context* fault)
 {
     __prepare_fault_context(fault);
 
+    trace_event(page_fault, fault->fault_va, fault->fault_instn);
+
     fault_prealloc_page(fault);
 
     if (!__try_resolve_fault(fault)) {
+        trace_event(page_fault_done, fault->fault_va, 0);
         return false;
     }
 
@@ -307,5 +314,7 @@ handle_page_fault(struct fault_context* fault)
     }
 
     __resolve_fault_ptes(fault);
+
+    trace_event(page_fault_done, fault->fault_va, 1);
     return true;
 }
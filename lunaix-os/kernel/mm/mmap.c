@@ -249,6 +249,7 @@ mem_remap(void** addr_out,
 
 struct mem_sync_state {
     struct mm_region* region;
+    struct tlb_gather* tlb;
     int options;
 };
 
@@ -284,7 +285,7 @@ __mem_flush_handler(struct vastm_state* state, pte_t* ptep, void* data)
     else if ((ms->options & MS_INVALIDATE)) 
     {
         next_pte = null_pte;
-        leaflet_return(pte_leaflet(pte));
+        tlb_gather_release(ms->tlb, pte_leaflet(pte));
         goto done;
     }
     
@@ -296,27 +297,28 @@ __mem_flush_handler(struct vastm_state* state, pte_t* ptep, void* data)
      */
     if (ms->options & MEM_FLUSH_UNMAP || ms->options & MS_INVALIDATE_ALL) {
         set_pte(ptep, null_pte);
-        leaflet_return(pte_leaflet(pte));
 
-        // No tlb flushing on small pages. It will be VERY expensive when 
-        // we are unmapping the whole regions, let the caller do bulk flushing.
-        if (pte_huge(pte))
-            tlb_flush_vmr(region, va);
+        // No immediate flushing nor releasing, as it will be VERY expensive
+        // when we are unmapping the whole regions. Let the gather settle
+        // them in bulk, the page must outlive the stale translation.
+        tlb_gather_page(ms->tlb, va);
+        tlb_gather_release(ms->tlb, pte_leaflet(pte));
 
         return VASTM_CONTINUE;
     }
 
 done:
-    if (pte_val(pte) == pte_val(next_pte)) {
+    if (pte_val(pte) != pte_val(next_pte)) {
         set_pte(ptep, next_pte);
-        tlb_flush_vmr(region, va);
+        tlb_gather_page(ms->tlb, va);
     }
 
     return VASTM_CONTINUE;
 }
 
-void
-mem_flush_pages(struct mm_region* region, ptr_t start, ptr_t end, int options)
+static void
+__mem_flush_pages(struct tlb_gather* tlb, struct mm_region* region, 
+                  ptr_t start, ptr_t end, int options)
 {
     struct mem_sync_state ms;
     struct vastm param;
@@ -327,15 +329,23 @@ mem_flush_pages(struct mm_region* region, ptr_t start, ptr_t end, int options)
 
     ms.region = region;
     ms.options = options;
+    ms.tlb = tlb;
     
     vastm_param_prepare(&param, &ms);
     vastm_param_cb_set(&param, ASTM_LFT, __mem_flush_handler);
     
     vastm_walk(&param, vastm_procvm_root(region->proc_vms), 
                 start, end, RES_LFT);
+}
 
-    if (options & (MEM_FLUSH_UNMAP | MS_INVALIDATE_ALL))
-        tlb_flush_range(start, (end - start) / PAGE_SIZE);
+void
+mem_flush_pages(struct mm_region* region, ptr_t start, ptr_t end, int options)
+{
+    struct tlb_gather tlb;
+
+    tlb_gather_init(&tlb, region->proc_vms);
+    __mem_flush_pages(&tlb, region, start, end, options);
+    tlb_gather_finish(&tlb);
 }
 
 int
@@ -399,7 +409,8 @@ mem_unmap_region(struct mm_region* region)
     ((vmr)->start > (addr) && ((addr) + (len)) > (vmr)->end)
 
 static void
-__unmap_overlapped_cases(struct mm_region* vmr, ptr_t* addr, size_t* length)
+__unmap_overlapped_cases(struct tlb_gather* tlb, 
+                         struct mm_region* vmr, ptr_t* addr, size_t* length)
 {
     // seg start, umapped segement start
     ptr_t seg_start = *addr, umps_start = 0;
@@ -443,7 +454,8 @@ __unmap_overlapped_cases(struct mm_region* vmr, ptr_t* addr, size_t* length)
         umps_start = vmr->start;
     }
 
-    mem_flush_pages(vmr, vmr->start, vmr->start + umps_len, MEM_FLUSH_UNMAP);
+    __mem_flush_pages(tlb, vmr, 
+                      vmr->start, vmr->start + umps_len, MEM_FLUSH_UNMAP);
 
     vmr->start += displ;
     vmr->end -= shrink;
@@ -467,6 +479,7 @@ mem_unmap(vm_regions_t* regions, ptr_t addr, size_t length)
     length = ROUNDUP(length, PAGE_SIZE);
     ptr_t cur_addr = page_frame(addr);
     struct mm_region *pos, *n;
+    struct tlb_gather tlb;
 
     llist_for_each(pos, n, regions, head)
     {
@@ -476,6 +489,12 @@ mem_unmap(vm_regions_t* regions, ptr_t addr, size_t length)
         }
     }
 
+    if (&pos->head == regions) {
+        return 0;
+    }
+
+    tlb_gather_init(&tlb, pos->proc_vms);
+
     size_t remaining = length;
     while (&pos->head != regions && remaining) {
         n = container_of(pos->head.next, typeof(*pos), head);
@@ -483,11 +502,13 @@ mem_unmap(vm_regions_t* regions, ptr_t addr, size_t length)
             break;
         }
 
-        __unmap_overlapped_cases(pos, &cur_addr, &remaining);
+        __unmap_overlapped_cases(&tlb, pos, &cur_addr, &remaining);
 
         pos = n;
     }
 
+    tlb_gather_finish(&tlb);
+
     return 0;
 }
 
@@ -6,6 +6,7 @@
 #include <lunaix/syslog.h>
 #include <lunaix/mm/page.h>
 #include <lunaix/compiler.h>
+#include <lunaix/kstats.h>
 
 LOG_MODULE("pmm")
 
@@ -117,6 +118,7 @@ pmm_free_one(struct ppage* page)
     }
 
     pool = memory.pool[page->pool];
+    pool->nr_used -= 1 << page->order;
     pool->ops.free_page(pool, page);
 }
 
@@ -225,3 +227,36 @@ pmm_log_summary()
     }
 }
 owloysius_fetch_init(pmm_log_summary, on_sysconf);
+
+static void
+__kstat_pmm(struct twimap* map)
+{
+    struct kstat_pmm_ent ent;
+    struct pmpool* _pool;
+    size_t rec;
+
+    rec = kstat_begin(map, KSTAT_PMM, sizeof(ent));
+
+    for (int i = 0; i < POOL_COUNT; i++)
+    {
+        _pool = memory.pool[i];
+        
+        // aliased pool is reported only once.
+        if (!_pool || _pool->type != i) {
+            continue;
+        }
+
+        ent = (struct kstat_pmm_ent) {
+            .pool = i,
+            .type = _pool->type,
+            .total_pages = ppfn(_pool->last) - ppfn(_pool->first) + 1,
+            .used_pages = _pool->nr_used,
+            .nr_fails = _pool->nr_fails
+        };
+
+        kstat_put(map, &ent, sizeof(ent));
+    }
+
+    kstat_end(map, rec);
+}
+EXPORT_KSTAT(pmm, __kstat_pmm);
@@ -247,18 +247,25 @@ vmscpy(struct proc_mm* dest_mm, struct proc_mm* src_mm)
     
     src = (pte_t*)phy_to_virt(src_mm->vmroot);
 
+    struct tlb_gather tlb;
     struct mm_region *pos, *n;
+
+    tlb_gather_init(&tlb, src_mm);
     llist_for_each(pos, n, &src_mm->regions, head)
     {
         state.vmr = pos;
         __copy_va_subspace(&state, dest, src, pos->start, pos->end);
 
-        if (state.err)
+        if (state.err) {
+            tlb_gather_finish(&tlb);
             return state.err;
+        }
 
-        tlb_flush_vmr_all(pos);
+        tlb_gather_range(&tlb, pos->start, count_pages(pos->end - pos->start));
     }
 
+    tlb_gather_finish(&tlb);
+
 done:;
     procvm_link_kernel(dest, src);
     dest_mm->vmroot = virt_to_phy((ptr_t)dest);
@@ -270,24 +277,32 @@ static enum vastm_action
 __free_mappings(struct vastm_state* state, pte_t* ptep, void* data)
 {
     pte_t pte;
+    struct tlb_gather* tlb;
 
     pte = pte_at(ptep);
     if (!pte_isloaded(pte))
         return VASTM_CONTINUE;
     
+    tlb = (struct tlb_gather*)data;
+
+    // both the leaf pages and the page tables are held by the gather 
+    // until the translations (and their cached walks) are invalidated
     vastm_visit_next(*state, ptep_next_table(ptep));
-    leaflet_return(pte_leaflet(pte));
+    tlb_gather_release(tlb, pte_leaflet(pte));
     set_pte(ptep, null_pte);
 
     return VASTM_CONTINUE;
 }
 
 static inline void 
-vmrfree(struct proc_mm* mm, struct mm_region* region)
+vmrfree(struct tlb_gather* tlb, struct proc_mm* mm, struct mm_region* region)
 {
     struct vastm param;
 
-    vastm_param_prepare(&param, NULL);
+    tlb_gather_range(tlb, region->start, 
+                     count_pages(region->end - region->start));
+
+    vastm_param_prepare(&param, tlb);
     vastm_param_cb_set_uniform(&param, __free_mappings);
 
     vastm_walk(&param, vastm_procvm_root(mm), 
@@ -297,12 +312,15 @@ vmrfree(struct proc_mm* mm, struct mm_region* region)
 static void
 vmsfree(struct proc_mm* mm)
 {
+    struct tlb_gather tlb;
     struct mm_region *pos, *n;
 
+    tlb_gather_init(&tlb, mm);
     llist_for_each(pos, n, &mm->regions, head)
     {
-        vmrfree(mm, pos);
+        vmrfree(&tlb, mm, pos);
     }
+    tlb_gather_finish(&tlb);
 
     procvm_unlink_kernel();
     leaflet_return(leaflet_from_va(phy_to_virt(mm->vmroot)));
@@ -104,7 +104,7 @@ vunmap_at(ptr_t vmap_addr, int n)
     if (!ptep)
         return;
 
-    while (n--)
+    for (int i = 0; i < n; i++)
         set_pte(ptep++, null_pte);
 
     tlb_flush_kernel_ranged(vmap_addr, n);
@@ -132,6 +132,7 @@ done:
 pid_t
 dup_proc()
 {
+    int errno;
     struct thread* main_thread;
     struct proc_info* pcb;
     
@@ -146,10 +147,17 @@ dup_proc()
     pcb->parent = __current;
 
     // FIXME need a more elagent refactoring
-    if (__current->cmd) {
-        pcb->cmd_len = __current->cmd_len;
+    if (__current->cmd && __current->cmd_len) {
+        pcb->cmd_len = MIN(__current->cmd_len, PROC_CMD_MAXLEN);
         pcb->cmd = valloc(pcb->cmd_len);
-        memcpy(pcb->cmd, __current->cmd, pcb->cmd_len);
+
+        if (pcb->cmd) {
+            memcpy(pcb->cmd, __current->cmd, pcb->cmd_len);
+            pcb->cmd[pcb->cmd_len - 1] = '\0';
+        }
+        else {
+            pcb->cmd_len = 0;
+        }
     }
 
     if (__current->cwd) {
@@ -157,7 +165,12 @@ dup_proc()
         vfs_ref_dnode(pcb->cwd);
     }
 
-    fdtable_copy(pcb->fdtable, __current->fdtable);
+    if ((errno = fdtable_copy(pcb->fdtable, __current->fdtable))) {
+        syscall_result(errno);
+        delete_process(pcb);
+        return -1;
+    }
+
     uscope_copy(&pcb->uscope, current_user_scope());
 
     procvm_dupvms(vmspace(pcb));
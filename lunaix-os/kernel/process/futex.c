@@ -0,0 +1,267 @@
+/**
+ * @file futex.c
+ * @brief Fast user-space mutex, the kernel half.
+ *
+ * User space does the uncontended locking with atomic instructions on
+ * a plain word, and only enters the kernel to sleep on (FUTEX_WAIT)
+ * or wake (FUTEX_WAKE) the word when contended.
+ *
+ * A word is identified by the physical address behind it, so that
+ * processes sharing the page also share the futex. Waiters hang their
+ * own thread waitqueue onto the hashed bucket, tagged with the key.
+ * Waking a waiter is thus just detaching it from the bucket, and a
+ * dying or signaled waiter detach itself in the same way.
+ */
+
+#include <lunaix/process.h>
+#include <lunaix/sched.h>
+#include <lunaix/syscall.h>
+#include <lunaix/syscall_utils.h>
+#include <lunaix/kpreempt.h>
+#include <lunaix/owloysius.h>
+#include <lunaix/ds/spinlock.h>
+#include <lunaix/mm/vastm.h>
+
+#include <usr/lunaix/futex.h>
+
+#include <klibc/hash.h>
+
+#include <asm/mm_defs.h>
+
+#include <stdatomic.h>
+
+#define FUTEX_HASH_BITS     6
+#define FUTEX_HASH_SIZE     (1 << FUTEX_HASH_BITS)
+
+struct futex_bucket
+{
+    spinlock_t lock;
+    waitq_t waiters;
+};
+
+static struct futex_bucket futex_table[FUTEX_HASH_SIZE];
+
+static inline struct futex_bucket*
+__futex_bucket(ptr_t key)
+{
+    return &futex_table[hash_32((u32_t)(key >> 2), FUTEX_HASH_BITS)];
+}
+
+static inline struct thread*
+__futex_waiter(struct llist_header* pos)
+{
+    return container_of(pos, struct thread, waitqueue.waiters);
+}
+
+static int
+__futex_key(u32_t* uaddr, ptr_t* key)
+{
+    ptr_t va = (ptr_t)uaddr;
+    pte_t* ptep;
+    struct proc_mm* mm;
+
+    if (kernel_addr(va) || (va & (sizeof(u32_t) - 1))) {
+        return EINVAL;
+    }
+
+    /*
+        Fault it in for write. A copy-on-write page is otherwise shared
+        with the forked sibling until the first store, and the waker
+        doing that store would land on the copy, under another key.
+     */
+    atomic_fetch_add((atomic_uint*)uaddr, 0);
+
+    mm = vmspace(__current);
+    ptep = vastm_walk_ptep_strict(vastm_procvm_root(mm), va, RES_LFT);
+    if (!ptep || !pte_isloaded(pte_at(ptep))) {
+        return EINVAL;
+    }
+
+    *key = pte_paddr(pte_at(ptep)) + page_offset(va);
+    return 0;
+}
+
+static inline void
+__lock_buckets(struct futex_bucket* b1, struct futex_bucket* b2)
+{
+    if (b1 > b2) {
+        struct futex_bucket* tmp = b1;
+        b1 = b2;
+        b2 = tmp;
+    }
+
+    spinlock_acquire(&b1->lock);
+    if (b1 != b2) {
+        spinlock_acquire(&b2->lock);
+    }
+}
+
+static inline void
+__unlock_buckets(struct futex_bucket* b1, struct futex_bucket* b2)
+{
+    spinlock_release(&b1->lock);
+    if (b1 != b2) {
+        spinlock_release(&b2->lock);
+    }
+}
+
+static int
+__futex_wait(u32_t* uaddr, u32_t val)
+{
+    struct futex_bucket* fb;
+    ptr_t key;
+    int errno;
+
+    if ((errno = __futex_key(uaddr, &key))) {
+        return errno;
+    }
+
+    fb = __futex_bucket(key);
+
+    no_preemption();
+    spinlock_acquire(&fb->lock);
+
+    /*
+        Check and enqueue under the bucket lock, a waker must take the
+        same lock after it changed the word, so it either sees us
+        queued or we see the new value.
+     */
+    if (*(volatile u32_t*)uaddr != val) {
+        spinlock_release(&fb->lock);
+        set_preemption();
+        return EAGAIN;
+    }
+
+    current_thread->futex_key = key;
+    prepare_to_wait(&fb->waiters);
+
+    spinlock_release(&fb->lock);
+
+    try_wait();
+    set_preemption();
+
+    return 0;
+}
+
+static int
+__futex_wake_locked(struct futex_bucket* fb, ptr_t key,
+                    struct futex_bucket* target, ptr_t new_key,
+                    u32_t nr_wake, u32_t nr_requeue)
+{
+    struct llist_header *pos, *n;
+    struct thread* th;
+    int woken = 0;
+
+    pos = fb->waiters.waiters.next;
+    while (pos != &fb->waiters.waiters)
+    {
+        n  = pos->next;
+        th = __futex_waiter(pos);
+
+        if (th->futex_key != key) {
+            goto next;
+        }
+
+        if (nr_wake) {
+            llist_delete(pos);
+            woken++;
+            nr_wake--;
+        }
+        else if (nr_requeue && target) {
+            th->futex_key = new_key;
+            if (target != fb) {
+                llist_delete(pos);
+                llist_append(&target->waiters.waiters, pos);
+            }
+            nr_requeue--;
+        }
+        else {
+            break;
+        }
+
+    next:
+        pos = n;
+    }
+
+    return woken;
+}
+
+static int
+__futex_wake(u32_t* uaddr, u32_t nr_wake)
+{
+    struct futex_bucket* fb;
+    ptr_t key;
+    int errno;
+
+    if ((errno = __futex_key(uaddr, &key))) {
+        return errno;
+    }
+
+    fb = __futex_bucket(key);
+
+    no_preemption();
+    spinlock_acquire(&fb->lock);
+
+    errno = __futex_wake_locked(fb, key, NULL, 0, nr_wake, 0);
+
+    spinlock_release(&fb->lock);
+    set_preemption();
+
+    return errno;
+}
+
+static int
+__futex_requeue(u32_t* uaddr, u32_t nr_wake,
+                u32_t* uaddr2, u32_t nr_requeue)
+{
+    struct futex_bucket *fb, *fb2;
+    ptr_t key, key2;
+    int errno;
+
+    if ((errno = __futex_key(uaddr, &key))) {
+        return errno;
+    }
+
+    if ((errno = __futex_key(uaddr2, &key2))) {
+        return errno;
+    }
+
+    fb  = __futex_bucket(key);
+    fb2 = __futex_bucket(key2);
+
+    no_preemption();
+    __lock_buckets(fb, fb2);
+
+    errno = __futex_wake_locked(fb, key, fb2, key2, nr_wake, nr_requeue);
+
+    __unlock_buckets(fb, fb2);
+    set_preemption();
+
+    return errno;
+}
+
+static void
+futex_init()
+{
+    for (int i = 0; i < FUTEX_HASH_SIZE; i++) {
+        spinlock_init(&futex_table[i].lock);
+        waitq_init(&futex_table[i].waiters);
+    }
+}
+owloysius_fetch_init(futex_init, on_earlyboot);
+
+__DEFINE_LXSYSCALL5(int, futex, u32_t*, uaddr, int, op, u32_t, val,
+                    u32_t, val2, u32_t*, uaddr2)
+{
+    switch (op)
+    {
+    case FUTEX_WAIT:
+        return __futex_wait(uaddr, val);
+    case FUTEX_WAKE:
+        return __futex_wake(uaddr, val);
+    case FUTEX_REQUEUE:
+        return __futex_requeue(uaddr, val, uaddr2, val2);
+    }
+
+    return EINVAL;
+}
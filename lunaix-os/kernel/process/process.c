@@ -12,6 +12,8 @@
 #include <lunaix/exec.h>
 #include <lunaix/fs.h>
 
+#include <usr/lunaix/resource.h>
+
 #include <asm/abi.h>
 #include <asm/mm_defs.h>
 
@@ -245,3 +247,33 @@ __DEFINE_LXSYSCALL2(int, getgroups, gid_t*, out_buf, unsigned int, len)
     
     return i + 1;
 }
+
+__DEFINE_LXSYSCALL2(int, getrlimit, int, resource, struct rlimit*, rlim)
+{
+    if (resource != RLIMIT_NOFILE) {
+        return EINVAL;
+    }
+
+    rlim->rlim_cur = __current->fdtable->limit;
+    rlim->rlim_max = VFS_MAX_FD;
+
+    return 0;
+}
+
+__DEFINE_LXSYSCALL2(int, setrlimit, int, resource, const struct rlimit*, rlim)
+{
+    if (resource != RLIMIT_NOFILE) {
+        return EINVAL;
+    }
+
+    if (rlim->rlim_cur > rlim->rlim_max) {
+        return EINVAL;
+    }
+
+    // hard limit is fixed by the size of fd table
+    if (rlim->rlim_max > VFS_MAX_FD) {
+        return EPERM;
+    }
+
+    return fdtable_setlimit(__current->fdtable, rlim->rlim_cur);
+}
@@ -4,6 +4,7 @@
 #include <asm/mempart.h>
 
 #include <asm/cpu.h>
+#include <asm/tlb.h>
 
 #include <lunaix/fs/taskfs.h>
 #include <lunaix/mm/cake.h>
@@ -18,9 +19,13 @@
 #include <lunaix/spike.h>
 #include <lunaix/status.h>
 #include <lunaix/syscall.h>
+#include <lunaix/syscallstat.h>
 #include <lunaix/syslog.h>
 #include <lunaix/hart_state.h>
 #include <lunaix/kpreempt.h>
+#include <lunaix/ds/spinlock.h>
+
+#include <hal/irq.h>
 
 #include <klibc/string.h>
 
@@ -32,8 +37,24 @@ enum sched_check {
 
 struct thread empty_thread_obj;
 
-volatile struct proc_info* __current = NULL;
-volatile struct thread* current_thread = &empty_thread_obj;
+struct cpu_local cpu_locals[CONFIG_NR_CPUS] = {
+    [0] = { 
+        .self   = &cpu_locals[0],
+        .thread = &empty_thread_obj,
+        .online = true,
+        .klocked = true
+    }
+};
+unsigned int nr_cpus = 1;
+
+/*
+    The kernel is not yet designed for true concurrency, processors
+    are serialized by one big kernel lock instead. It is held for as
+    long as a processor runs kernel code, and dropped on the way back
+    to user space or to the idle thread. Boot processor owns it from
+    the very beginning.
+ */
+static spinlock_t kernel_lock_obj = { .owner = 0, .next = 1 };
 
 struct scheduler sched_ctx;
 
@@ -57,6 +78,165 @@ sched_init()
     llist_init_head(&sched_ctx.sleepers);
 }
 
+/**
+ * @brief Prepare the scheduling states of an application processor
+ * that is about to come online. The boot processor is statically
+ * initialized. Idle threads are handed out later by sched_start_cpus.
+ */
+void
+sched_init_cpu(struct cpu_local* cpu)
+{
+    assert(cpu->id);
+
+    cpu->self = cpu;
+    cpu->runq = NULL;
+    cpu->proc = NULL;
+    cpu->idle = NULL;
+    cpu->nr_threads = 0;
+    cpu->klocked = false;
+    cpu->thread = &empty_thread_obj;
+}
+
+static void
+__idle_main()
+{
+    set_preemption();
+    while (1) {
+        cpu_wait();
+    }
+}
+
+/**
+ * @brief Give every application processor an idle thread, so they
+ * can start pulling threads from their run queues. Must be called
+ * from lunad, which then becomes the idle thread of boot processor.
+ */
+void
+sched_start_cpus()
+{
+    struct cpu_local* cpu;
+    struct thread* th;
+
+    assert(kernel_process(__current));
+
+    for_each_cpu(cpu) {
+        if (!cpu->id) {
+            continue;
+        }
+
+        th = create_thread(__current, false);
+        assert(th);
+
+        th->cpu = cpu;
+        start_thread(th, (ptr_t)__idle_main);
+
+        cpu->idle = th;
+    }
+
+    this_cpu()->idle = current_thread;
+}
+
+void
+kernel_lock()
+{
+    struct cpu_local* cpu = this_cpu();
+
+    if (cpu->klocked) {
+        return;
+    }
+
+    spinlock_acquire(&kernel_lock_obj);
+    cpu->klocked = true;
+
+    tlb_sync_kernel(cpu);
+}
+
+void
+kernel_unlock()
+{
+    struct cpu_local* cpu = this_cpu();
+
+    if (!cpu->klocked) {
+        return;
+    }
+
+    cpu->klocked = false;
+    spinlock_release(&kernel_lock_obj);
+}
+
+/**
+ * @brief Called on the way out of an interrupt, with the context
+ * to be resumed. Only the bottom of idle thread, or user space, 
+ * is considered as outside of kernel.
+ */
+void
+kernel_lock_leave(struct hart_state* state)
+{
+    if (kernel_context(state)) {
+        if (state->depth || current_thread != this_cpu()->idle) {
+            return;
+        }
+    }
+
+    kernel_unlock();
+}
+
+void
+sched_preempt_point()
+{
+    struct cpu_local* cpu = this_cpu();
+
+    // tasklets are not preemptible, try again on the next tick
+    if (!cpu->slice_over || irq_in_deferred()) {
+        return;
+    }
+
+    cpu->slice_over = false;
+
+    thread_stats_update_entering(false);
+    schedule();
+}
+
+static struct cpu_local*
+__pick_cpu(struct thread* thread)
+{
+    struct cpu_local *cpu, *picked = NULL;
+
+    if (thread->cpu) {
+        return thread->cpu;
+    }
+
+    if (thread->process->cpu) {
+        return thread->process->cpu;
+    }
+
+    for_each_cpu(cpu) {
+        if (!cpu->runq) {
+            continue;
+        }
+
+        if (!picked || cpu->nr_threads < picked->nr_threads) {
+            picked = cpu;
+        }
+    }
+
+    return picked ?: this_cpu();
+}
+
+static inline bool
+__proc_on_cpu(struct proc_info* proc)
+{
+    struct cpu_local* cpu;
+
+    for_each_cpu(cpu) {
+        if (cpu->proc == proc) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void
 run(struct thread* thread)
 {
@@ -64,6 +244,7 @@ run(struct thread* thread)
     thread->process->state = PS_RUNNING;
     thread->process->th_active = thread;
 
+    sched_stat_switch(current_thread, thread);
     set_current_executing(thread);
 
     switch_context();
@@ -81,24 +262,38 @@ run(struct thread* thread)
 void
 cleanup_detached_threads() 
 {
-    // XXX may be a lock on sched_context will ben the most appropriate?
+    // called from idle thread, which runs without the kernel lock
     cpu_disable_interrupt();
+    kernel_lock();
 
     int i = 0;
+    struct cpu_local* cpu;
     struct thread *pos, *n;
-    llist_for_each(pos, n, sched_ctx.threads, sched_sibs) {
-        if (likely(!proc_terminated(pos) || !thread_detached(pos))) {
+    for_each_cpu(cpu) {
+        if (!cpu->runq) {
             continue;
         }
 
-        destory_thread(pos);
-        i++;
+        llist_for_each(pos, n, cpu->runq, sched_sibs) {
+            if (likely(!proc_terminated(pos) || !thread_detached(pos))) {
+                continue;
+            }
+
+            // still on its way out of the other processor
+            if (pos == cpu->thread) {
+                continue;
+            }
+
+            destory_thread(pos);
+            i++;
+        }
     }
 
     if (i) {
         INFO("cleaned %d terminated detached thread(s)", i);
     }
 
+    kernel_unlock();
     cpu_enable_interrupt();
 }
 
@@ -132,12 +327,14 @@ __try_handle_onwait(struct thread* thread)
         return SCHED_CHECK_NEXT;
 
     if (waitq_empty(&thread->waitqueue)) {
+        sched_stat_woken(thread);
         resume_thread(thread);
         return SCHED_PROCCED;
     }
 
     struct sigctx* sh = &thread->sigctx;
     if (sigset_test(sh->sig_pending, _SIGINT)) {
+        sched_stat_woken(thread);
         waitq_cancel_wait(&thread->waitqueue);
         return SCHED_PROCCED;
     }
@@ -229,6 +426,7 @@ check_sleepers()
         if (wtime && now >= wtime) {
             pos->sleep.wakeup_time = 0;
             pos->state = PS_READY;
+            sched_stat_woken(pos);
         }
 
         if (atime && now >= atime) {
@@ -387,7 +585,9 @@ repeat:
     llist_for_each(proc, n, &__current->children, siblings)
     {
         if (!~wpid || proc->pid == wpid || proc->pgid == -wpid) {
-            if (proc->state == PS_TERMNAT && !options) {
+            if (proc->state == PS_TERMNAT && !options 
+                    && !__proc_on_cpu(proc)) 
+            {
                 status_flags |= PEXITTERM;
                 goto done;
             }
@@ -472,7 +672,7 @@ alloc_process()
     proc->root = vfs_sysroot;
 
     proc->sigreg = vzalloc(sizeof(struct sigregistry));
-    proc->fdtable = vzalloc(sizeof(struct v_fdtable));
+    proc->fdtable = fdtable_create();
 
     proc->mm = procvm_create(proc);
     
@@ -483,6 +683,8 @@ alloc_process()
 
     iopoll_init(&proc->pollctx);
 
+    syscall_stat_attach(proc);
+
     sched_ctx.procs[i] = proc;
 
     return proc;
@@ -491,20 +693,30 @@ alloc_process()
 void
 commit_thread(struct thread* thread) {
     struct proc_info* process = thread->process;
+    struct cpu_local* cpu;
 
     assert(process && !proc_terminated(process));
 
+    cpu = __pick_cpu(thread);
+    thread->cpu = cpu;
+    if (!process->cpu) {
+        process->cpu = cpu;
+    }
+
     llist_append(&process->threads, &thread->proc_sibs);
     
-    if (sched_ctx.threads) {
-        llist_append(sched_ctx.threads, &thread->sched_sibs);
+    if (cpu->runq) {
+        llist_append(cpu->runq, &thread->sched_sibs);
     } else {
-        sched_ctx.threads = &thread->sched_sibs;
+        cpu->runq = &thread->sched_sibs;
     }
 
+    cpu->nr_threads++;
+
     sched_ctx.ttable_len++;
     process->thread_count++;
     thread->state = PS_READY;
+    sched_stat_woken(thread);
 }
 
 void
@@ -544,6 +756,10 @@ destory_thread(struct thread* thread)
 
     llist_delete(&thread->sched_sibs);
     llist_delete(&thread->proc_sibs);
+    if (thread->cpu) {
+        thread->cpu->nr_threads--;
+    }
+
     llist_delete(&thread->sleep.sleepers);
     waitq_cancel_wait(&thread->waitqueue);
 
@@ -584,6 +800,7 @@ delete_process(struct proc_info* proc)
     llist_delete(&proc->tasks);
 
     iopoll_free(proc);
+    syscall_stat_detach(proc);
 
     taskfs_invalidate(pid);
 
@@ -595,7 +812,7 @@ delete_process(struct proc_info* proc)
         vfree(proc->cmd);
     }
 
-    for (size_t i = 0; i < VFS_MAX_FD; i++) {
+    for (size_t i = 0; i < proc->fdtable->size; i++) {
         struct v_fd* fd = proc->fdtable->fds[i];
         if (fd) {
             vfs_pclose(fd->file, pid);
@@ -603,7 +820,7 @@ delete_process(struct proc_info* proc)
         }
     }
 
-    vfree(proc->fdtable);
+    fdtable_free(proc->fdtable);
 
     signal_free_registry(proc->sigreg);
 
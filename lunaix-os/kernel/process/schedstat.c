@@ -0,0 +1,275 @@
+/**
+ * @file schedstat.c
+ * @brief Scheduler accounting and the sched_switch trace.
+ *
+ * A thread is stamped when it becomes runnable (preempted, woken up
+ * from waitqueue or sleep, or just born), and the latency is charged
+ * when it finally got the cpu. Latency is measured in TSC cycles,
+ * the cpu and wait time in millisecond, as of clock_systime().
+ *
+ * Everything here is updated with interrupt off, either from the
+ * scheduler or from the waitqueue.
+ *
+ * Exported to twifs:
+ *      /sched/stats    system-wide switch counters
+ *      /sched/latency  system-wide latency histogram
+ *      /sched/trace    the most recent context switches
+ *
+ * and the counters to /kstats as well.
+ */
+
+#include <lunaix/sched.h>
+#include <lunaix/clock.h>
+#include <lunaix/spike.h>
+#include <lunaix/fs/twifs.h>
+#include <lunaix/fs/twimap.h>
+#include <lunaix/kstats.h>
+
+#include <asm/cpu.h>
+#include <asm/muldiv64.h>
+
+#define SCHED_TRACE_SIZE    256
+
+struct sched_switch_rec
+{
+    time_t time;
+    pid_t prev_pid;
+    tid_t prev_tid;
+    pid_t next_pid;
+    tid_t next_tid;
+    unsigned int next_lat;      // in thousands of cycles
+    int prev_state;
+};
+
+static struct {
+    unsigned long nr_switch;
+    unsigned long nr_vol;
+    unsigned long nr_invol;
+    unsigned int lat_hist[SCHED_LAT_BUCKETS];
+} sched_stats;
+
+static struct sched_switch_rec trace_ring[SCHED_TRACE_SIZE];
+static unsigned int trace_seq = 0;
+
+static inline int
+__lat_bucket(u64_t lat)
+{
+    int order;
+
+    if (lat < (1ULL << SCHED_LAT_SHIFT)) {
+        return 0;
+    }
+
+    order = (int)ilog2((unsigned long)MIN(lat, 0xffffffffULL));
+    return MIN(order - SCHED_LAT_SHIFT + 1, SCHED_LAT_BUCKETS - 1);
+}
+
+static inline struct sched_switch_rec*
+__trace_slot(unsigned int seq)
+{
+    return &trace_ring[seq % SCHED_TRACE_SIZE];
+}
+
+void
+sched_stat_woken(struct thread* thread)
+{
+    struct thread_stats* stats;
+    time_t now, woke;
+    u64_t ready;
+
+    stats = &thread->stats;
+    now   = clock_systime();
+    woke  = now;
+    ready = cpu_cycles();
+
+    if (thread->state == PS_ONWAIT) {
+        // the wake up might have happened long before we noticed.
+        if (stats->woken_at >= stats->wait_since) {
+            woke  = stats->woken_at;
+            ready = stats->woken_cycles;
+        }
+
+        stats->wait_time += woke - stats->wait_since;
+    }
+
+    stats->ready_since = ready;
+}
+
+void
+sched_stat_switch(struct thread* prev, struct thread* next)
+{
+    struct sched_switch_rec* rec;
+    u64_t cycles, lat = 0;
+    time_t now;
+    int bucket;
+
+    now = clock_systime();
+    cycles = cpu_cycles();
+
+    if (prev) {
+        prev->stats.cpu_time += now - prev->stats.run_since;
+    }
+
+    if (prev == next) {
+        next->stats.ready_since = 0;
+        next->stats.run_since = now;
+        return;
+    }
+
+    if (prev) {
+        if (prev->state == PS_READY) {
+            prev->stats.nr_invol_switch++;
+            prev->stats.ready_since = cycles;
+            sched_stats.nr_invol++;
+        }
+        else {
+            prev->stats.nr_vol_switch++;
+            sched_stats.nr_vol++;
+        }
+    }
+
+    if (next->stats.ready_since) {
+        lat = cycles - next->stats.ready_since;
+        bucket = __lat_bucket(lat);
+
+        next->stats.lat_hist[bucket]++;
+        sched_stats.lat_hist[bucket]++;
+        next->stats.ready_since = 0;
+    }
+
+    next->stats.run_since = now;
+    sched_stats.nr_switch++;
+
+    rec = __trace_slot(trace_seq++);
+    *rec = (struct sched_switch_rec) {
+        .time = now,
+        .prev_pid = prev ? prev->process->pid : -1,
+        .prev_tid = prev ? prev->tid : -1,
+        .prev_state = prev ? prev->state : PS_TERMNAT,
+        .next_pid = next->process->pid,
+        .next_tid = next->tid,
+        .next_lat = (unsigned int)udiv64(lat, 1000)
+    };
+}
+
+/*
+    twifs exports
+ */
+
+static const char*
+__state_name(int state)
+{
+    switch (state)
+    {
+    case PS_READY:      return "R";
+    case PS_RUNNING:    return "R+";
+    case PS_TERMNAT:    return "X";
+    case PS_PAUSED:     return "P";
+    case PS_ONWAIT:     return "W";
+    case PS_STOPPED:    return "T";
+    case PS_CREATED:    return "N";
+    }
+
+    return "?";
+}
+
+static void
+__twimap_read_stats(struct twimap* map)
+{
+    twimap_printf(map, "switches: %u\nvoluntary: %u\ninvoluntary: %u\n",
+                  sched_stats.nr_switch,
+                  sched_stats.nr_vol,
+                  sched_stats.nr_invol);
+}
+
+static void
+__twimap_read_latency(struct twimap* map)
+{
+    twimap_printf(map, "<%u: %u\n", 1U << SCHED_LAT_SHIFT, 
+                  sched_stats.lat_hist[0]);
+
+    for (int i = 1; i < SCHED_LAT_BUCKETS; i++) {
+        twimap_printf(map, "%s%u: %u\n", 
+                      i == SCHED_LAT_BUCKETS - 1 ? ">=" : "",
+                      1U << (i + SCHED_LAT_SHIFT - 1), 
+                      sched_stats.lat_hist[i]);
+    }
+}
+
+static void
+__twimap_reset_trace(struct twimap* map)
+{
+    unsigned int oldest;
+
+    oldest = trace_seq > SCHED_TRACE_SIZE ? trace_seq - SCHED_TRACE_SIZE : 0;
+    map->index = (void*)(ptr_t)oldest;
+
+    twimap_printf(map, "time prev state next lat_kcycles\n");
+}
+
+static int
+__twimap_gonext_trace(struct twimap* map)
+{
+    unsigned int seq = (unsigned int)(ptr_t)map->index;
+
+    if (seq + 1 >= trace_seq) {
+        return 0;
+    }
+
+    map->index = (void*)(ptr_t)(seq + 1);
+    return 1;
+}
+
+static void
+__twimap_read_trace(struct twimap* map)
+{
+    unsigned int seq = (unsigned int)(ptr_t)map->index;
+    struct sched_switch_rec* rec;
+
+    if (seq >= trace_seq) {
+        return;
+    }
+
+    rec = __trace_slot(seq);
+    twimap_printf(map, "%u %d:%d %s %d:%d %u\n",
+                  rec->time,
+                  rec->prev_pid, rec->prev_tid,
+                  __state_name(rec->prev_state),
+                  rec->next_pid, rec->next_tid,
+                  rec->next_lat);
+}
+
+static void
+sched_stat_twimappable()
+{
+    struct twifs_node* sched_root;
+
+    sched_root = twifs_dir_node(NULL, "sched");
+
+    twimap_export_value(sched_root, stats,   FSACL_ugR, NULL);
+    twimap_export_value(sched_root, latency, FSACL_ugR, NULL);
+    twimap_export_list (sched_root, trace,   FSACL_ugR, NULL);
+}
+EXPORT_TWIFS_PLUGIN(sched_stat, sched_stat_twimappable);
+
+static void
+__kstat_sched(struct twimap* map)
+{
+    struct kstat_sched_ent ent;
+    size_t rec;
+
+    ent = (struct kstat_sched_ent) {
+        .nr_switch = sched_stats.nr_switch,
+        .nr_vol = sched_stats.nr_vol,
+        .nr_invol = sched_stats.nr_invol
+    };
+
+    for (int i = 0; i < MIN(SCHED_LAT_BUCKETS, KSTAT_CYC_BUCKETS); i++) {
+        ent.lat_hist[i] = sched_stats.lat_hist[i];
+    }
+
+    rec = kstat_begin(map, KSTAT_SCHED, sizeof(ent));
+    kstat_put(map, &ent, sizeof(ent));
+    kstat_end(map, rec);
+}
+EXPORT_KSTAT(sched, __kstat_sched);
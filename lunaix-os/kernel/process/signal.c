@@ -18,7 +18,7 @@ LOG_MODULE("SIG")
 extern struct scheduler sched_ctx; /* kernel/sched.c */
 
 #define UNMASKABLE (sigset(SIGKILL) | sigset(SIGTERM) | sigset(SIGILL))
-#define TERMSIG (sigset(SIGSEGV) | sigset(SIGINT) | UNMASKABLE)
+#define TERMSIG (sigset(SIGSEGV) | sigset(SIGINT) | sigset(SIGPIPE) | UNMASKABLE)
 #define CORE (sigset(SIGSEGV))
 #define within_kstack(addr)                                                    \
     (KSTACK_AREA <= (addr) && (addr) <= KSTACK_AREA_END)
@@ -1,5 +1,6 @@
 #include <lunaix/fs/taskfs.h>
 #include <lunaix/process.h>
+#include <lunaix/syscallstat.h>
 
 void
 __read_parent(struct twimap* map)
@@ -58,6 +59,58 @@ __reset_children(struct twimap* map)
     map->index = proc->children.next;
 }
 
+static void
+__read_sched(struct twimap* map)
+{
+    struct llist_header* th_list = twimap_index(map, struct llist_header*);
+    struct thread_stats* stats;
+    struct thread* th;
+
+    if (!th_list)
+        return;
+
+    th = container_of(th_list, struct thread, proc_sibs);
+    stats = &th->stats;
+
+    twimap_printf(map, "%d %u %u %u %u",
+                  th->tid,
+                  stats->nr_vol_switch,
+                  stats->nr_invol_switch,
+                  stats->cpu_time,
+                  stats->wait_time);
+
+    for (int i = 0; i < SCHED_LAT_BUCKETS; i++) {
+        twimap_printf(map, " %u", stats->lat_hist[i]);
+    }
+
+    twimap_printf(map, "\n");
+}
+
+static int
+__next_sched(struct twimap* map)
+{
+    struct llist_header* th = twimap_index(map, struct llist_header*);
+    struct proc_info* proc = twimap_data(map, struct proc_info*);
+    if (!th)
+        return 0;
+    map->index = th->next;
+    if (map->index == &proc->threads) {
+        return 0;
+    }
+    return 1;
+}
+
+static void
+__reset_sched(struct twimap* map)
+{
+    struct proc_info* proc = twimap_data(map, struct proc_info*);
+    if (llist_empty(&proc->threads)) {
+        map->index = 0;
+        return;
+    }
+    map->index = proc->threads.next;
+}
+
 void
 export_task_attr()
 {
@@ -89,4 +142,13 @@ export_task_attr()
     map->go_next = __next_children;
     map->reset = __reset_children;
     taskfs_export_attr("children", map);
+
+    // tid vol invol cpu_ms wait_ms, followed by latency histogram
+    map = twimap_create(NULL);
+    map->read = __read_sched;
+    map->go_next = __next_sched;
+    map->reset = __reset_sched;
+    taskfs_export_attr("sched", map);
+
+    syscall_stat_export_taskfs();
 }
\ No newline at end of file
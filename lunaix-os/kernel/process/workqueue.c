@@ -0,0 +1,418 @@
+/**
+ * @file workqueue.c
+ * @brief Run works in the preemptible kernel threads.
+ *
+ * Each workqueue has its own pool of workers, which are kernel
+ * threads of the kernel process. The pool grows on demand: a worker
+ * that picks a work but leaves backlog behind with no one idle will
+ * spawn a new worker before running it. As only the kernel process
+ * can spawn kernel threads, the growth is always done by the workers
+ * themselves, and the first one by the creator of the queue.
+ *
+ * Works are queued to the queue's pending list, and it is fine to do
+ * so in interrupt context, hence the lock is always taken with
+ * interrupt off.
+ */
+
+#include <lunaix/workqueue.h>
+#include <lunaix/process.h>
+#include <lunaix/sched.h>
+#include <lunaix/kpreempt.h>
+#include <lunaix/owloysius.h>
+#include <lunaix/spike.h>
+#include <lunaix/syslog.h>
+#include <lunaix/mm/valloc.h>
+
+#include <asm/cpu.h>
+
+LOG_MODULE("wq")
+
+#define SYSTEM_WQ_WORKERS   4
+
+struct worker
+{
+    struct llist_header workers;
+    struct thread* thread;
+    struct workqueue* wq;
+    struct work* current;
+};
+
+struct workqueue* system_wq = NULL;
+
+/*
+    Workers that have been spawned, but not yet running. A newborn
+    worker finds itself here by its thread.
+ */
+static DEFINE_LLIST(nursery);
+static DEFINE_SPINLOCK(nursery_lock);
+
+static void
+__worker_main();
+
+static bool
+__spawn_worker(struct workqueue* wq)
+{
+    struct worker* worker;
+    struct thread* th;
+    reg_t flags;
+
+    assert(kernel_process(__current));
+
+    worker = vzalloc(sizeof(*worker));
+    if (!worker) {
+        return false;
+    }
+
+    flags = cpu_save_interrupt();
+
+    th = create_thread(__current, false);
+    if (!th) {
+        cpu_restore_interrupt(flags);
+        vfree(worker);
+        return false;
+    }
+
+    worker->thread = th;
+    worker->wq = wq;
+
+    spinlock_acquire(&nursery_lock);
+    llist_append(&nursery, &worker->workers);
+    spinlock_release(&nursery_lock);
+
+    start_thread(th, (ptr_t)__worker_main);
+    detach_thread(th);
+
+    cpu_restore_interrupt(flags);
+
+    return true;
+}
+
+static struct worker*
+__adopt_worker()
+{
+    struct worker *pos, *n;
+    struct workqueue* wq;
+    reg_t flags;
+
+    flags = spinlock_acquire_irqsave(&nursery_lock);
+
+    llist_for_each(pos, n, &nursery, workers)
+    {
+        if (pos->thread == current_thread) {
+            llist_delete(&pos->workers);
+            goto found;
+        }
+    }
+
+    fail("worker: not from nursery");
+
+found:
+    spinlock_release_irqrestore(&nursery_lock, flags);
+
+    wq = pos->wq;
+
+    flags = spinlock_acquire_irqsave(&wq->lock);
+    llist_append(&wq->workers, &pos->workers);
+    spinlock_release_irqrestore(&wq->lock, flags);
+
+    return pos;
+}
+
+static inline bool
+__should_grow(struct workqueue* wq)
+{
+    return !llist_empty(&wq->pending)
+            && !wq->nr_idle
+            && wq->nr_workers < wq->max_workers;
+}
+
+static void
+__grow_pool(struct workqueue* wq)
+{
+    reg_t flags;
+
+    if (__spawn_worker(wq)) {
+        return;
+    }
+
+    WARN("%s: unable to spawn worker", wq->name);
+
+    flags = spinlock_acquire_irqsave(&wq->lock);
+    wq->nr_workers--;
+    spinlock_release_irqrestore(&wq->lock, flags);
+}
+
+static void
+__worker_main()
+{
+    struct worker* worker;
+    struct workqueue* wq;
+    struct work* work;
+    reg_t flags;
+    bool grow;
+
+    worker = __adopt_worker();
+    wq = worker->wq;
+
+    set_preemption();
+
+    while (1)
+    {
+        flags = spinlock_acquire_irqsave(&wq->lock);
+
+        if (llist_empty(&wq->pending)) {
+            wq->nr_idle++;
+            prepare_to_wait(&wq->idle);
+            spinlock_release(&wq->lock);
+
+            try_wait();
+            set_preemption();
+            continue;
+        }
+
+        work = list_entry(wq->pending.next, struct work, link);
+        llist_delete(&work->link);
+        work->pending = false;
+
+        worker->current = work;
+        wq->nr_busy++;
+
+        grow = __should_grow(wq);
+        if (grow) {
+            wq->nr_workers++;
+        }
+
+        spinlock_release_irqrestore(&wq->lock, flags);
+
+        if (grow) {
+            __grow_pool(wq);
+        }
+
+        // the work may free itself, do not touch it afterward.
+        work->fn(work);
+
+        flags = spinlock_acquire_irqsave(&wq->lock);
+
+        worker->current = NULL;
+        wq->nr_busy--;
+        pwake_all(&wq->flushers);
+
+        spinlock_release_irqrestore(&wq->lock, flags);
+    }
+}
+
+struct workqueue*
+workqueue_create(const char* name, int max_workers)
+{
+    struct workqueue* wq;
+
+    assert(max_workers > 0);
+
+    wq = vzalloc(sizeof(*wq));
+    if (!wq) {
+        return NULL;
+    }
+
+    wq->name = name;
+    wq->max_workers = max_workers;
+    wq->nr_workers = 1;
+
+    spinlock_init(&wq->lock);
+    llist_init_head(&wq->pending);
+    llist_init_head(&wq->workers);
+    waitq_init(&wq->idle);
+    waitq_init(&wq->flushers);
+
+    if (!__spawn_worker(wq)) {
+        vfree(wq);
+        return NULL;
+    }
+
+    return wq;
+}
+
+bool
+queue_work(struct workqueue* wq, struct work* work)
+{
+    reg_t flags;
+    bool queued = false;
+
+    assert(wq);
+
+    flags = spinlock_acquire_irqsave(&wq->lock);
+
+    if (work->pending) {
+        goto done;
+    }
+
+    work->wq = wq;
+    work->pending = true;
+    llist_append(&wq->pending, &work->link);
+    queued = true;
+
+    if (wq->nr_idle) {
+        wq->nr_idle--;
+        pwake_one(&wq->idle);
+    }
+
+done:
+    spinlock_release_irqrestore(&wq->lock, flags);
+    return queued;
+}
+
+static void
+__delayed_work_fire(void* payload)
+{
+    struct delayed_work* dwork;
+    reg_t flags;
+
+    dwork = (struct delayed_work*)payload;
+
+    flags = cpu_save_interrupt();
+    dwork->timer = NULL;
+    cpu_restore_interrupt(flags);
+
+    queue_work(dwork->work.wq, &dwork->work);
+}
+
+bool
+queue_delayed_work(struct workqueue* wq,
+                   struct delayed_work* dwork, u32_t ms)
+{
+    reg_t flags;
+    bool armed = false;
+
+    if (!ms) {
+        return queue_work(wq, &dwork->work);
+    }
+
+    flags = cpu_save_interrupt();
+
+    if (dwork->timer || dwork->work.pending) {
+        goto done;
+    }
+
+    dwork->work.wq = wq;
+    dwork->timer = timer_run_ms(ms, __delayed_work_fire, dwork, 0);
+    armed = !!dwork->timer;
+
+done:
+    cpu_restore_interrupt(flags);
+    return armed;
+}
+
+bool
+cancel_work(struct work* work)
+{
+    struct workqueue* wq;
+    reg_t flags;
+    bool cancelled = false;
+
+    wq = work->wq;
+    if (!wq) {
+        return false;
+    }
+
+    flags = spinlock_acquire_irqsave(&wq->lock);
+
+    if (work->pending) {
+        llist_delete(&work->link);
+        work->pending = false;
+        cancelled = true;
+    }
+
+    spinlock_release_irqrestore(&wq->lock, flags);
+    return cancelled;
+}
+
+bool
+cancel_delayed_work(struct delayed_work* dwork)
+{
+    reg_t flags;
+
+    flags = cpu_save_interrupt();
+
+    if (dwork->timer) {
+        timer_cancel(dwork->timer);
+        dwork->timer = NULL;
+        cpu_restore_interrupt(flags);
+        return true;
+    }
+
+    cpu_restore_interrupt(flags);
+
+    return cancel_work(&dwork->work);
+}
+
+static bool
+__work_running(struct workqueue* wq, struct work* work)
+{
+    struct worker *pos, *n;
+
+    llist_for_each(pos, n, &wq->workers, workers)
+    {
+        if (pos->current == work) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+__wait_flushed(struct workqueue* wq, struct work* work)
+{
+    bool busy;
+
+    no_preemption();
+    spinlock_acquire(&wq->lock);
+
+    while (1)
+    {
+        if (work) {
+            busy = work->pending || __work_running(wq, work);
+        }
+        else {
+            busy = !llist_empty(&wq->pending) || wq->nr_busy;
+        }
+
+        if (!busy) {
+            break;
+        }
+
+        prepare_to_wait(&wq->flushers);
+        spinlock_release(&wq->lock);
+
+        try_wait();
+
+        no_preemption();
+        spinlock_acquire(&wq->lock);
+    }
+
+    spinlock_release(&wq->lock);
+    set_preemption();
+}
+
+void
+flush_work(struct work* work)
+{
+    if (!work->wq) {
+        return;
+    }
+
+    __wait_flushed(work->wq, work);
+}
+
+void
+flush_workqueue(struct workqueue* wq)
+{
+    __wait_flushed(wq, NULL);
+}
+
+static void
+workqueue_init()
+{
+    system_wq = workqueue_create("system", SYSTEM_WQ_WORKERS);
+    assert_msg(system_wq, "failed to create system workqueue");
+}
+owloysius_fetch_init(workqueue_init, on_postboot);
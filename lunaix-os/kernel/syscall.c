@@ -1,19 +1,37 @@
 #include <lunaix/process.h>
 #include <lunaix/kpreempt.h>
+#include <lunaix/tracepoint.h>
+#include <lunaix/syscallstat.h>
+
+DEFINE_TRACEPOINT(syscall_enter);
+DEFINE_TRACEPOINT(syscall_exit);
 
 typedef reg_t (*syscall_fn)(reg_t p1, reg_t p2, reg_t p3, reg_t p4, reg_t p5);
 
+extern syscall_fn __syscall_table[];
+
+/*
+    The syscall handler passes the slot in the syscall table rather
+    than the function itself, so the syscall number comes for free.
+ */
 reg_t
-dispatch_syscall(void* syscall_fnptr, 
+dispatch_syscall(syscall_fn* slot, 
                  reg_t p1, reg_t p2, reg_t p3, reg_t p4, reg_t p5)
 {
     reg_t ret_val;
+    u64_t stamp;
     
     thread_stats_update_entering(true);
+    trace_event(syscall_enter, *slot, p1);
     
+    stamp = syscall_stat_enter();
+
     set_preemption();
-    ret_val = ((syscall_fn)syscall_fnptr)(p1, p2, p3, p4, p5);
+    ret_val = (*slot)(p1, p2, p3, p4, p5);
     no_preemption();
 
+    syscall_stat_leave(slot - __syscall_table, stamp, ret_val);
+    trace_event(syscall_exit, *slot, ret_val);
+
     return ret_val;
-}
\ No newline at end of file
+}
@@ -0,0 +1,417 @@
+/**
+ * @file syscallstat.c
+ * @brief Syscall frequency and latency accounting.
+ *
+ * Every syscall is charged with the TSC cycles elapsed between the
+ * dispatch and the return, including the time spent being preempted
+ * or blocked. Counters are per CPU and only touched with preemption
+ * off, so no locking is needed, they are summed up when read.
+ *
+ * Per-process counters are an opt-in, as they cost an allocation for
+ * each process. Once switched on, every process created afterwards
+ * and every living process gets its own table. Switching it off
+ * only stops the allocation, existing tables keep counting.
+ *
+ * Exported to twifs:
+ *      /syscall/stats          "<name> <calls> <errors> <avg> <max>"
+ *      /syscall/latency        "<name>" followed by the histogram
+ *      /syscall/per_process    write 1 or 0 to switch on or off
+ *
+ * to taskfs as /task/<pid>/syscalls, and to /kstats as well.
+ */
+
+#include <lunaix/syscallstat.h>
+#include <lunaix/process.h>
+#include <lunaix/sched.h>
+#include <lunaix/percpu.h>
+#include <lunaix/spike.h>
+#include <lunaix/kstats.h>
+#include <lunaix/fs/taskfs.h>
+#include <lunaix/fs/twifs.h>
+#include <lunaix/fs/twimap.h>
+#include <lunaix/mm/valloc.h>
+
+#include <asm/muldiv64.h>
+
+#include <klibc/string.h>
+
+#define SYSCALL_CYC_SHIFT   8
+#define SYSCALL_NAME_PREFIX "__lxsys_"
+
+#define SYSCALL(x)  stringify(x),
+static const char* syscall_names[] = {
+#include <asm/syscall_nr.inc>
+};
+#undef SYSCALL
+
+#define NR_SYSCALLS     (sizeof(syscall_names) / sizeof(syscall_names[0]))
+
+struct syscall_stat
+{
+    unsigned long calls;
+    unsigned long errors;
+    u64_t cycles;
+    u64_t max_cycles;
+    unsigned int lat_hist[KSTAT_CYC_BUCKETS];
+};
+
+static struct syscall_stat syscall_stats[CONFIG_NR_CPUS][NR_SYSCALLS];
+static volatile bool per_process = false;
+
+static inline int
+__cyc_bucket(u64_t cycles)
+{
+    int order;
+
+    if (cycles < (1ULL << SYSCALL_CYC_SHIFT)) {
+        return 0;
+    }
+
+    // rdtsc deltas of a single syscall fit well in 32 bits.
+    order = (int)ilog2((unsigned long)MIN(cycles, 0xffffffffULL));
+    return MIN(order - SYSCALL_CYC_SHIFT + 1, KSTAT_CYC_BUCKETS - 1);
+}
+
+static inline const char*
+__syscall_name(unsigned int nr)
+{
+    const char* name = syscall_names[nr];
+    size_t len = sizeof(SYSCALL_NAME_PREFIX) - 1;
+
+    if (strlen(name) > len && !memcmp(name, SYSCALL_NAME_PREFIX, len)) {
+        return name + len;
+    }
+
+    return name;
+}
+
+void
+syscall_stat_leave(unsigned int nr, u64_t stamp, reg_t retval)
+{
+    struct syscall_stat* stat;
+    struct syscall_pstat* pstat;
+    u64_t cycles;
+
+    if (unlikely(nr >= NR_SYSCALLS)) {
+        return;
+    }
+
+    cycles = cpu_cycles() - stamp;
+    stat   = &syscall_stats[this_cpu_id()][nr];
+
+    stat->calls++;
+    stat->cycles += cycles;
+    stat->lat_hist[__cyc_bucket(cycles)]++;
+
+    if ((long)retval < 0) {
+        stat->errors++;
+    }
+
+    if (cycles > stat->max_cycles) {
+        stat->max_cycles = cycles;
+    }
+
+    pstat = __current->sysstats;
+    if (pstat) {
+        pstat[nr].calls++;
+        pstat[nr].cycles += cycles;
+    }
+}
+
+void
+syscall_stat_attach(struct proc_info* proc)
+{
+    proc->sysstats = NULL;
+
+    if (per_process) {
+        proc->sysstats = vzalloc(NR_SYSCALLS * sizeof(struct syscall_pstat));
+    }
+}
+
+void
+syscall_stat_detach(struct proc_info* proc)
+{
+    vfree_safe(proc->sysstats);
+    proc->sysstats = NULL;
+}
+
+static void
+__syscall_stat_sum(unsigned int nr, struct syscall_stat* sum)
+{
+    struct syscall_stat* stat;
+
+    memset(sum, 0, sizeof(*sum));
+
+    for (int cpu = 0; cpu < CONFIG_NR_CPUS; cpu++)
+    {
+        stat = &syscall_stats[cpu][nr];
+
+        sum->calls  += stat->calls;
+        sum->errors += stat->errors;
+        sum->cycles += stat->cycles;
+        sum->max_cycles = MAX(sum->max_cycles, stat->max_cycles);
+
+        for (int i = 0; i < KSTAT_CYC_BUCKETS; i++) {
+            sum->lat_hist[i] += stat->lat_hist[i];
+        }
+    }
+}
+
+/*
+    twifs exports, both lists skip over the syscalls never made.
+ */
+
+static int
+__syscall_gonext(struct twimap* map)
+{
+    unsigned int nr = (unsigned int)(ptr_t)map->index;
+    struct syscall_stat sum;
+
+    while (++nr < NR_SYSCALLS)
+    {
+        __syscall_stat_sum(nr, &sum);
+        if (sum.calls) {
+            map->index = (void*)(ptr_t)nr;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void
+__twimap_reset_stats(struct twimap* map)
+{
+    map->index = (void*)0;
+    twimap_printf(map, "name calls errors avg_cycles max_cycles\n");
+}
+
+static int
+__twimap_gonext_stats(struct twimap* map)
+{
+    return __syscall_gonext(map);
+}
+
+static void
+__twimap_read_stats(struct twimap* map)
+{
+    unsigned int nr = (unsigned int)(ptr_t)map->index;
+    struct syscall_stat sum;
+
+    __syscall_stat_sum(nr, &sum);
+    if (!sum.calls) {
+        return;
+    }
+
+    twimap_printf(map, "%s %u %u %u %u\n",
+                  __syscall_name(nr),
+                  sum.calls, sum.errors,
+                  (unsigned int)udiv64(sum.cycles, sum.calls),
+                  (unsigned int)sum.max_cycles);
+}
+
+static void
+__twimap_reset_latency(struct twimap* map)
+{
+    map->index = (void*)0;
+
+    twimap_printf(map, "name <%u", 1U << SYSCALL_CYC_SHIFT);
+    for (int i = 1; i < KSTAT_CYC_BUCKETS; i++) {
+        twimap_printf(map, " %s%u", i == KSTAT_CYC_BUCKETS - 1 ? ">=" : "",
+                      1U << (i + SYSCALL_CYC_SHIFT - 1));
+    }
+    twimap_printf(map, "\n");
+}
+
+static int
+__twimap_gonext_latency(struct twimap* map)
+{
+    return __syscall_gonext(map);
+}
+
+static void
+__twimap_read_latency(struct twimap* map)
+{
+    unsigned int nr = (unsigned int)(ptr_t)map->index;
+    struct syscall_stat sum;
+
+    __syscall_stat_sum(nr, &sum);
+    if (!sum.calls) {
+        return;
+    }
+
+    twimap_printf(map, "%s", __syscall_name(nr));
+    for (int i = 0; i < KSTAT_CYC_BUCKETS; i++) {
+        twimap_printf(map, " %u", sum.lat_hist[i]);
+    }
+    twimap_printf(map, "\n");
+}
+
+static int
+__twifs_read_per_process(struct v_inode* inode, void* buffer,
+                         size_t len, size_t fpos)
+{
+    if (fpos || len < 2) {
+        return 0;
+    }
+
+    memcpy(buffer, per_process ? "1\n" : "0\n", 2);
+    return 2;
+}
+
+static int
+__twifs_write_per_process(struct v_inode* inode, void* buffer,
+                          size_t len, size_t fpos)
+{
+    struct proc_info* proc;
+    char val;
+
+    if (!len) {
+        return 0;
+    }
+
+    val = *(char*)buffer;
+    if (val != '0' && val != '1') {
+        return EINVAL;
+    }
+
+    per_process = (val == '1');
+    if (!per_process) {
+        return len;
+    }
+
+    for (pid_t pid = 1; pid < (pid_t)MAX_PROCESS; pid++)
+    {
+        proc = get_process(pid);
+        if (!proc || proc->sysstats) {
+            continue;
+        }
+
+        proc->sysstats = vzalloc(NR_SYSCALLS * sizeof(struct syscall_pstat));
+    }
+
+    return len;
+}
+
+static void
+syscall_stat_twimappable()
+{
+    struct twifs_node* syscall_root;
+    struct twifs_export exp = {
+        .name = "per_process",
+        .acl = FSACL_ugR | FSACL_ugW,
+        .stream = true,
+        .ops = { .read = __twifs_read_per_process,
+                 .write = __twifs_write_per_process }
+    };
+
+    syscall_root = twifs_dir_node(NULL, "syscall");
+
+    twifs_basic_node_from(syscall_root, &exp, NULL);
+    twimap_export_list(syscall_root, stats,   FSACL_ugR, NULL);
+    twimap_export_list(syscall_root, latency, FSACL_ugR, NULL);
+}
+EXPORT_TWIFS_PLUGIN(syscall_stat, syscall_stat_twimappable);
+
+/*
+    taskfs export
+ */
+
+static void
+__read_syscalls(struct twimap* map)
+{
+    struct proc_info* proc = twimap_data(map, struct proc_info*);
+    unsigned int nr = (unsigned int)(ptr_t)map->index;
+    struct syscall_pstat* pstat;
+
+    if (!proc->sysstats || nr >= NR_SYSCALLS) {
+        return;
+    }
+
+    pstat = &proc->sysstats[nr];
+    if (!pstat->calls) {
+        return;
+    }
+
+    twimap_printf(map, "%s %u %u\n",
+                  __syscall_name(nr), pstat->calls,
+                  (unsigned int)udiv64(pstat->cycles, pstat->calls));
+}
+
+static int
+__next_syscalls(struct twimap* map)
+{
+    struct proc_info* proc = twimap_data(map, struct proc_info*);
+    unsigned int nr = (unsigned int)(ptr_t)map->index;
+
+    if (!proc->sysstats) {
+        return 0;
+    }
+
+    while (++nr < NR_SYSCALLS)
+    {
+        if (proc->sysstats[nr].calls) {
+            map->index = (void*)(ptr_t)nr;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void
+__reset_syscalls(struct twimap* map)
+{
+    map->index = (void*)0;
+}
+
+void
+syscall_stat_export_taskfs()
+{
+    struct twimap* map;
+
+    // name calls avg_cycles, empty unless per-process accounting is on
+    map = twimap_create(NULL);
+    map->read = __read_syscalls;
+    map->go_next = __next_syscalls;
+    map->reset = __reset_syscalls;
+    taskfs_export_attr("syscalls", map);
+}
+
+/*
+    kstats export
+ */
+
+static void
+__kstat_syscall(struct twimap* map)
+{
+    struct kstat_syscall_ent ent;
+    struct syscall_stat sum;
+    size_t rec;
+
+    rec = kstat_begin(map, KSTAT_SYSCALL, sizeof(ent));
+
+    for (unsigned int nr = 0; nr < NR_SYSCALLS; nr++)
+    {
+        __syscall_stat_sum(nr, &sum);
+        if (!sum.calls) {
+            continue;
+        }
+
+        ent = (struct kstat_syscall_ent) {
+            .nr = nr,
+            .calls = sum.calls,
+            .errors = sum.errors,
+            .cycles = sum.cycles,
+            .max_cycles = sum.max_cycles
+        };
+
+        strncpy(ent.name, __syscall_name(nr), KSTAT_NAME_LEN - 1);
+        memcpy(ent.lat_hist, sum.lat_hist, sizeof(ent.lat_hist));
+
+        kstat_put(map, &ent, sizeof(ent));
+    }
+
+    kstat_end(map, rec);
+}
+EXPORT_KSTAT(syscall, __kstat_syscall);
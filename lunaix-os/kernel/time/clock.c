@@ -1,5 +1,6 @@
 #include <lunaix/clock.h>
 #include <lunaix/device.h>
+#include <lunaix/ds/seqlock.h>
 #include <lunaix/fs/twifs.h>
 #include <lunaix/spike.h>
 
@@ -29,14 +30,71 @@ __twimap_read_unixtime(struct twimap* map)
     twimap_printf(map, "%u", clock_unixtime());
 }
 
-time_t
-clock_unixtime()
+/*
+    Reading rtc is a round of slow port io, while the vfs ask for
+    unix time on every inode touch. Keep a (unixtime, systime) pair
+    and extrapolate from it with the system timer, resynchronize once
+    in a while to catch up with drifting, or a change to rtc.
+ */
+#define UNIXTIME_RESYNC_MS      60000
+
+static struct {
+    seqlock_t lock;
+    time_t unix_base;
+    time_t sys_base;
+    bool valid;
+} walltime_cache;  // all-zero is a valid, unlocked seqlock
+
+static time_t
+__read_rtc_unixtime()
 {
     datetime_t dt;
     hwrtc_walltime(&dt);
     return datetime_tounix(&dt);
 }
 
+time_t
+clock_unixtime()
+{
+    unsigned int seq;
+    time_t unix_base, sys_base, now;
+    bool valid;
+
+    if (unlikely(!systimer)) {
+        return __read_rtc_unixtime();
+    }
+
+    do {
+        seq = read_seqbegin(&walltime_cache.lock);
+        unix_base = walltime_cache.unix_base;
+        sys_base  = walltime_cache.sys_base;
+        valid     = walltime_cache.valid;
+    } while (read_seqretry(&walltime_cache.lock, seq));
+
+    now = clock_systime();
+    if (valid && now - sys_base < UNIXTIME_RESYNC_MS) {
+        return unix_base + (now - sys_base) / 1000;
+    }
+
+    unix_base = __read_rtc_unixtime();
+
+    write_seqlock(&walltime_cache.lock);
+    walltime_cache.unix_base = unix_base;
+    walltime_cache.sys_base  = now;
+    walltime_cache.valid     = true;
+    write_sequnlock(&walltime_cache.lock);
+
+    return unix_base;
+}
+
+void
+clock_unixtime_resync()
+{
+    write_seqlock(&walltime_cache.lock);
+    walltime_cache.valid = false;
+    write_sequnlock(&walltime_cache.lock);
+}
+
 time_t
 clock_systime()
 {
@@ -17,16 +17,26 @@
 #include <lunaix/syslog.h>
 #include <lunaix/timer.h>
 #include <lunaix/hart_state.h>
+#include <lunaix/profiler.h>
 
 #include <hal/hwtimer.h>
+#include <hal/irq.h>
+
+#include <asm/cpu.h>
 
 LOG_MODULE("TIMER");
 
 static void
 timer_update();
 
+static void
+timer_expire(void* data);
+
 static DEFINE_LLIST(timers);
 
+static struct irq_tasklet timer_tasklet;
+static volatile ticks_t timer_ticks = 0;
+
 static volatile u32_t sched_ticks = 0;
 static volatile u32_t sched_ticks_counter = 0;
 
@@ -36,6 +46,7 @@ void
 timer_init_context()
 {
     timer_pile = cake_new_pile("timer", sizeof(struct lx_timer), 1, 0);
+    irq_tasklet_init(&timer_tasklet, timer_expire, NULL);
 }
 
 void
@@ -73,47 +84,100 @@ struct lx_timer*
 timer_run(ticks_t ticks, void (*callback)(void*), void* payload, u8_t flags)
 {
     struct lx_timer* timer = (struct lx_timer*)cake_grab(timer_pile);
+    reg_t intr;
 
     if (!timer)
         return NULL;
 
     timer->callback = callback;
-    timer->counter = ticks;
     timer->deadline = ticks;
     timer->payload = payload;
     timer->flags = flags;
 
+    intr = cpu_save_interrupt();
+    timer->armed = timer_ticks;
     llist_append(&timers, &timer->link);
+    cpu_restore_interrupt(intr);
 
     return timer;
 }
 
+void
+timer_cancel(struct lx_timer* timer)
+{
+    reg_t intr;
+
+    // leave the unlinking to timer_expire, which might be walking on it.
+    intr = cpu_save_interrupt();
+    timer->callback = NULL;
+    timer->flags &= ~TIMER_MODE_PERIODIC;
+    timer->deadline = 0;
+    cpu_restore_interrupt(intr);
+}
+
+/*
+    Bottom half of the tick, walk the timers with interrupt enabled.
+    A timer is due once `deadline` ticks have passed since it was
+    armed, so however late we are, it is only charged with the time
+    it actually spent in the list.
+ */
 static void
-timer_update()
+timer_expire(void* data)
 {
     struct lx_timer *pos, *n;
+    ticks_t now;
+    reg_t intr;
+
+    now = timer_ticks;
 
     llist_for_each(pos, n, &timers, link)
     {
-        if (--(pos->counter)) {
+        if (now - pos->armed < pos->deadline) {
             continue;
         }
 
         pos->callback ? pos->callback(pos->payload) : 1;
 
         if ((pos->flags & TIMER_MODE_PERIODIC)) {
-            pos->counter = pos->deadline;
-        } else {
-            llist_delete(&pos->link);
-            cake_release(timer_pile, pos);
+            pos->armed += pos->deadline;
+            continue;
         }
+
+        intr = cpu_save_interrupt();
+        llist_delete(&pos->link);
+        cpu_restore_interrupt(intr);
+
+        cake_release(timer_pile, pos);
+    }
+}
+
+static void
+timer_update()
+{
+    timer_ticks++;
+
+    if (!llist_empty(&timers)) {
+        irq_tasklet_schedule(&timer_tasklet);
     }
 
     sched_ticks_counter++;
 
+    profiler_tick();
+
+    /*
+        Tasklets are not preemptible, the slice is over but we will
+        have to wait for the next tick.
+     */
+    if (irq_in_deferred()) {
+        return;
+    }
+
+    /*
+        Do not switch right here, the interrupt is not yet acked.
+        Leave it to the exit path, after the EOI and tasklets.
+     */
     if (sched_ticks_counter >= sched_ticks) {
         sched_ticks_counter = 0;
-        thread_stats_update_entering(false);
-        schedule();
+        this_cpu()->slice_over = true;
     }
 }
@@ -1,6 +1,5 @@
 import gdb
 from .symbols import LunaixSymbols, SymbolDomain
-from .utils import llist_foreach
 
 class SysLogDump(gdb.Command):
     """Dump the system log"""
@@ -11,14 +10,33 @@ class SysLogDump(gdb.Command):
     def syslog_entry_callback(self, idx, ent):
         time = ent["time"]
         lvl = ent["lvl"]
-        log = ent["content"]
+        log = ent["content"].address.cast(gdb.lookup_type("char").pointer())
 
         time_str = "%04d.%03d"%(int(time / 1000), time % 1000)
         print(f"[{time_str}] <L{self.log_level[lvl]}> {log.string()}")
 
     def invoke(self, argument: str, from_tty: bool) -> None:
         log_recs = LunaixSymbols.exported(SymbolDomain.DEBUG, "kprintf", "kprecs")
-        head = log_recs.deref_and_access("kp_ents.ents").address
 
-        ent_type = gdb.lookup_type("struct kp_entry").pointer()
-        llist_foreach(head, ent_type, "ents", lambda a,b: self.syslog_entry_callback(a, b), inclusive=False)
\ No newline at end of file
+        ring = log_recs.deref_and_access("ring")
+        size = int(log_recs.deref_and_access("size"))
+        off  = int(log_recs.deref_and_access("head"))
+        seq  = int(log_recs.deref_and_access("first_seq"))
+        end  = int(log_recs.deref_and_access("next_seq"))
+
+        ent_type = gdb.lookup_type("struct kp_entry")
+        hdr_size = ent_type.sizeof
+
+        while seq != end:
+            if off + hdr_size > size:
+                off = 0
+
+            ent = (ring + off).cast(ent_type.pointer()).dereference()
+            if int(ent["len"]) == 0xffff:
+                off = 0
+                continue
+
+            self.syslog_entry_callback(seq, ent)
+
+            off += (hdr_size + int(ent["len"]) + 3) & ~3
+            seq += 1
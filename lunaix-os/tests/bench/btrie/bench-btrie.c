@@ -0,0 +1,88 @@
+#include <lunaix/ds/btrie.h>
+#include <lunaix/compiler.h>
+#include <testing/bench.h>
+
+#define ORDER       BTRIE_BITS     // log2 of fan-out
+#define NR_KEYS     (1 << 16)
+#define BATCH       1024
+
+static unsigned long keys[NR_KEYS];
+
+static void
+__gen_keys(unsigned long mask)
+{
+    unsigned long x = 88172645463325252UL;
+
+    for (int i = 0; i < NR_KEYS; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        keys[i] = x & mask;
+    }
+}
+
+/*
+    Allocate from a fresh tree in batches, the teardown of each batch
+    is part of the cost.
+ */
+static void
+__bench_map(unsigned long iters, void* arg)
+{
+    struct btrie tree;
+    unsigned long n;
+
+    btrie_init(&tree, ORDER);
+
+    for (n = 0; n < iters; n++)
+    {
+        bench_keep(btrie_map(&tree, 0, -1UL, (void*)(n + 1)));
+
+        if ((n + 1) % BATCH == 0) {
+            btrie_release(&tree);
+            btrie_init(&tree, ORDER);
+        }
+    }
+
+    btrie_release(&tree);
+}
+
+static void
+__bench_get(unsigned long iters, void* arg)
+{
+    struct btrie* tree = (struct btrie*)arg;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        bench_keep(btrie_get(tree, keys[n % NR_KEYS]));
+    }
+}
+
+static void
+__bench_get_sparse(unsigned long mask, const char* name)
+{
+    struct btrie tree;
+
+    if (!bench_selected(name)) {
+        return;
+    }
+
+    __gen_keys(mask);
+
+    btrie_init(&tree, ORDER);
+    for (int i = 0; i < NR_KEYS; i++) {
+        btrie_set(&tree, keys[i], (void*)(keys[i] + 1));
+    }
+
+    bench_measure(name, __bench_get, &tree);
+
+    btrie_release(&tree);
+}
+
+void
+run_bench(int argc, const char* argv[])
+{
+    bench_measure("btrie/map", __bench_map, NULL);
+
+    // dense: keys fall in a range of the same size as the key set
+    __bench_get_sparse(NR_KEYS - 1, "btrie/get_dense");
+    __bench_get_sparse((1UL << 24) - 1, "btrie/get_sparse");
+}
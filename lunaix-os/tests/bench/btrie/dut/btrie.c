@@ -0,0 +1 @@
+../../../../kernel/ds/btrie.c
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include <lunaix/ds/fifo.h>
+#include <testing/bench.h>
+
+#define FIFO_SIZE   4096
+#define CHUNK       64
+
+static char fifo_store[FIFO_SIZE];
+static char chunk[CHUNK];
+
+static void
+__bench_put_read(unsigned long iters, void* arg)
+{
+    struct fifo_buf* fifo = (struct fifo_buf*)arg;
+    u8_t c;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        fifo_putone(fifo, (u8_t)n);
+        fifo_readone_async(fifo, &c);
+        bench_keep(c);
+    }
+}
+
+static void
+__bench_write_read(unsigned long iters, void* arg)
+{
+    struct fifo_buf* fifo = (struct fifo_buf*)arg;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        fifo_write(fifo, chunk, CHUNK);
+        fifo_read(fifo, chunk, CHUNK);
+        bench_clobber();
+    }
+}
+
+void
+run_bench(int argc, const char* argv[])
+{
+    struct fifo_buf fifo;
+
+    fifo_init(&fifo, fifo_store, FIFO_SIZE, 0);
+    bench_measure("fifo/put_read_byte", __bench_put_read, &fifo);
+
+    fifo_init(&fifo, fifo_store, FIFO_SIZE, 0);
+    bench_measure("fifo/write_read_64B", __bench_write_read, &fifo);
+}
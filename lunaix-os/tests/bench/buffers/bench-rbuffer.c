@@ -0,0 +1,45 @@
+#include <lunaix/ds/rbuffer.h>
+#include <testing/bench.h>
+
+#define RB_SIZE     4096
+#define CHUNK       64
+
+static char rb_store[RB_SIZE];
+static char chunk[CHUNK];
+
+static void
+__bench_put_get(unsigned long iters, void* arg)
+{
+    struct rbuffer* rb = (struct rbuffer*)arg;
+    char c;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        rbuffer_put(rb, (char)n);
+        rbuffer_get(rb, &c);
+        bench_keep(c);
+    }
+}
+
+static void
+__bench_puts_gets(unsigned long iters, void* arg)
+{
+    struct rbuffer* rb = (struct rbuffer*)arg;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        rbuffer_puts(rb, chunk, CHUNK);
+        rbuffer_gets(rb, chunk, CHUNK);
+        bench_clobber();
+    }
+}
+
+void
+run_bench(int argc, const char* argv[])
+{
+    struct rbuffer rb;
+
+    rbuffer_init(&rb, rb_store, RB_SIZE);
+    bench_measure("rbuffer/put_get_byte", __bench_put_get, &rb);
+
+    rbuffer_init(&rb, rb_store, RB_SIZE);
+    bench_measure("rbuffer/puts_gets_64B", __bench_puts_gets, &rb);
+}
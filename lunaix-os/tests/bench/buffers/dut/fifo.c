@@ -0,0 +1 @@
+../../../../kernel/ds/fifo.c
\ No newline at end of file
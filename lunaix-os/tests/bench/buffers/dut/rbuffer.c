@@ -0,0 +1 @@
+../../../../kernel/ds/rbuffer.c
\ No newline at end of file
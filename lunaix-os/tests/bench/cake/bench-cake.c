@@ -0,0 +1,64 @@
+#include <lunaix/mm/cake.h>
+#include <testing/bench.h>
+
+#define NR_LIVE     4096
+
+struct cake_bench
+{
+    struct cake_pile* pile;
+    int batch;
+};
+
+static void* live[NR_LIVE];
+
+/*
+    Grab `batch` pieces and release them in the same order, one op
+    is a grab and a release. Pieces of a large batch are spread over
+    many cakes, which is what the release path has to search through.
+ */
+static void
+__bench_grab_release(unsigned long iters, void* arg)
+{
+    struct cake_bench* cb = (struct cake_bench*)arg;
+    unsigned long n = 0;
+    int i;
+
+    while (n < iters)
+    {
+        for (i = 0; i < cb->batch && n + i < iters; i++) {
+            live[i] = cake_grab(cb->pile);
+        }
+
+        for (int j = 0; j < i; j++) {
+            cake_release(cb->pile, live[j]);
+        }
+
+        n += i;
+    }
+}
+
+static void
+__bench_pile(char* name, unsigned int piece_size, int batch)
+{
+    struct cake_bench cb;
+
+    if (!bench_selected(name)) {
+        return;
+    }
+
+    cb.pile  = cake_new_pile(name, piece_size, 1, 0);
+    cb.batch = batch;
+
+    bench_measure(name, __bench_grab_release, &cb);
+}
+
+void
+run_bench(int argc, const char* argv[])
+{
+    cake_init();
+
+    __bench_pile("cake/grab_release_64B_x1",      64,  1);
+    __bench_pile("cake/grab_release_64B_x64",     64,  64);
+    __bench_pile("cake/grab_release_64B_x4096",   64,  NR_LIVE);
+    __bench_pile("cake/grab_release_512B_x4096",  512, NR_LIVE);
+}
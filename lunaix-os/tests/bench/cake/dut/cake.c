@@ -0,0 +1 @@
+../../../../kernel/mm/cake.c
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "dut/devtree.h"
+#include <testing/bench.h>
+
+#define BENCH_DTB       "samples/board.dtb"
+#define MAX_DTB_SZ      (64 * 1024)
+
+extern void init_export___init_devtree();
+
+static char dtb_blob[MAX_DTB_SZ] __attribute__((aligned(8)));
+static struct fdt_blob fdt;
+
+static ptr_t
+__load_dtb()
+{
+    FILE* file;
+    size_t len;
+
+    file = fopen(BENCH_DTB, "rb");
+    if (!file) {
+        printf("fail to open: %s\n", BENCH_DTB);
+        return 0;
+    }
+
+    len = fread(dtb_blob, 1, MAX_DTB_SZ, file);
+    fclose(file);
+
+    return len ? __ptr(dtb_blob) : 0;
+}
+
+static void
+__bench_walk(unsigned long iters, void* arg)
+{
+    fdt_loc_t loc;
+    int delta;
+
+    for (unsigned long n = 0; n < iters; n++)
+    {
+        loc = fdt.root;
+        while (!fdt_eof(loc.token)) {
+            loc = fdt_next_token(loc, &delta);
+        }
+
+        bench_keep(loc.ptr);
+    }
+}
+
+/*
+    Looking for a missing property skips over every sub-node of the
+    root, the first property is found right away.
+ */
+static void
+__bench_find_prop(unsigned long iters, void* arg)
+{
+    struct dtp_val val;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        bench_keep(fdt_find_prop(&fdt, fdt.root, (const char*)arg, &val));
+    }
+}
+
+static void
+__bench_load(unsigned long iters, void* arg)
+{
+    ptr_t dtb = (ptr_t)arg;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        bench_keep(dt_load(dtb));
+    }
+}
+
+static void
+__bench_getprop(unsigned long iters, void* arg)
+{
+    struct dtn* node = (struct dtn*)arg;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        bench_keep(dt_getprop(&node->base, "interrupts"));
+    }
+}
+
+static void
+__bench_find_byname(unsigned long iters, void* arg)
+{
+    struct dtn* soc = (struct dtn*)arg;
+    struct dtn_base* matched;
+    struct dtn_iter it;
+
+    for (unsigned long n = 0; n < iters; n++)
+    {
+        dt_begin_find_byname(&it, soc, "gpio");
+        while (dt_find_next(&it, &matched));
+
+        bench_keep(matched);
+    }
+}
+
+void
+run_bench(int argc, const char* argv[])
+{
+    struct dt_context* ctx;
+    struct dtn_iter it;
+    struct dtn *soc, *uart;
+    ptr_t dtb;
+
+    dtb = __load_dtb();
+    if (!dtb) {
+        return;
+    }
+
+    fdt_load(&fdt, dtb);
+
+    bench_measure("fdt/walk_tokens", __bench_walk, NULL);
+    bench_measure("fdt/find_prop_first", __bench_find_prop, "compatible");
+    bench_measure("fdt/find_prop_missing", __bench_find_prop, "no-such-prop");
+
+    init_export___init_devtree();
+    dt_load(dtb);
+    ctx = dt_main_context();
+
+    dt_begin_find_byname(&it, ctx->root, "soc");
+    soc = (struct dtn*)it.matched;
+
+    dt_begin_find_byname(&it, soc, "uart");
+    uart = (struct dtn*)it.matched;
+
+    bench_measure("dt/getprop", __bench_getprop, uart);
+    bench_measure("dt/find_byname", __bench_find_byname, soc);
+
+    // reloading leaks the previous tree, which is fine for a benchmark
+    bench_measure("dt/load", __bench_load, (void*)dtb);
+}
@@ -0,0 +1 @@
+../../../../kernel/changeling.c
\ No newline at end of file
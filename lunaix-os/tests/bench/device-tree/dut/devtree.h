@@ -0,0 +1 @@
+../../../../hal/devtree/devtree.h
\ No newline at end of file
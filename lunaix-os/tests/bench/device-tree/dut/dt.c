@@ -0,0 +1 @@
+../../../../hal/devtree/dt.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../hal/devtree/dt_interrupt.c
\ No newline at end of file
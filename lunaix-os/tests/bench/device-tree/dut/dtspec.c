@@ -0,0 +1 @@
+../../../../hal/devtree/dtspec.c
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include <lunaix/ds/hstr.h>
+#include <lunaix/ds/hashtable.h>
+#include <lunaix/mm/valloc.h>
+#include <lunaix/compiler.h>
+#include <testing/bench.h>
+
+#include <klibc/string.h>
+
+/*
+    Mirrors the dnode cache in vfs.c: a fixed table of buckets keyed by
+    the name hash mixed with the parent, collisions are chained.
+ */
+#define DCACHE_BITS     10
+#define DCACHE_SIZE     (1 << DCACHE_BITS)
+#define DCACHE_MASK     (DCACHE_SIZE - 1)
+#define DCACHE_HBITS    (32 - DCACHE_BITS)
+
+#define NR_PARENTS      16
+#define NR_NAMES        4096
+
+struct dnode
+{
+    struct hlist_node hash_list;
+    struct dnode* parent;
+    struct hstr name;
+};
+
+struct dcache_ctx
+{
+    struct hbucket pool[DCACHE_SIZE];
+    struct dnode parents[NR_PARENTS];
+    struct dnode* nodes;
+    struct hstr* lookups;
+    int nr_lookups;
+};
+
+static char names[NR_NAMES][24];
+
+static inline struct hbucket*
+__dcache_hash(struct dcache_ctx* ctx, struct dnode* parent, u32_t* hash)
+{
+    u32_t _hash = *hash;
+
+    _hash = _hash ^ (_hash >> DCACHE_HBITS);
+    _hash += (u32_t)__ptr(parent);
+
+    *hash = _hash;
+    return &ctx->pool[_hash & DCACHE_MASK];
+}
+
+static struct dnode*
+__dcache_lookup(struct dcache_ctx* ctx, struct dnode* parent, struct hstr* str)
+{
+    struct hbucket* slot;
+    struct dnode *pos, *n;
+    u32_t hash = str->hash;
+
+    slot = __dcache_hash(ctx, parent, &hash);
+    hashtable_bucket_foreach(slot, pos, n, hash_list)
+    {
+        if (pos->name.hash == hash && pos->parent == parent) {
+            return pos;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+__gen_names()
+{
+    static const char* stems[] = {
+        "lib", "usr", "bin", "config", "README", "kernel", "module", "x"
+    };
+
+    for (int i = 0; i < NR_NAMES; i++) {
+        snprintf(names[i], sizeof(names[i]), "%s%d.%c",
+                 stems[i % 8], i, 'a' + i % 26);
+    }
+}
+
+static void
+__dcache_populate(struct dcache_ctx* ctx, int nr_entries)
+{
+    struct dnode* node;
+    struct hbucket* slot;
+    u32_t hash;
+
+    hashtable_init(ctx->pool);
+    ctx->nodes = vcalloc(sizeof(struct dnode), nr_entries);
+
+    for (int i = 0; i < nr_entries; i++)
+    {
+        node = &ctx->nodes[i];
+        node->parent = &ctx->parents[i % NR_PARENTS];
+        node->name = HSTR(names[i % NR_NAMES], strlen(names[i % NR_NAMES]));
+        hstr_rehash(&node->name, HSTR_FULL_HASH);
+
+        hash = node->name.hash;
+        slot = __dcache_hash(ctx, node->parent, &hash);
+        node->name.hash = hash;
+        hlist_add(&slot->head, &node->hash_list);
+    }
+
+    // names not populated into the cache will miss
+    ctx->nr_lookups = NR_NAMES;
+    ctx->lookups = vcalloc(sizeof(struct hstr), NR_NAMES);
+    for (int i = 0; i < NR_NAMES; i++)
+    {
+        ctx->lookups[i] = HSTR(names[i], strlen(names[i]));
+        hstr_rehash(&ctx->lookups[i], HSTR_FULL_HASH);
+    }
+}
+
+static void
+__bench_strhash(unsigned long iters, void* arg)
+{
+    for (unsigned long n = 0; n < iters; n++) {
+        bench_keep(strhash_32(names[n % NR_NAMES], HSTR_FULL_HASH));
+    }
+}
+
+static void
+__bench_lookup(unsigned long iters, void* arg)
+{
+    struct dcache_ctx* ctx = (struct dcache_ctx*)arg;
+    struct hstr* str;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        str = &ctx->lookups[n % ctx->nr_lookups];
+        bench_keep(__dcache_lookup(ctx, &ctx->parents[n % NR_PARENTS], str));
+    }
+}
+
+static void
+__bench_dcache(int nr_entries, const char* name)
+{
+    struct dcache_ctx* ctx;
+
+    if (!bench_selected(name)) {
+        return;
+    }
+
+    ctx = vzalloc(sizeof(*ctx));
+    __dcache_populate(ctx, nr_entries);
+
+    bench_measure(name, __bench_lookup, ctx);
+
+    vfree(ctx->lookups);
+    vfree(ctx->nodes);
+    vfree(ctx);
+}
+
+void
+run_bench(int argc, const char* argv[])
+{
+    __gen_names();
+
+    bench_measure("hstr/strhash_32", __bench_strhash, NULL);
+
+    // load factor of 1, 4 and 16 per bucket
+    __bench_dcache(DCACHE_SIZE,      "hstr/dcache_lookup_1x");
+    __bench_dcache(DCACHE_SIZE * 4,  "hstr/dcache_lookup_4x");
+    __bench_dcache(DCACHE_SIZE * 16, "hstr/dcache_lookup_16x");
+}
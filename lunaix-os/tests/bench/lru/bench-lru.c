@@ -0,0 +1,105 @@
+#include <lunaix/ds/lru.h>
+#include <lunaix/mm/valloc.h>
+#include <testing/bench.h>
+
+#define NR_OBJS     4096
+#define CAPACITY    (NR_OBJS / 2)
+
+struct lru_bench
+{
+    struct lru_zone* zone;
+    struct lru_node* nodes;
+};
+
+static int
+__evict_always(struct lru_node* node)
+{
+    // mark it as not in the zone, so it can be used again
+    node->lru_nodes.next = NULL;
+    node->lru_nodes.prev = NULL;
+    return 1;
+}
+
+static void
+__populate(struct lru_bench* lb, int count)
+{
+    for (int i = 0; i < count; i++) {
+        lru_use_one(lb->zone, &lb->nodes[i]);
+    }
+}
+
+/*
+    Touch an object already in the zone, i.e. a cache hit.
+ */
+static void
+__bench_hit(unsigned long iters, void* arg)
+{
+    struct lru_bench* lb = (struct lru_bench*)arg;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        lru_use_one(lb->zone, &lb->nodes[(n * 7919) % NR_OBJS]);
+    }
+}
+
+/*
+    Bring in objects over a capacity of half of them, each miss evicts
+    the coldest one.
+ */
+static void
+__bench_miss(unsigned long iters, void* arg)
+{
+    struct lru_bench* lb = (struct lru_bench*)arg;
+
+    for (unsigned long n = 0; n < iters; n++) {
+        lru_use_one(lb->zone, &lb->nodes[n % NR_OBJS]);
+        if (lb->zone->objects > CAPACITY) {
+            lru_evict_one(lb->zone);
+        }
+    }
+}
+
+/*
+    Refill the zone and shrink it by half, the cost is per object
+    brought in.
+ */
+static void
+__bench_evict_half(unsigned long iters, void* arg)
+{
+    struct lru_bench* lb = (struct lru_bench*)arg;
+    unsigned long n = 0;
+
+    while (n < iters) {
+        __populate(lb, NR_OBJS);
+        lru_evict_half(lb->zone);
+        lru_evict_all(lb->zone);
+        n += NR_OBJS;
+    }
+}
+
+static void
+__bench_zone(const char* name, bench_fn fn, int prefill)
+{
+    struct lru_bench lb;
+
+    if (!bench_selected(name)) {
+        return;
+    }
+
+    lb.zone  = lru_new_zone(name, __evict_always);
+    lb.nodes = vzalloc(NR_OBJS * sizeof(struct lru_node));
+
+    __populate(&lb, prefill);
+
+    bench_measure(name, fn, &lb);
+
+    lru_free_zone(lb.zone);
+    vfree(lb.nodes);
+}
+
+void
+run_bench(int argc, const char* argv[])
+{
+    __bench_zone("lru/use_hit",     __bench_hit,        NR_OBJS);
+    __bench_zone("lru/use_miss",    __bench_miss,       0);
+    __bench_zone("lru/evict_half",  __bench_evict_half, 0);
+}
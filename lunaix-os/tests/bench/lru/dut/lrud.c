@@ -0,0 +1 @@
+../../../../kernel/lrud.c
\ No newline at end of file
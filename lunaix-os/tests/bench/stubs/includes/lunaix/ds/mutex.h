@@ -0,0 +1,53 @@
+#ifndef __STUB_LUNAIX_MUTEX_H
+#define __STUB_LUNAIX_MUTEX_H
+
+#include <lunaix/types.h>
+#include <stdatomic.h>
+
+/*
+    Never contended in a benchmark, what remains is the single cmpxchg
+    of the fast path.
+ */
+typedef struct mutex_s
+{
+    atomic_uint lk;
+} mutex_t;
+
+#define DEFINE_MUTEX(name)  \
+    mutex_t name = { .lk = 0 }
+
+static inline void
+mutex_init(mutex_t* mutex)
+{
+    atomic_init(&mutex->lk, 0);
+}
+
+static inline int
+mutex_on_hold(mutex_t* mutex)
+{
+    return atomic_load(&mutex->lk);
+}
+
+static inline bool
+mutex_trylock(mutex_t* mutex)
+{
+    unsigned int unlocked = 0;
+    return atomic_compare_exchange_strong(&mutex->lk, &unlocked, 1);
+}
+
+static inline void
+mutex_lock(mutex_t* mutex)
+{
+    mutex_trylock(mutex);
+}
+
+static inline void
+mutex_unlock(mutex_t* mutex)
+{
+    atomic_store(&mutex->lk, 0);
+}
+
+#define mutex_lock_nested(mutex)        mutex_lock(mutex)
+#define mutex_unlock_nested(mutex)      mutex_unlock(mutex)
+
+#endif /* __STUB_LUNAIX_MUTEX_H */
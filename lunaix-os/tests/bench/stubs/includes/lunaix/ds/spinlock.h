@@ -0,0 +1,69 @@
+#ifndef __STUB_LUNAIX_SPIN_H
+#define __STUB_LUNAIX_SPIN_H
+
+#include <lunaix/types.h>
+#include <stdatomic.h>
+
+/*
+    Benchmarks are single threaded, only the uncontended path of the
+    ticket lock is kept, so the atomics are still paid for.
+ */
+struct spinlock
+{
+    atomic_ushort owner;
+    atomic_ushort next;
+};
+
+typedef struct spinlock spinlock_t;
+
+#define DEFINE_SPINLOCK(name)   \
+    struct spinlock name = { .owner = 0, .next = 0 }
+
+static inline void
+spinlock_init(spinlock_t* lock)
+{
+    atomic_init(&lock->owner, 0);
+    atomic_init(&lock->next, 0);
+}
+
+static inline bool
+spinlock_locked(spinlock_t* lock)
+{
+    return atomic_load(&lock->owner) != atomic_load(&lock->next);
+}
+
+static inline void
+spinlock_acquire(spinlock_t* lock)
+{
+    atomic_fetch_add(&lock->next, 1);
+}
+
+static inline bool
+spinlock_try_acquire(spinlock_t* lock)
+{
+    unsigned short ticket = atomic_load(&lock->owner);
+    return atomic_compare_exchange_strong(&lock->next, &ticket, ticket + 1);
+}
+
+static inline void
+spinlock_release(spinlock_t* lock)
+{
+    unsigned short owner = atomic_load_explicit(&lock->owner,
+                                                memory_order_relaxed);
+    atomic_store_explicit(&lock->owner, owner + 1, memory_order_release);
+}
+
+#define spinlock_acquire_irqsave(lock)                                      \
+    ({ spinlock_acquire(lock); (reg_t)0; })
+
+static inline void
+spinlock_release_irqrestore(spinlock_t* lock, reg_t flags)
+{
+    spinlock_release(lock);
+}
+
+#define DEFINE_SPINLOCK_OPS(type, lock_accessor)                            \
+    static inline void lock(type obj) { spinlock_acquire(&obj->lock_accessor); }    \
+    static inline void unlock(type obj) { spinlock_release(&obj->lock_accessor); }
+
+#endif /* __STUB_LUNAIX_SPIN_H */
@@ -0,0 +1,11 @@
+#ifndef __STUB_LUNAIX_TWIFS_H
+#define __STUB_LUNAIX_TWIFS_H
+
+#include <lunaix/fs/twimap.h>
+
+#define EXPORT_TWIFS_PLUGIN(label, plg_init)
+
+#define twimap_export_list(parent, name_, acl_, data_)     do { } while (0)
+#define twimap_export_value(parent, name_, acl_, data_)    do { } while (0)
+
+#endif /* __STUB_LUNAIX_TWIFS_H */
@@ -0,0 +1,25 @@
+#ifndef __STUB_LUNAIX_TWIMAP_H
+#define __STUB_LUNAIX_TWIMAP_H
+
+#include <lunaix/types.h>
+
+/*
+    Nothing is ever exported, the readers are left unreachable.
+ */
+
+#define twimap_index(twimap, type) ((type)__ptr((twimap)->index))
+#define twimap_data(twimap, type) ((type)__ptr((twimap)->data))
+
+struct twimap
+{
+    void* index;
+    void* data;
+};
+
+static inline void
+twimap_printf(struct twimap* mapping, const char* fmt, ...)
+{
+    return;
+}
+
+#endif /* __STUB_LUNAIX_TWIMAP_H */
@@ -0,0 +1,27 @@
+#ifndef __STUB_LUNAIX_KSTATS_H
+#define __STUB_LUNAIX_KSTATS_H
+
+#include <lunaix/fs/twimap.h>
+#include <usr/lunaix/kstats.h>
+
+#define EXPORT_KSTAT(label, provider)
+
+static inline unsigned long
+kstat_begin(struct twimap* map, int type, unsigned long ent_size)
+{
+    return 0;
+}
+
+static inline void
+kstat_put(struct twimap* map, const void* ent, unsigned long ent_size)
+{
+    return;
+}
+
+static inline void
+kstat_end(struct twimap* map, unsigned long rec_off)
+{
+    return;
+}
+
+#endif /* __STUB_LUNAIX_KSTATS_H */
@@ -0,0 +1,50 @@
+#ifndef __STUB_LUNAIX_PAGE_H
+#define __STUB_LUNAIX_PAGE_H
+
+#include <lunaix/mm/pagetable.h>
+#include <lunaix/spike.h>
+
+/*
+    Leaflets are backed by the host heap, and are identified by their
+    very address, no page frame bookkeeping is involved.
+ */
+
+#define PGPOL_NORMAL    0
+
+struct leaflet;
+
+extern void* aligned_alloc(unsigned long, unsigned long);
+extern void free(void*);
+
+static inline unsigned int
+count_order(unsigned long page_count) {
+    unsigned int po = ilog2(page_count);
+    assert(!(page_count % (1 << po)));
+    return po;
+}
+
+static inline struct leaflet*
+leaflet_alloc_order(int pol, unsigned int order)
+{
+    return (struct leaflet*)aligned_alloc(PAGE_SIZE, PAGE_SIZE << order);
+}
+
+static inline ptr_t
+leaflet_va(struct leaflet* leaflet)
+{
+    return __ptr(leaflet);
+}
+
+static inline struct leaflet*
+leaflet_from_va(ptr_t va)
+{
+    return (struct leaflet*)va;
+}
+
+static inline void
+leaflet_return(struct leaflet* leaflet)
+{
+    free(leaflet);
+}
+
+#endif /* __STUB_LUNAIX_PAGE_H */
@@ -0,0 +1,8 @@
+#ifndef __STUB_LUNAIX_PAGETABLE_H
+#define __STUB_LUNAIX_PAGETABLE_H
+
+#define PAGE_SHIFT              12
+#define PAGE_SIZE               ( 1UL << PAGE_SHIFT )
+#define PAGE_MASK               ( ~( PAGE_SIZE - 1 ) )
+
+#endif /* __STUB_LUNAIX_PAGETABLE_H */
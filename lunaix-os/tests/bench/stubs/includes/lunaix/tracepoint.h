@@ -0,0 +1,8 @@
+#ifndef __STUB_LUNAIX_TRACEPOINT_H
+#define __STUB_LUNAIX_TRACEPOINT_H
+
+#define DEFINE_TRACEPOINT(name_)
+#define DECLARE_TRACEPOINT(name_)
+#define trace_event(name_, arg0, arg1)      do { } while (0)
+
+#endif /* __STUB_LUNAIX_TRACEPOINT_H */
@@ -0,0 +1,42 @@
+#ifndef __STUB_LUNAIX_WORKQUEUE_H
+#define __STUB_LUNAIX_WORKQUEUE_H
+
+#include <lunaix/ds/llist.h>
+#include <lunaix/types.h>
+
+/*
+    There is no worker to run anything, deferred works are dropped.
+ */
+
+struct work;
+struct workqueue;
+typedef void (*work_fn)(struct work*);
+
+struct work
+{
+    work_fn fn;
+};
+
+struct delayed_work
+{
+    struct work work;
+};
+
+#define system_wq   ((struct workqueue*)0)
+
+static inline void
+delayed_work_init(struct delayed_work* dwork, work_fn fn)
+{
+    dwork->work.fn = fn;
+}
+
+#define to_delayed_work(work_ptr)   \
+    container_of(work_ptr, struct delayed_work, work)
+
+static inline bool
+queue_delayed_work(struct workqueue* wq, struct delayed_work* dwork, u32_t ms)
+{
+    return false;
+}
+
+#endif /* __STUB_LUNAIX_WORKQUEUE_H */
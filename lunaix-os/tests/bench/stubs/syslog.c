@@ -0,0 +1,21 @@
+#include <lunaix/syslog.h>
+
+/*
+    Kernel chatter would be interleaved with the results and, worse,
+    timed along with the code under measurement. Drop it.
+ */
+
+void
+kprintf_m(const char* component, const char* fmt, va_list args)
+{
+    (void)component;
+    (void)fmt;
+    (void)args;
+}
+
+void
+kprintf_v(const char* component, const char* fmt, ...)
+{
+    (void)component;
+    (void)fmt;
+}
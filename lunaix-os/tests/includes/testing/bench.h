@@ -0,0 +1,44 @@
+#ifndef __COMMON_TEST_BENCH_H
+#define __COMMON_TEST_BENCH_H
+
+#include <stdio.h>
+
+/*
+    A benchmark body runs the operation under test `iters` times. The
+    framework keeps doubling `iters` until a single run lasts long
+    enough to be measured reliably, the result is reported in ns/op.
+ */
+typedef void (*bench_fn)(unsigned long iters, void* arg);
+
+/**
+ * @brief Measure `fn`, and print a result line of
+ * "<name>\t<iterations>\t<ns/op>" to stdout.
+ *
+ * Skipped silently if filtered out from the command line.
+ */
+void
+bench_measure(const char* name, bench_fn fn, void* arg);
+
+/**
+ * @brief Whether `name` is selected by the command line, for the
+ * benchmarks that need costly setup.
+ */
+int
+bench_selected(const char* name);
+
+void 
+run_bench(int argc, const char* argv[]);
+
+/*
+    Prevent the compiler from optimising away the computation
+    of `val`.
+ */
+#define bench_keep(val)                                                     \
+    do {                                                                    \
+        __typeof__(val) __v = (val);                                        \
+        asm volatile("" : : "g"(__v) : "memory");                          \
+    } while (0)
+
+#define bench_clobber()     asm volatile("" : : : "memory")
+
+#endif /* __COMMON_TEST_BENCH_H */
@@ -0,0 +1,126 @@
+#include <testing/bench.h>
+#include <testing/memchk.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+    Defaults to 200ms per benchmark, BENCH_TIME_MS overrides it.
+ */
+#define DEFAULT_BENCH_NS    (200 * 1000 * 1000ULL)
+#define MAX_ITERS           (1UL << 40)
+
+struct valloc_stats valloc_stat = { };
+
+static unsigned long long bench_ns = DEFAULT_BENCH_NS;
+static const char** filters;
+static int nr_filters;
+
+/*
+    The stubbed valloc reports every allocation here. Unlike memchk.c,
+    no record is kept, as benchmarks allocate far more than the tests
+    do, and the memory is returned right away to keep long runs from
+    eating up the host.
+ */
+
+void
+memchk_log_alloc(unsigned long addr, unsigned long size)
+{
+    valloc_stat.alloced += size;
+    valloc_stat.nr_valloc_calls++;
+}
+
+void
+memchk_log_free(unsigned long addr)
+{
+    valloc_stat.nr_vfree_calls++;
+    free((void*)addr);
+}
+
+void
+memchk_print_stats()
+{
+    return;
+}
+
+static unsigned long long
+__now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int
+bench_selected(const char* name)
+{
+    if (!nr_filters) {
+        return 1;
+    }
+
+    for (int i = 0; i < nr_filters; i++)
+    {
+        if (strstr(name, filters[i])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void
+bench_measure(const char* name, bench_fn fn, void* arg)
+{
+    unsigned long long start, elapsed;
+    unsigned long iters = 1;
+
+    if (!bench_selected(name)) {
+        return;
+    }
+
+    // warm up the caches and whatever lazily initialised
+    fn(1, arg);
+
+    while (1)
+    {
+        start = __now_ns();
+        fn(iters, arg);
+        elapsed = __now_ns() - start;
+
+        if (elapsed >= bench_ns || iters >= MAX_ITERS) {
+            break;
+        }
+
+        // grow faster while far from the target
+        if (elapsed * 100 < bench_ns) {
+            iters *= 10;
+        } else {
+            iters *= 2;
+        }
+    }
+
+    printf("%s\t%lu\t%.2f\n", name, iters, (double)elapsed / iters);
+    fflush(stdout);
+}
+
+int
+main(int argc, const char* argv[])
+{
+    const char* time_ms;
+
+    time_ms = getenv("BENCH_TIME_MS");
+    if (time_ms) {
+        bench_ns = strtoull(time_ms, NULL, 10) * 1000 * 1000ULL;
+    }
+
+    filters = argv + 1;
+    nr_filters = argc - 1;
+
+    printf("# name\titerations\tns/op\n");
+
+    run_bench(argc, argv);
+
+    return 0;
+}
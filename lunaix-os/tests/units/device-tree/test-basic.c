@@ -156,6 +156,35 @@ testcase_child3(struct dt_context* ctx)
     end_testcase();
 }
 
+static void
+testcase_find_next(struct dt_context* ctx)
+{
+    struct dtn_iter it;
+    struct dtn_base* matched;
+    int i = 0;
+    const char *expected[] = {"child@1", "child@2", "child@3"};
+
+    begin_testcase("find-next");
+
+    dt_begin_find_byname(&it, ctx->root, "child");
+    expect_true(dt_found_any(&it));
+
+    while (dt_find_next(&it, &matched)) {
+        expect_notnull(matched);
+        if (i < 3) {
+            expect_str(HSTR_VAL(matched->mobj.name), expected[i]);
+        }
+        i++;
+    }
+
+    expect_int(i, 3);
+    expect_false(dt_find_next(&it, &matched));
+
+    dt_end_find(&it);
+
+    end_testcase();
+}
+
 void
 run_test(int argc, const char* argv[])
 {
@@ -172,4 +201,5 @@ run_test(int argc, const char* argv[])
     testcase_child1(ctx);
     testcase_child3(ctx);
     testcase_child2(ctx);
+    testcase_find_next(ctx);
 }
\ No newline at end of file
@@ -2,11 +2,10 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <sys/sendfile.h>
 
 #define BUFSIZE 4096
 
-static char buffer[BUFSIZE];
-
 int
 main(int argc, const char* argv[])
 {
@@ -32,12 +31,11 @@ main(int argc, const char* argv[])
         }
 
         do {
-            size = read(fd, buffer, BUFSIZE);
+            size = sendfile(stdout, fd, NULL, BUFSIZE);
             if (size < 0) {
                 printf("error while reading: %d\n", size);
                 break;
             }
-            write(stdout, buffer, size);
         } while (size == BUFSIZE);
 
         close(fd);
@@ -62,7 +62,7 @@ int
 main(int argc, const char** argv)
 {
     must_mount(NULL, "/dev", "devfs", 0);
-    must_mount(NULL, "/sys", "twifs", MNT_RO);
+    must_mount(NULL, "/sys", "twifs", 0);
     must_mount(NULL, "/task", "taskfs", MNT_RO);
 
     int fd = check(open("/dev/tty", 0));
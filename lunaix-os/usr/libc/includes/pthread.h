@@ -9,6 +9,30 @@ typedef struct {
     // TODO
 } pthread_attr_t;
 
+/*
+    0: unlocked, 1: locked, 2: locked and possibly contended
+ */
+typedef struct {
+    volatile unsigned int state;
+} pthread_mutex_t;
+
+typedef struct {
+    // TODO
+} pthread_mutexattr_t;
+
+typedef struct {
+    volatile unsigned int seq;
+    volatile unsigned int nwaiters;
+    pthread_mutex_t* mutex;
+} pthread_cond_t;
+
+typedef struct {
+    // TODO
+} pthread_condattr_t;
+
+#define PTHREAD_MUTEX_INITIALIZER   { 0 }
+#define PTHREAD_COND_INITIALIZER    { 0, 0, 0 }
+
 int 
 pthread_create(pthread_t* thread,
                 const pthread_attr_t* attr,
@@ -28,6 +52,35 @@ pthread_kill(pthread_t thread, int sig);
 
 pthread_t pthread_self(void);
 
+int
+pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr);
+
+int
+pthread_mutex_destroy(pthread_mutex_t* mutex);
+
+int
+pthread_mutex_lock(pthread_mutex_t* mutex);
+
+int
+pthread_mutex_trylock(pthread_mutex_t* mutex);
+
+int
+pthread_mutex_unlock(pthread_mutex_t* mutex);
+
+int
+pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr);
+
+int
+pthread_cond_destroy(pthread_cond_t* cond);
+
+int
+pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex);
+
+int
+pthread_cond_signal(pthread_cond_t* cond);
+
+int
+pthread_cond_broadcast(pthread_cond_t* cond);
 
 
 #endif /* __LUNALIBC_PTHREAD_H */
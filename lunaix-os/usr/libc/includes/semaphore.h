@@ -0,0 +1,27 @@
+#ifndef __LUNALIBC_SEMAPHORE_H
+#define __LUNALIBC_SEMAPHORE_H
+
+typedef struct {
+    volatile unsigned int value;
+    volatile unsigned int nwaiters;
+} sem_t;
+
+int
+sem_init(sem_t* sem, int pshared, unsigned int value);
+
+int
+sem_destroy(sem_t* sem);
+
+int
+sem_wait(sem_t* sem);
+
+int
+sem_trywait(sem_t* sem);
+
+int
+sem_post(sem_t* sem);
+
+int
+sem_getvalue(sem_t* sem, int* sval);
+
+#endif /* __LUNALIBC_SEMAPHORE_H */
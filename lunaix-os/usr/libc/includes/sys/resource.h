@@ -0,0 +1,10 @@
+#ifndef __LUNALIBC_SYS_RESOURCE_H
+#define __LUNALIBC_SYS_RESOURCE_H
+
+#include <lunaix/resource.h>
+
+int getrlimit(int resource, struct rlimit* rlim);
+
+int setrlimit(int resource, const struct rlimit* rlim);
+
+#endif /* __LUNALIBC_SYS_RESOURCE_H */
@@ -0,0 +1,8 @@
+#ifndef __LUNALIBC_SYS_SENDFILE_H
+#define __LUNALIBC_SYS_SENDFILE_H
+
+#include <sys/types.h>
+
+int sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+
+#endif /* __LUNALIBC_SYS_SENDFILE_H */
@@ -0,0 +1,11 @@
+#ifndef __LUNALIBC_SYS_UIO_H
+#define __LUNALIBC_SYS_UIO_H
+
+#include <lunaix/uio.h>
+#include <sys/types.h>
+
+int readv(int fd, const struct iovec* iov, int iovcnt);
+
+int writev(int fd, const struct iovec* iov, int iovcnt);
+
+#endif /* __LUNALIBC_SYS_UIO_H */
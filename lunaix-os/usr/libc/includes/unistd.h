@@ -50,6 +50,12 @@ read(int fd, void* buf, size_t size);
 extern int
 write(int fd, void* buf, size_t size);
 
+extern int
+pread(int fd, void* buf, size_t size, off_t offset);
+
+extern int
+pwrite(int fd, void* buf, size_t size, off_t offset);
+
 extern int
 readlink(const char* path, char* buffer, size_t size);
 
@@ -77,6 +83,12 @@ dup2(int oldfd, int newfd);
 extern int
 dup(int oldfd);
 
+extern int
+pipe(int fds[2]);
+
+extern int
+pipe2(int fds[2], int flags);
+
 extern int
 fsync(int fd);
 
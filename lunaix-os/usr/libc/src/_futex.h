@@ -0,0 +1,27 @@
+#ifndef __LUNAIX__FUTEX_H
+#define __LUNAIX__FUTEX_H
+
+#include <syscall.h>
+#include <lunaix/futex.h>
+
+static inline int
+__futex_wait(volatile unsigned int* uaddr, unsigned int val)
+{
+    return do_lunaix_syscall(__NR__lxsys_futex, uaddr, FUTEX_WAIT, val, 0, 0);
+}
+
+static inline int
+__futex_wake(volatile unsigned int* uaddr, unsigned int nr)
+{
+    return do_lunaix_syscall(__NR__lxsys_futex, uaddr, FUTEX_WAKE, nr, 0, 0);
+}
+
+static inline int
+__futex_requeue(volatile unsigned int* uaddr, unsigned int nr_wake,
+                volatile unsigned int* uaddr2, unsigned int nr_requeue)
+{
+    return do_lunaix_syscall(__NR__lxsys_futex, uaddr, FUTEX_REQUEUE, 
+                             nr_wake, nr_requeue, uaddr2);
+}
+
+#endif /* __LUNAIX__FUTEX_H */
@@ -0,0 +1,14 @@
+#include <syscall.h>
+#include <sys/resource.h>
+
+int
+getrlimit(int resource, struct rlimit* rlim)
+{
+    return do_lunaix_syscall(__NR__lxsys_getrlimit, resource, rlim);
+}
+
+int
+setrlimit(int resource, const struct rlimit* rlim)
+{
+    return do_lunaix_syscall(__NR__lxsys_setrlimit, resource, rlim);
+}
@@ -0,0 +1,21 @@
+#include <syscall.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+
+int
+readv(int fd, const struct iovec* iov, int iovcnt)
+{
+    return do_lunaix_syscall(__NR__lxsys_readv, fd, iov, iovcnt);
+}
+
+int
+writev(int fd, const struct iovec* iov, int iovcnt)
+{
+    return do_lunaix_syscall(__NR__lxsys_writev, fd, iov, iovcnt);
+}
+
+int
+sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    return do_lunaix_syscall(__NR__lxsys_sendfile, out_fd, in_fd, offset, count);
+}
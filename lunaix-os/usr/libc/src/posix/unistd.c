@@ -90,6 +90,18 @@ write(int fd, void* buf, size_t count)
     return do_lunaix_syscall(__NR__lxsys_write, fd, buf, count);
 }
 
+int
+pread(int fd, void* buf, size_t count, off_t offset)
+{
+    return do_lunaix_syscall(__NR__lxsys_pread, fd, buf, count, offset);
+}
+
+int
+pwrite(int fd, void* buf, size_t count, off_t offset)
+{
+    return do_lunaix_syscall(__NR__lxsys_pwrite, fd, buf, count, offset);
+}
+
 int
 readlink(const char* path, char* buf, size_t size)
 {
@@ -126,6 +138,18 @@ dup(int oldfd)
     return do_lunaix_syscall(__NR__lxsys_dup, oldfd);
 }
 
+int
+pipe2(int fds[2], int flags)
+{
+    return do_lunaix_syscall(__NR__lxsys_pipe2, fds, flags);
+}
+
+int
+pipe(int fds[2])
+{
+    return pipe2(fds, 0);
+}
+
 int
 fsync(int fildes)
 {
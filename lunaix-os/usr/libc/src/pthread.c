@@ -1,5 +1,8 @@
 #include <syscall.h>
 #include <pthread.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "_futex.h"
 
 int 
 pthread_create(pthread_t* thread,
@@ -48,3 +51,154 @@ pthread_self(void)
 {
     return do_lunaix_syscall(__NR__lxsys_th_self);
 }
+
+/*
+    Mutex and condition variable, the futex way. Only a contended
+    lock, or a signal with someone actually waiting, would ever
+    enter the kernel.
+ */
+
+#define MUTEX_UNLOCKED      0
+#define MUTEX_LOCKED        1
+#define MUTEX_CONTENDED     2
+
+static inline unsigned int
+__cmpxchg(volatile unsigned int* ptr, unsigned int old, unsigned int new)
+{
+    __atomic_compare_exchange_n(ptr, &old, new, 0, 
+                                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    return old;
+}
+
+int
+pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr)
+{
+    mutex->state = MUTEX_UNLOCKED;
+    return 0;
+}
+
+int
+pthread_mutex_destroy(pthread_mutex_t* mutex)
+{
+    return mutex->state != MUTEX_UNLOCKED ? EBUSY : 0;
+}
+
+static void
+__mutex_lock_contended(pthread_mutex_t* mutex)
+{
+    /*
+        Mark it contended whenever we are going to sleep, so the
+        one unlocking it knows there is someone to be waked.
+     */
+    while (__atomic_exchange_n(&mutex->state, MUTEX_CONTENDED, 
+                               __ATOMIC_ACQUIRE) != MUTEX_UNLOCKED)
+    {
+        __futex_wait(&mutex->state, MUTEX_CONTENDED);
+    }
+}
+
+int
+pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    if (__cmpxchg(&mutex->state, MUTEX_UNLOCKED, MUTEX_LOCKED) 
+            == MUTEX_UNLOCKED) 
+    {
+        return 0;
+    }
+
+    __mutex_lock_contended(mutex);
+    return 0;
+}
+
+int
+pthread_mutex_trylock(pthread_mutex_t* mutex)
+{
+    if (__cmpxchg(&mutex->state, MUTEX_UNLOCKED, MUTEX_LOCKED) 
+            == MUTEX_UNLOCKED) 
+    {
+        return 0;
+    }
+
+    return EBUSY;
+}
+
+int
+pthread_mutex_unlock(pthread_mutex_t* mutex)
+{
+    unsigned int prev;
+
+    prev = __atomic_exchange_n(&mutex->state, MUTEX_UNLOCKED, 
+                               __ATOMIC_RELEASE);
+    if (prev == MUTEX_CONTENDED) {
+        __futex_wake(&mutex->state, 1);
+    }
+
+    return 0;
+}
+
+int
+pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr)
+{
+    cond->seq = 0;
+    cond->nwaiters = 0;
+    cond->mutex = NULL;
+    return 0;
+}
+
+int
+pthread_cond_destroy(pthread_cond_t* cond)
+{
+    return cond->nwaiters ? EBUSY : 0;
+}
+
+int
+pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
+{
+    unsigned int seq;
+
+    cond->mutex = mutex;
+    __atomic_add_fetch(&cond->nwaiters, 1, __ATOMIC_SEQ_CST);
+    seq = __atomic_load_n(&cond->seq, __ATOMIC_ACQUIRE);
+
+    pthread_mutex_unlock(mutex);
+
+    // seq moved since we unlocked? then we just missed a signal.
+    __futex_wait(&cond->seq, seq);
+
+    __atomic_sub_fetch(&cond->nwaiters, 1, __ATOMIC_SEQ_CST);
+
+    // we may be requeued onto the mutex, behind other waiters.
+    __mutex_lock_contended(mutex);
+    return 0;
+}
+
+int
+pthread_cond_signal(pthread_cond_t* cond)
+{
+    __atomic_add_fetch(&cond->seq, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&cond->nwaiters, __ATOMIC_SEQ_CST)) {
+        __futex_wake(&cond->seq, 1);
+    }
+
+    return 0;
+}
+
+int
+pthread_cond_broadcast(pthread_cond_t* cond)
+{
+    __atomic_add_fetch(&cond->seq, 1, __ATOMIC_SEQ_CST);
+
+    if (!__atomic_load_n(&cond->nwaiters, __ATOMIC_SEQ_CST)) {
+        return 0;
+    }
+
+    /*
+        Waking them all would only make them fight for the mutex,
+        wake one and let the rest queue on the mutex directly. Mark
+        the mutex contended so its unlock will wake the requeued.
+     */
+    __cmpxchg(&cond->mutex->state, MUTEX_LOCKED, MUTEX_CONTENDED);
+    __futex_requeue(&cond->seq, 1, &cond->mutex->state, (unsigned int)-1);
+    return 0;
+}
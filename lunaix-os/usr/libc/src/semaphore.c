@@ -0,0 +1,72 @@
+#include <semaphore.h>
+#include <errno.h>
+#include "_futex.h"
+
+static inline int
+__sem_try_down(sem_t* sem)
+{
+    unsigned int val = __atomic_load_n(&sem->value, __ATOMIC_RELAXED);
+
+    while (val) {
+        if (__atomic_compare_exchange_n(&sem->value, &val, val - 1, 0, 
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int
+sem_init(sem_t* sem, int pshared, unsigned int value)
+{
+    // futex is keyed by physical address, thus pshared come for free.
+    sem->value = value;
+    sem->nwaiters = 0;
+    return 0;
+}
+
+int
+sem_destroy(sem_t* sem)
+{
+    return sem->nwaiters ? EBUSY : 0;
+}
+
+int
+sem_wait(sem_t* sem)
+{
+    while (!__sem_try_down(sem))
+    {
+        __atomic_add_fetch(&sem->nwaiters, 1, __ATOMIC_SEQ_CST);
+        __futex_wait(&sem->value, 0);
+        __atomic_sub_fetch(&sem->nwaiters, 1, __ATOMIC_SEQ_CST);
+    }
+
+    return 0;
+}
+
+int
+sem_trywait(sem_t* sem)
+{
+    return __sem_try_down(sem) ? 0 : EAGAIN;
+}
+
+int
+sem_post(sem_t* sem)
+{
+    __atomic_add_fetch(&sem->value, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&sem->nwaiters, __ATOMIC_SEQ_CST)) {
+        __futex_wake(&sem->value, 1);
+    }
+
+    return 0;
+}
+
+int
+sem_getvalue(sem_t* sem, int* sval)
+{
+    *sval = (int)__atomic_load_n(&sem->value, __ATOMIC_RELAXED);
+    return 0;
+}
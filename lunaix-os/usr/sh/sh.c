@@ -110,11 +110,47 @@ sigint_handle(int signum)
     return;
 }
 
+#define SH_MAX_STAGES 8
+
+static int prev_exit;
+
+static pid_t
+sh_spawn(const char** argv, int fd_in, int fd_out, int fd_unused)
+{
+    const char* envp[] = { 0 };
+    char buffer[1024];
+    strcpy(buffer, "/bin/");
+    strcpy(&buffer[5], argv[0]);
+
+    pid_t p;
+    if (!(p = fork())) {
+        if (fd_unused >= 0) {
+            close(fd_unused);
+        }
+
+        if (fd_in != stdin) {
+            dup2(fd_in, stdin);
+            close(fd_in);
+        }
+
+        if (fd_out != stdout) {
+            dup2(fd_out, stdout);
+            close(fd_out);
+        }
+
+        if (execve(buffer, argv, envp)) {
+            sh_printerr();
+        }
+        _exit(1);
+    }
+    setpgid(p, getpgid());
+
+    return p;
+}
+
 void
 sh_exec(const char** argv)
 {
-    static int prev_exit;
-    const char* envp[] = { 0 };
     char* name = argv[0];
     if (!strcmp(name, "cd")) {
         chdir(argv[1] ? argv[1] : ".");
@@ -127,20 +163,77 @@ sh_exec(const char** argv)
         return;
     }
 
-    char buffer[1024];
-    strcpy(buffer, "/bin/");
-    strcpy(&buffer[5], name);
-
-    pid_t p;
     int res;
-    if (!(p = fork())) {
-        if (execve(buffer, argv, envp)) {
+    pid_t p = sh_spawn(argv, stdin, stdout, -1);
+    waitpid(p, &res, 0);
+
+    prev_exit = WEXITSTATUS(res);
+}
+
+/*
+    Run `a | b | ...`, each stage is connected to the next one
+    through an anonymous pipe. Builtins are not supported here.
+*/
+void
+sh_exec_pipeline(char* line)
+{
+    char* stages[SH_MAX_STAGES];
+    char* argvs[SH_MAX_STAGES][3] = { 0 };
+    pid_t pids[SH_MAX_STAGES];
+    int n = 0, fd_in = stdin, fds[2], res = 0;
+
+    stages[n++] = line;
+    for (char* c = line; *c; c++) {
+        if (*c != '|') {
+            continue;
+        }
+
+        if (n == SH_MAX_STAGES) {
+            printf("Error: too many stages\n");
+            return;
+        }
+
+        *c = '\0';
+        stages[n++] = c + 1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (!parse_cmdline(stages[i], argvs[i])) {
+            printf("Error: empty stage in pipeline\n");
+            return;
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (i == n - 1) {
+            fds[0] = -1;
+            fds[1] = stdout;
+        } else if (pipe(fds)) {
             sh_printerr();
+            n = i;
+            break;
         }
-        _exit(1);
+
+        pids[i] = sh_spawn((const char**)argvs[i], fd_in, fds[1], fds[0]);
+
+        if (fd_in != stdin) {
+            close(fd_in);
+        }
+
+        if (fds[1] != stdout) {
+            close(fds[1]);
+        }
+
+        fd_in = fds[0];
+    }
+
+    if (fd_in >= 0 && fd_in != stdin) {
+        close(fd_in);
+    }
+
+    for (int i = 0; i < n; i++) {
+        waitpid(pids[i], &res, 0);
     }
-    setpgid(p, getpgid());
-    waitpid(p, &res, 0);
 
     prev_exit = WEXITSTATUS(res);
 }
@@ -193,6 +286,11 @@ sh_loop()
         buf[sz] = '\0';
         sanity_filter(buf);
 
+        if (strchr(buf, '|')) {
+            sh_exec_pipeline(buf);
+            continue;
+        }
+
         // currently, this shell only support single argument
         if (!parse_cmdline(buf, argv)) {
              continue;
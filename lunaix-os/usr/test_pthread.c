@@ -79,6 +79,24 @@ __inc_number(void* value)
     return NULL;
 }
 
+#define LOCKED_INC_ROUNDS   100000
+
+static pthread_mutex_t __counter_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void* 
+__inc_number_locked(void* value)
+{
+    for (int i = 0; i < LOCKED_INC_ROUNDS; i++)
+    {
+        pthread_mutex_lock(&__counter_lock);
+        __counter_shared++;
+        pthread_mutex_unlock(&__counter_lock);
+    }
+
+    printf("thread %d: exit\n", pthread_self());
+    return NULL;
+}
+
 static void* 
 __spawn_and_quit(void* value)
 {
@@ -160,6 +178,32 @@ pthread_test_shared_race(int param)
     printf("counter val: %ld\n", __counter_shared);
 }
 
+static void
+pthread_test_shared_locked(int param)
+{
+    int err;
+    pthread_t created[64];
+    void* v;
+
+    __counter_shared = 0;
+
+    for (int i = 0; i < param; i++)
+    {
+        err = pthread_create(&created[i], NULL, __inc_number_locked, NULL);
+        if (err) {
+            printf("unable to create thread: %d\n", err);
+        }
+    }
+
+    for (int i = 0; i < param; i++)
+    {
+        pthread_join(created[i], &v);
+    }
+
+    printf("counter val: %ld, expect: %d\n", 
+            __counter_shared, param * LOCKED_INC_ROUNDS);
+}
+
 static void
 pthread_test_quit(int param)
 {
@@ -196,6 +240,9 @@ int main()
     run_test(shared_race, "shared_race10", 10);
     run_test(shared_race, "shared_race40", 40);
 
+    run_test(shared_locked, "shared_locked10", 10);
+    run_test(shared_locked, "shared_locked40", 40);
+
     // TODO test pthread + signal
     printf("All test passed.\n");
 
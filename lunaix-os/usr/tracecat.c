@@ -0,0 +1,150 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <lunaix/tracepoint.h>
+
+#define TRACE_ROOT      "/sys/trace"
+#define MAX_EVENTS      64
+#define NAME_LEN        32
+#define NR_RECS         32
+
+static char names[MAX_EVENTS][NAME_LEN];
+static char list_buf[4096];
+static struct tracepoint_record recs[NR_RECS];
+
+static int
+load_names()
+{
+    int fd, len, id;
+    char *p, *name;
+
+    fd = open(TRACE_ROOT "/list", FO_RDONLY);
+    if (fd < 0) {
+        printf("tracepoints not available (error: %d)\n", errno);
+        return -1;
+    }
+
+    len = read(fd, list_buf, sizeof(list_buf) - 1);
+    close(fd);
+
+    if (len < 0) {
+        return -1;
+    }
+
+    list_buf[len] = '\0';
+
+    // each line is "<id> <name> <on>"
+    p = list_buf;
+    while (*p) {
+        id = 0;
+        while (*p >= '0' && *p <= '9') {
+            id = id * 10 + (*p++ - '0');
+        }
+
+        name = ++p;
+        while (*p && *p != ' ') {
+            p++;
+        }
+
+        len = p - name;
+        if (id < MAX_EVENTS) {
+            strncpy(names[id], name, len < NAME_LEN ? len : NAME_LEN - 1);
+        }
+
+        while (*p && *p++ != '\n');
+    }
+
+    return 0;
+}
+
+static int
+enable_event(const char* name, int on)
+{
+    char path[128];
+    int fd, err;
+
+    snprintf(path, sizeof(path), TRACE_ROOT "/events/%s", name);
+
+    fd = open(path, FO_WRONLY);
+    if (fd < 0) {
+        printf("no such event: %s\n", name);
+        return -1;
+    }
+
+    err = write(fd, on ? "1" : "0", 1);
+    close(fd);
+
+    return err < 0 ? err : 0;
+}
+
+static void
+print_record(struct tracepoint_record* rec)
+{
+    if (rec->id == TRACE_ID_LOST) {
+        printf("%u.%03u -- lost %u records --\n",
+               rec->time / 1000, rec->time % 1000, (unsigned int)rec->arg0);
+        return;
+    }
+
+    printf("%u.%03u cpu%d %d:%d %s cycles=%u 0x%x 0x%x\n",
+           rec->time / 1000, rec->time % 1000,
+           rec->cpu, rec->pid, rec->tid,
+           rec->id < MAX_EVENTS ? names[rec->id] : "?",
+           (unsigned int)rec->cycles,
+           (unsigned int)rec->arg0,
+           (unsigned int)rec->arg1);
+}
+
+int
+main(int argc, const char* argv[])
+{
+    int fd, len, follow = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-f")) {
+            follow = 1;
+            continue;
+        }
+
+        if (enable_event(argv[i], 1)) {
+            return 1;
+        }
+    }
+
+    if (load_names()) {
+        return 1;
+    }
+
+    fd = open(TRACE_ROOT "/buffer", FO_RDONLY);
+    if (fd < 0) {
+        printf("unable to open trace buffer (error: %d)\n", errno);
+        return 1;
+    }
+
+    while (1) {
+        len = read(fd, recs, sizeof(recs));
+        if (len < 0) {
+            printf("error while reading: %d\n", errno);
+            break;
+        }
+
+        for (int i = 0; i < len / (int)sizeof(recs[0]); i++) {
+            print_record(&recs[i]);
+        }
+
+        if (len) {
+            continue;
+        }
+
+        if (!follow) {
+            break;
+        }
+
+        sleep(1);
+    }
+
+    close(fd);
+    return 0;
+}